@@ -0,0 +1,155 @@
+#include "AudioWorkerPool.h"
+#include "RealtimeSafety.h"
+
+namespace
+{
+    // about a few hundred microseconds of spinning before a worker goes to sleep
+    const int spinsBeforeSleeping = 4000;
+
+    juce::uint32 generationOf (juce::uint64 state) noexcept { return (juce::uint32) (state >> 32); }
+}
+
+class AudioWorkerPool::Worker  : public juce::Thread
+{
+public:
+    explicit Worker (AudioWorkerPool& p) : juce::Thread ("Audio worker"), pool (p) {}
+
+    void run() override
+    {
+        // the denormal flags belong to the thread, so set them here as processBlock does
+        juce::ScopedNoDenormals noDenormals;
+        juce::uint32 lastSeen = 0;
+        int spins = 0;
+
+        while (! threadShouldExit())
+        {
+            if (pool.tryEnter(lastSeen))
+            {
+                {
+                    LLMEFFECTS_AUDIO_THREAD_SCOPE;
+                    pool.work();
+                }
+                pool.leave();
+                spins = 0;
+            }
+            else if (spins < spinsBeforeSleeping)
+            {
+                pause();
+                ++spins;
+            }
+            else
+            {
+                // run() checks this after publishing a job, so one of us sees the other
+                sleeping.store(true);
+                if (! pool.hasNewRun(lastSeen))
+                    wait(-1);
+                sleeping.store(false);
+                spins = 0;
+            }
+        }
+    }
+
+    std::atomic<bool> sleeping { false };
+
+private:
+    AudioWorkerPool& pool;
+};
+
+AudioWorkerPool::AudioWorkerPool (int numWorkers)
+{
+    for (int i = 0; i < numWorkers; ++i)
+    {
+        auto worker = std::make_unique<Worker>(*this);
+        // the workers run inside the audio deadline, so they get the audio thread's treatment
+        if (! worker->startRealtimeThread(juce::Thread::RealtimeOptions().withPriority(10)))
+            worker->startThread(juce::Thread::Priority::highest);
+        workers.push_back(std::move(worker));
+    }
+}
+
+AudioWorkerPool::~AudioWorkerPool()
+{
+    for (auto& worker : workers)
+    {
+        worker->signalThreadShouldExit();
+        worker->notify();
+    }
+    for (auto& worker : workers)
+        worker->stopThread(2000);
+}
+
+void AudioWorkerPool::run (Task newTask, void* newContext, int count) noexcept
+{
+    if (count <= 0)
+        return;
+
+    // Close the doors: wait for any worker that joined the last run late to find
+    // nothing left and leave, then make the generation odd so nobody else comes in.
+    auto open = (juce::uint64) generation << 32;
+    while (! state.compare_exchange_weak(open, open + (1ull << 32), std::memory_order_acquire))
+    {
+        open = (juce::uint64) generation << 32;
+        pause();
+    }
+
+    task.store(newTask, std::memory_order_relaxed);
+    context.store(newContext, std::memory_order_relaxed);
+    numTasks.store(count, std::memory_order_relaxed);
+    nextTask.store(0, std::memory_order_relaxed);
+    tasksDone.store(0, std::memory_order_relaxed);
+
+    generation += 2;
+    state.store((juce::uint64) generation << 32);
+
+    for (auto& worker : workers)
+    {
+        if (worker->sleeping.load())
+        {
+            LLMEFFECTS_ALLOW_BLOCKING;
+            worker->notify();
+        }
+    }
+
+    work();
+
+    // Every task has been claimed, so this only waits for the ones still running on
+    // workers; whoever ran which, the block's output is the same.
+    while (tasksDone.load(std::memory_order_acquire) < count)
+        pause();
+}
+
+bool AudioWorkerPool::tryEnter (juce::uint32& lastSeen) noexcept
+{
+    auto current = state.load(std::memory_order_acquire);
+    auto currentGeneration = generationOf(current);
+    if (currentGeneration == lastSeen || (currentGeneration & 1) != 0)
+        return false;
+    if (! state.compare_exchange_strong(current, current + 1, std::memory_order_acquire))
+        return false;
+    lastSeen = currentGeneration;
+    return true;
+}
+
+void AudioWorkerPool::leave() noexcept
+{
+    state.fetch_sub(1, std::memory_order_release);
+}
+
+bool AudioWorkerPool::hasNewRun (juce::uint32 lastSeen) const noexcept
+{
+    return generationOf(state.load()) != lastSeen;
+}
+
+void AudioWorkerPool::work() noexcept
+{
+    auto* runTask = task.load(std::memory_order_relaxed);
+    auto* runContext = context.load(std::memory_order_relaxed);
+    int count = numTasks.load(std::memory_order_relaxed);
+
+    for (int index = nextTask.fetch_add(1, std::memory_order_relaxed); index < count;
+         index = nextTask.fetch_add(1, std::memory_order_relaxed))
+    {
+        runTask(runContext, index);
+        tasksDone.fetch_add(1, std::memory_order_release);
+    }
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#if JUCE_INTEL
+ #if JUCE_MSVC
+  #include <intrin.h>
+ #else
+  #include <x86intrin.h>
+ #endif
+#endif
+
+// A few threads that help the audio thread through work it can split into independent
+// tasks, such as the channel groups of a wide layout. run() hands out task indices from
+// an atomic counter to the workers and the calling thread alike and returns once every
+// task has finished, so each task's output doesn't depend on which thread ran it, and a
+// late worker only means the caller does more of the tasks itself.
+//
+// run() doesn't allocate or lock. Workers spin for a little while after each run so the
+// next block usually finds them awake; one that has gone to sleep is woken with
+// Thread::notify(), which is the only call that can block.
+class AudioWorkerPool
+{
+public:
+    using Task = void (*) (void* context, int index);
+
+    // Starts the threads; not real-time safe.
+    explicit AudioWorkerPool (int numWorkers);
+    ~AudioWorkerPool();
+
+    int getNumWorkers() const noexcept { return (int) workers.size(); }
+
+    // Runs task (context, i) for every i in [0, numTasks). One caller at a time.
+    void run (Task task, void* context, int numTasks) noexcept;
+
+    template <typename Function>
+    void run (int numTasks, Function&& function) noexcept
+    {
+        using Callable = std::remove_reference_t<Function>;
+        run([] (void* context, int index) { (*static_cast<Callable*>(context))(index); },
+            const_cast<void*>(static_cast<const void*>(&function)), numTasks);
+    }
+
+private:
+    class Worker;
+    std::vector<std::unique_ptr<Worker>> workers;
+
+    // Generation in the top half, workers inside the current run in the bottom half.
+    // An odd generation means run() is filling in the next job, and nobody may enter.
+    std::atomic<juce::uint64> state { 0 };
+    juce::uint32 generation { 0 };   // run() only
+
+    // the job, written while the generation is odd
+    std::atomic<Task> task { nullptr };
+    std::atomic<void*> context { nullptr };
+    std::atomic<int> numTasks { 0 };
+    std::atomic<int> nextTask { 0 }, tasksDone { 0 };
+
+    // a worker joins a run it hasn't seen yet, and leaves once no tasks are left
+    bool tryEnter (juce::uint32& lastSeen) noexcept;
+    void leave() noexcept;
+    bool hasNewRun (juce::uint32 lastSeen) const noexcept;
+    void work() noexcept;
+
+    static void pause() noexcept
+    {
+       #if JUCE_INTEL
+        _mm_pause();
+       #elif JUCE_ARM && ! JUCE_MSVC
+        asm volatile ("yield");
+       #endif
+    }
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AudioWorkerPool)
+};
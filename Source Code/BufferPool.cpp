@@ -0,0 +1,160 @@
+#include "BufferPool.h"
+#include <cstring>
+#include <new>
+
+BufferPool::Buffer::Buffer (Buffer&& other) noexcept
+    : pool (other.pool), data (other.data), size (other.size)
+{
+    other.pool = nullptr;
+    other.data = nullptr;
+    other.size = 0;
+}
+
+BufferPool::Buffer& BufferPool::Buffer::operator= (Buffer&& other) noexcept
+{
+    if (this != &other)
+    {
+        release();
+        std::swap(pool, other.pool);
+        std::swap(data, other.data);
+        std::swap(size, other.size);
+    }
+    return *this;
+}
+
+BufferPool::Buffer::~Buffer()
+{
+    release();
+}
+
+void BufferPool::Buffer::release() noexcept
+{
+    if (data == nullptr)
+        return;
+
+    if (pool != nullptr)
+        pool->recycle(data, size);
+    else
+        freeAligned(data);
+
+    pool = nullptr;
+    data = nullptr;
+    size = 0;
+}
+
+BufferPool::~BufferPool()
+{
+    // every Buffer has to go before the pool it came from
+    jassert (stats.bytesInUse == 0);
+
+    for (auto& block : idle)
+        freeAligned(block.second);
+}
+
+BufferPool::Buffer BufferPool::allocate (size_t numBytes)
+{
+    auto size = roundUp(numBytes);
+    void* data = nullptr;
+
+    {
+        const juce::ScopedLock sl (lock);
+
+        // best fit among the idle blocks, as long as it doesn't waste more than it uses;
+        // its node is kept for when it comes back
+        auto it = idle.lower_bound(size);
+        if (it != idle.end() && it->first <= 2 * size)
+        {
+            if (spareNodes.size() == spareNodes.capacity())
+                spareNodes.reserve(2 * spareNodes.size() + 4);
+
+            size = it->first;
+            data = it->second;
+            stats.bytesIdle -= size;
+            stats.bytesInUse += size;
+            spareNodes.push_back(idle.extract(it));
+        }
+    }
+
+    if (data == nullptr)
+    {
+        // a new block, allocated outside the lock; the pool only counts it and makes a
+        // node for it once that has worked, and hands it back if the node can't be made
+        data = allocateAligned(size);
+        try
+        {
+            const juce::ScopedLock sl (lock);
+            if (spareNodes.size() == spareNodes.capacity())
+                spareNodes.reserve(2 * spareNodes.size() + 4);
+
+            spareNodes.push_back(idle.extract(idle.emplace(size, nullptr)));
+            stats.bytesInUse += size;
+        }
+        catch (...)
+        {
+            freeAligned(data);
+            throw;
+        }
+    }
+
+    std::memset(data, 0, size);
+    return Buffer (this, data, size);
+}
+
+BufferPool::Buffer BufferPool::allocateUnpooled (size_t numBytes)
+{
+    auto size = roundUp(numBytes);
+    auto* data = allocateAligned(size);
+    std::memset(data, 0, size);
+    return Buffer (nullptr, data, size);
+}
+
+BufferPool::Stats BufferPool::getStats() const
+{
+    const juce::ScopedLock sl (lock);
+    return stats;
+}
+
+void BufferPool::recycle (void* data, size_t numBytes) noexcept
+{
+    {
+        const juce::ScopedLock sl (lock);
+        stats.bytesInUse -= numBytes;
+
+        // the node allocate made for this buffer, so nothing here allocates or throws;
+        // one that isn't needed is simply freed
+        jassert (! spareNodes.empty());
+        if (! spareNodes.empty())
+        {
+            auto node = std::move(spareNodes.back());
+            spareNodes.pop_back();
+
+            if (stats.bytesIdle + numBytes <= maxIdleBytes)
+            {
+                node.key() = numBytes;
+                node.mapped() = data;
+                idle.insert(std::move(node));
+                stats.bytesIdle += numBytes;
+                return;
+            }
+        }
+    }
+
+    freeAligned(data);
+}
+
+size_t BufferPool::roundUp (size_t numBytes) noexcept
+{
+    // whole pages, so blocks of similar size can stand in for each other
+    const size_t granularity = 4096;
+    return juce::jmax(granularity, (numBytes + granularity - 1) / granularity * granularity);
+}
+
+void* BufferPool::allocateAligned (size_t numBytes)
+{
+    return ::operator new (numBytes, std::align_val_t (alignment));
+}
+
+void BufferPool::freeAligned (void* data) noexcept
+{
+    ::operator delete (data, std::align_val_t (alignment));
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <map>
+#include <vector>
+
+// Cache-line-aligned memory for delay lines and other large DSP buffers, shared by all
+// plugin instances in the process via juce::SharedResourcePointer. A buffer that is
+// released goes back into the pool instead of to the system, so an instance growing
+// or shutting down frees memory the next one can pick up, and a session full of
+// instances doesn't fragment the heap with megabyte-sized blocks.
+//
+// Allocation and release take a lock and may call the system allocator, so neither
+// belongs on the audio thread.
+class BufferPool
+{
+public:
+    static constexpr size_t alignment = 64;
+
+    // Owns one block of memory and hands it back to its pool (or frees it, if it came
+    // from allocateUnpooled) when destroyed. Move-only.
+    class Buffer
+    {
+    public:
+        Buffer() = default;
+        Buffer (Buffer&& other) noexcept;
+        Buffer& operator= (Buffer&& other) noexcept;
+        ~Buffer();
+
+        void* getData() const noexcept { return data; }
+        size_t getSize() const noexcept { return size; }
+
+    private:
+        friend class BufferPool;
+        Buffer (BufferPool* owner, void* memory, size_t numBytes) noexcept
+            : pool (owner), data (memory), size (numBytes) {}
+
+        void release() noexcept;
+
+        BufferPool* pool { nullptr };
+        void* data { nullptr };
+        size_t size { 0 };
+
+        JUCE_DECLARE_NON_COPYABLE (Buffer)
+    };
+
+    struct Stats
+    {
+        size_t bytesInUse { 0 };
+        size_t bytesIdle { 0 };
+    };
+
+    BufferPool() = default;
+    ~BufferPool();
+
+    // At least numBytes, zeroed and aligned to `alignment`.
+    Buffer allocate (size_t numBytes);
+    // Same, for code that isn't handed a pool; freed straight back to the system.
+    static Buffer allocateUnpooled (size_t numBytes);
+
+    Stats getStats() const;
+
+private:
+    void recycle (void* data, size_t numBytes) noexcept;
+
+    static size_t roundUp (size_t numBytes) noexcept;
+    static void* allocateAligned (size_t numBytes);
+    static void freeAligned (void* data) noexcept;
+
+    // idle memory past this goes back to the system rather than being kept around
+    static constexpr size_t maxIdleBytes = 64 * 1024 * 1024;
+
+    using IdleMap = std::multimap<size_t, void*>;
+
+    juce::CriticalSection lock;
+    IdleMap idle;                                // size -> block
+    // a map node for every buffer handed out, made by allocate, so that putting the
+    // buffer back never has to allocate one
+    std::vector<IdleMap::node_type> spareNodes;
+    Stats stats;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BufferPool)
+};
@@ -0,0 +1,84 @@
+#include "CaptureBuffer.h"
+
+void CaptureBuffer::prepare (double sampleRate, int numChannels, int samplesPerBlock, double seconds)
+{
+    const juce::ScopedLock sl (lock);
+    fs = sampleRate;
+    readable = juce::jmax(1, (int) (seconds * sampleRate));
+
+    // a second of headroom: a reader has that long to copy before the writer catches up
+    capacity = readable + juce::jmax(samplesPerBlock, (int) sampleRate);
+    ring.setSize(juce::jmax(1, numChannels), capacity);
+    ring.clear();
+    written.store(0);
+    largestBlock.store(juce::jmax(1, samplesPerBlock));
+}
+
+void CaptureBuffer::release()
+{
+    const juce::ScopedLock sl (lock);
+    ring.setSize(0, 0);
+    capacity = readable = 0;
+    written.store(0);
+}
+
+void CaptureBuffer::write (const juce::AudioBuffer<float>& buffer, int numChannels, int numSamples) noexcept
+{
+    if (capacity == 0 || numSamples <= 0)
+        return;
+
+    if (numSamples > largestBlock.load(std::memory_order_relaxed))
+        largestBlock.store(numSamples, std::memory_order_relaxed);
+
+    numChannels = juce::jmin(numChannels, ring.getNumChannels());
+    auto start = written.load(std::memory_order_relaxed);
+
+    // a block longer than the ring only leaves its end behind
+    int source = juce::jmax(0, numSamples - capacity);
+    int position = (int) ((start + source) % capacity);
+    while (source < numSamples)
+    {
+        int chunk = juce::jmin(numSamples - source, capacity - position);
+        for (int channel = 0; channel < numChannels; ++channel)
+            ring.copyFrom(channel, position, buffer, channel, source, chunk);
+        position = (position + chunk) % capacity;
+        source += chunk;
+    }
+
+    written.store(start + numSamples, std::memory_order_release);
+}
+
+int CaptureBuffer::readLatest (juce::AudioBuffer<float>& dest, double seconds) const
+{
+    const juce::ScopedLock sl (lock);
+    auto end = written.load(std::memory_order_acquire);
+    int count = (int) juce::jmin<juce::int64>(end, juce::jmin(readable, (int) (seconds * fs)));
+    dest.setSize(ring.getNumChannels(), juce::jmax(0, count), false, false, true);
+    if (count <= 0 || capacity == 0)
+        return 0;
+
+    auto first = end - count;
+    int position = (int) (first % capacity);
+    for (int copied = 0; copied < count;)
+    {
+        int chunk = juce::jmin(count - copied, capacity - position);
+        for (int channel = 0; channel < ring.getNumChannels(); ++channel)
+            dest.copyFrom(channel, copied, ring, channel, position, chunk);
+        position = (position + chunk) % capacity;
+        copied += chunk;
+    }
+
+    // Anything the writer has reached since, plus the block it may be in the middle
+    // of, could have been overwritten under us. That's only ever the oldest samples.
+    auto intactFrom = written.load(std::memory_order_acquire) + largestBlock.load(std::memory_order_relaxed) - capacity;
+    int torn = (int) juce::jlimit<juce::int64>(0, count, intactFrom - first);
+    if (torn > 0)
+    {
+        count -= torn;
+        for (int channel = 0; channel < dest.getNumChannels(); ++channel)
+            std::memmove(dest.getWritePointer(channel), dest.getReadPointer(channel, torn), sizeof(float) * (size_t) count);
+        dest.setSize(dest.getNumChannels(), count, true, false, true);
+    }
+
+    return count;
+}
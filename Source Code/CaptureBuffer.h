@@ -0,0 +1,36 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+
+// The last few seconds of the plugin's input, kept so LLM suggestions can be previewed
+// against what is actually playing. The audio thread writes into a ring without locks
+// or allocation and publishes how far it has got; readers copy out the most recent
+// audio and drop whatever the writer overwrote while they were copying.
+class CaptureBuffer
+{
+public:
+    CaptureBuffer() = default;
+
+    // Allocates a ring that can hand out `seconds` of audio; not while write() may run.
+    void prepare (double sampleRate, int numChannels, int samplesPerBlock, double seconds);
+    void release();
+
+    // Audio thread: appends the first numSamples of the buffer's first channels.
+    void write (const juce::AudioBuffer<float>& buffer, int numChannels, int numSamples) noexcept;
+
+    // Any thread but the audio thread. Copies up to `seconds` of the latest input into
+    // dest, resized to what was available, and returns its length in samples.
+    int readLatest (juce::AudioBuffer<float>& dest, double seconds) const;
+
+private:
+    mutable juce::CriticalSection lock;   // prepare/release against readers only
+    juce::AudioBuffer<float> ring;
+    double fs { 44100.0 };
+    int capacity { 0 };
+    int readable { 0 };   // the rest is headroom for the writer while a reader copies
+    std::atomic<juce::int64> written { 0 };
+    std::atomic<int> largestBlock { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CaptureBuffer)
+};
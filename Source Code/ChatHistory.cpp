@@ -0,0 +1,85 @@
+#include "ChatHistory.h"
+
+void ChatHistory::add (Role role, const juce::String& text)
+{
+    const juce::ScopedLock sl (lock);
+    messages.push_back({ role, text });
+    if ((int) messages.size() > maxMessages)
+        messages.erase(messages.begin(), messages.begin() + ((int) messages.size() - maxMessages));
+
+    if (role == Role::assistant || role == Role::local)
+        lastExplanation = text;
+}
+
+void ChatHistory::clear()
+{
+    {
+        const juce::ScopedLock sl (lock);
+        messages.clear();
+        lastExplanation.clear();
+    }
+    sendChangeMessage();
+}
+
+std::vector<ChatHistory::Message> ChatHistory::getMessages() const
+{
+    const juce::ScopedLock sl (lock);
+    return messages;
+}
+
+juce::String ChatHistory::getLastExplanation() const
+{
+    const juce::ScopedLock sl (lock);
+    return lastExplanation;
+}
+
+juce::String ChatHistory::format (const Message& message)
+{
+    switch (message.role)
+    {
+        case Role::user:      return "You: " + message.text;
+        case Role::assistant: return "LLM Explanation: " + message.text;
+        case Role::local:     return "Local: " + message.text;
+        case Role::notice:    break;
+    }
+    return message.text;
+}
+
+void ChatHistory::writeTo (juce::OutputStream& stream) const
+{
+    const juce::ScopedLock sl (lock);
+    stream.writeCompressedInt((int) messages.size());
+    for (auto& message : messages)
+    {
+        stream.writeByte((char) message.role);
+        stream.writeString(message.text);
+    }
+    stream.writeString(lastExplanation);
+}
+
+bool ChatHistory::readFrom (juce::InputStream& stream)
+{
+    int count = stream.readCompressedInt();
+    if (count < 0 || count > maxMessages)
+        return false;
+
+    std::vector<Message> loaded;
+    loaded.reserve((size_t) count);
+    for (int i = 0; i < count; ++i)
+    {
+        auto role = (int) stream.readByte();
+        auto text = stream.readString();
+        if (stream.isExhausted() || role < (int) Role::user || role > (int) Role::notice)
+            return false;
+        loaded.push_back({ (Role) role, text });
+    }
+    auto explanation = stream.readString();
+
+    {
+        const juce::ScopedLock sl (lock);
+        messages = std::move(loaded);
+        lastExplanation = explanation;
+    }
+    sendChangeMessage();
+    return true;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <vector>
+
+// The conversation shown in the editor, kept by the processor so it is saved with the
+// session and survives the editor being closed. Each line of the transcript is one
+// message with a role, so it can be rendered and serialised without parsing text.
+// Thread-safe; listeners hear about wholesale replacements (loading a session), not
+// about single messages, which the editor adds itself.
+class ChatHistory  : public juce::ChangeBroadcaster
+{
+public:
+    enum class Role
+    {
+        user,
+        assistant,   // LLM explanation
+        local,       // offline resolver explanation
+        notice       // errors and status lines
+    };
+
+    struct Message
+    {
+        Role role;
+        juce::String text;
+    };
+
+    // oldest messages are dropped past this, so the saved state stays small
+    static constexpr int maxMessages = 200;
+
+    ChatHistory() = default;
+
+    void add (Role role, const juce::String& text);
+    void clear();
+
+    std::vector<Message> getMessages() const;
+    // Latest assistant or local explanation, or empty.
+    juce::String getLastExplanation() const;
+
+    // Transcript line as shown in the chat box, e.g. "You: more air".
+    static juce::String format (const Message& message);
+
+    void writeTo (juce::OutputStream& stream) const;
+    // Replaces the history with what was written by writeTo. Returns false, leaving the
+    // history alone, if the data doesn't parse.
+    bool readFrom (juce::InputStream& stream);
+
+private:
+    mutable juce::CriticalSection lock;
+    std::vector<Message> messages;
+    juce::String lastExplanation;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ChatHistory)
+};
@@ -0,0 +1,199 @@
+#include "Conversation.h"
+
+namespace
+{
+    const char* const summaryIntro = "Earlier in this conversation, oldest first: ";
+
+    // three decimals is finer than any knob, and keeps "0.3" from going out as 0.30000001
+    double rounded (float value)
+    {
+        return std::round((double) value * 1000.0) / 1000.0;
+    }
+
+    juce::String formatValue (float value)
+    {
+        return juce::String(rounded(value), 3).trimCharactersAtEnd("0").trimCharactersAtEnd(".");
+    }
+}
+
+std::vector<std::pair<int, float>> Conversation::diff (const ReverbParameters& before, const ReverbParameters& after)
+{
+    std::vector<std::pair<int, float>> changes;
+    for (int i = 0; i < ReverbParameters::numParameters; ++i)
+    {
+        auto& info = ReverbParameters::getInfo(i);
+        if (std::abs(after[i] - before[i]) > 1.0e-4f * (info.maxValue - info.minValue))
+            changes.push_back({ i, after[i] });
+    }
+    return changes;
+}
+
+void Conversation::Turn::serialise()
+{
+    juce::DynamicObject::Ptr changed = new juce::DynamicObject();
+    juce::StringArray changeList;
+    for (auto& [index, value] : changes)
+    {
+        auto* id = ReverbParameters::getInfo(index).id;
+        changed->setProperty(id, rounded(value));
+        changeList.add(juce::String(id) + " " + formatValue(value));
+    }
+
+    juce::DynamicObject::Ptr answer = new juce::DynamicObject();
+    answer->setProperty("changes", juce::var(changed.get()));
+    answer->setProperty("explanation", explanation);
+
+    messages.clear();
+    messages << ",{\"role\": \"user\", \"content\": " << juce::JSON::toString(prompt) << "}"
+             << ",{\"role\": \"assistant\", \"content\": " << juce::JSON::toString(juce::JSON::toString(juce::var(answer.get()), true)) << "}";
+
+    summary = "\"" + (prompt.length() > 80 ? prompt.substring(0, 77) + "..." : prompt) + "\" -> "
+            + (changeList.isEmpty() ? juce::String("no change") : changeList.joinIntoString(", "));
+    tokens = estimateTokens(messages);
+}
+
+void Conversation::addTurn (const juce::String& prompt, const ReverbParameters& before,
+                            const ReverbParameters& after, const juce::String& explanation)
+{
+    Turn turn;
+    turn.prompt = prompt;
+    turn.changes = diff(before, after);
+    turn.explanation = explanation;
+    turn.before = before;
+    turn.amendable = true;
+    turn.serialise();
+
+    const juce::ScopedLock sl (lock);
+    turns.push_back(std::move(turn));
+    if ((int) turns.size() > maxTurns)
+        turns.erase(turns.begin(), turns.begin() + ((int) turns.size() - maxTurns));
+}
+
+void Conversation::amendLastTurn (const ReverbParameters& after, const juce::String& explanation)
+{
+    const juce::ScopedLock sl (lock);
+    if (turns.empty() || ! turns.back().amendable)
+        return;
+
+    auto& turn = turns.back();
+    turn.changes = diff(turn.before, after);
+    turn.explanation = explanation;
+    turn.serialise();
+}
+
+void Conversation::clear()
+{
+    const juce::ScopedLock sl (lock);
+    turns.clear();
+}
+
+int Conversation::getNumTurns() const
+{
+    const juce::ScopedLock sl (lock);
+    return (int) turns.size();
+}
+
+juce::String Conversation::getLastTurn() const
+{
+    const juce::ScopedLock sl (lock);
+    return turns.empty() ? juce::String() : turns.back().messages;
+}
+
+int Conversation::writeHistory (juce::OutputStream& out, int tokenBudget) const
+{
+    const juce::ScopedLock sl (lock);
+    if (tokenBudget <= 0 || turns.empty())
+        return 0;
+
+    auto countVerbatim = [this](int budget, int& used)
+    {
+        int count = 0;
+        used = 0;
+        for (auto turn = turns.rbegin(); turn != turns.rend() && used + turn->tokens <= budget; ++turn, ++count)
+            used += turn->tokens;
+        return count;
+    };
+
+    int used = 0;
+    int numVerbatim = countVerbatim(tokenBudget, used);
+
+    if (numVerbatim < (int) turns.size())
+    {
+        int summaryBudget = tokenBudget / 4;
+        numVerbatim = countVerbatim(tokenBudget - summaryBudget, used);
+
+        // newest of the older turns first, so it's the oldest that don't make it
+        juce::StringArray lines;
+        int summaryTokens = estimateTokens(summaryIntro) + 10;
+        for (int i = (int) turns.size() - numVerbatim - 1; i >= 0; --i)
+        {
+            int cost = estimateTokens(turns[(size_t) i].summary) + 1;
+            if (summaryTokens + cost > summaryBudget)
+                break;
+            lines.insert(0, turns[(size_t) i].summary);
+            summaryTokens += cost;
+        }
+
+        if (! lines.isEmpty())
+        {
+            out << ",{\"role\": \"system\", \"content\": " << juce::JSON::toString(summaryIntro + lines.joinIntoString("; ")) << "}";
+            used += summaryTokens;
+        }
+    }
+
+    for (auto i = turns.size() - (size_t) numVerbatim; i < turns.size(); ++i)
+        out << turns[i].messages;
+
+    return used;
+}
+
+void Conversation::writeTo (juce::OutputStream& stream) const
+{
+    const juce::ScopedLock sl (lock);
+    stream.writeCompressedInt((int) turns.size());
+    for (auto& turn : turns)
+    {
+        stream.writeString(turn.prompt);
+        stream.writeString(turn.explanation);
+        stream.writeCompressedInt((int) turn.changes.size());
+        for (auto& [index, value] : turn.changes)
+        {
+            stream.writeString(ReverbParameters::getInfo(index).id);
+            stream.writeFloat(value);
+        }
+    }
+}
+
+bool Conversation::readFrom (juce::InputStream& stream)
+{
+    int count = stream.readCompressedInt();
+    if (count < 0 || count > maxTurns)
+        return false;
+
+    std::vector<Turn> loaded ((size_t) count);
+    for (auto& turn : loaded)
+    {
+        turn.prompt = stream.readString();
+        turn.explanation = stream.readString();
+        int numChanges = stream.readCompressedInt();
+        if (numChanges < 0 || numChanges > 1000)
+            return false;
+
+        // parameters this build doesn't know are skipped
+        for (int i = 0; i < numChanges; ++i)
+        {
+            auto id = stream.readString();
+            float value = stream.readFloat();
+            int index = ReverbParameters::indexOf(id);
+            if (index >= 0)
+                turn.changes.push_back({ index, value });
+        }
+        if (stream.isExhausted() && &turn != &loaded.back())
+            return false;
+        turn.serialise();
+    }
+
+    const juce::ScopedLock sl (lock);
+    turns = std::move(loaded);
+    return true;
+}
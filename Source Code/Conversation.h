@@ -0,0 +1,79 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <utility>
+#include <vector>
+#include "ReverbParameters.h"
+
+// The structured side of the chat, sent with each request so follow-ups such as "a bit
+// less" have something to refer to. A turn is the prompt, the parameters the answer
+// changed and its explanation. Past answers go out as those changes rather than full
+// snapshots, since the request carries the current parameters anyway.
+//
+// Requests have a token budget. The newest turns go in verbatim for as long as they
+// fit; if some don't, a quarter of the budget goes to a one-line-per-turn summary of
+// the ones before, and anything older still is dropped. Every turn is serialised once,
+// when it is added, so building a request only copies finished fragments.
+//
+// Kept by the processor so it is saved with the session. Thread-safe.
+class Conversation
+{
+public:
+    // oldest turns are dropped past this, so the saved state stays small
+    static constexpr int maxTurns = 100;
+
+    Conversation() = default;
+
+    // Records what a prompt did: the changes are worked out from the parameters before
+    // and after the answer was applied.
+    void addTurn (const juce::String& prompt, const ReverbParameters& before,
+                  const ReverbParameters& after, const juce::String& explanation);
+    // A different answer to the latest prompt was picked after all. Ignored if the
+    // turns were replaced since, e.g. by a session load, which doesn't bring back the
+    // parameters the changes were worked out from.
+    void amendLastTurn (const ReverbParameters& after, const juce::String& explanation);
+    void clear();
+    int getNumTurns() const;
+
+    // Writes the history as chat messages for a request, each preceded by a comma so
+    // they can follow the system message, and returns roughly how many tokens that was.
+    int writeHistory (juce::OutputStream& out, int tokenBudget) const;
+
+    // About four characters per token for English and JSON, which is close enough to
+    // keep a request in budget without shipping a tokenizer.
+    static int estimateTokens (const juce::String& text) noexcept { return (text.length() + 3) / 4; }
+
+    // The latest turn as it goes out in a request, or nothing before the first. Enough
+    // context to tell "more" after one answer from "more" after another, without tying
+    // a cached answer to the whole history.
+    juce::String getLastTurn() const;
+
+    void writeTo (juce::OutputStream& stream) const;
+    // Replaces the turns with what was written by writeTo. Returns false, leaving them
+    // alone, if the data doesn't parse.
+    bool readFrom (juce::InputStream& stream);
+
+private:
+    struct Turn
+    {
+        juce::String prompt;
+        std::vector<std::pair<int, float>> changes;   // parameter index, new value
+        juce::String explanation;
+        ReverbParameters before;                      // not saved; only the latest turn is ever amended
+        bool amendable { false };                     // has `before`, i.e. added rather than loaded
+
+        // built by serialise()
+        juce::String messages;   // the user message and the answer, as JSON array elements
+        juce::String summary;    // its line in the summary of older turns
+        int tokens { 0 };
+
+        void serialise();
+    };
+
+    static std::vector<std::pair<int, float>> diff (const ReverbParameters& before, const ReverbParameters& after);
+
+    mutable juce::CriticalSection lock;
+    std::vector<Turn> turns;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Conversation)
+};
@@ -0,0 +1,582 @@
+#include "ConvolutionReverb.h"
+#include "RealtimeSafety.h"
+
+namespace
+{
+    constexpr int headFFTOrder = 8;    // 2 * headBlock
+    constexpr int tailFFTOrder = 12;   // 2 * tailBlock
+    constexpr int renderBlockSize = 512;
+
+    // acc += x * h over interleaved complex bins
+    void multiplyAccumulate (float* acc, const float* x, const float* h, int numBins) noexcept
+    {
+        for (int i = 0; i < numBins; ++i)
+        {
+            float xr = x[2 * i], xi = x[2 * i + 1];
+            float hr = h[2 * i], hi = h[2 * i + 1];
+            acc[2 * i]     += xr * hr - xi * hi;
+            acc[2 * i + 1] += xr * hi + xi * hr;
+        }
+    }
+
+    // Sums every partition of the kernel against the matching slot of the input history,
+    // newest input with the first partition.
+    void accumulatePartitions (float* acc, const std::vector<float>& history, int newestSlot, int numSlots,
+                               const std::vector<float>& kernel, int numPartitions, int spectrumSize) noexcept
+    {
+        std::fill(acc, acc + spectrumSize, 0.0f);
+        for (int p = 0; p < numPartitions; ++p)
+        {
+            int slot = (newestSlot - p + numSlots) % numSlots;
+            multiplyAccumulate(acc, history.data() + slot * spectrumSize, kernel.data() + p * spectrumSize, spectrumSize / 2);
+        }
+    }
+}
+
+ConvolutionReverb::ConvolutionReverb()
+    : headFFT (headFFTOrder),
+      tailFFT (tailFFTOrder),
+      builderHeadFFT (headFFTOrder),
+      builderTailFFT (tailFFTOrder)
+{
+    for (auto& value : requestedParameters)
+        value.store(0.0f);
+
+    tailThread    = std::make_unique<WorkerThread>("Convolution tail", *this, &ConvolutionReverb::runTailWorker);
+    builderThread = std::make_unique<WorkerThread>("Convolution IR builder", *this, &ConvolutionReverb::runBuilder);
+}
+
+ConvolutionReverb::~ConvolutionReverb()
+{
+    stopThreads();
+    deleteAllKernels();
+}
+
+void ConvolutionReverb::prepare (double sampleRate)
+{
+    stopThreads();
+    deleteAllKernels();
+
+    fs = sampleRate;
+    int maxIRSamples = static_cast<int>(maxIRSeconds * fs);
+    maxTailPartitions = juce::jmax(1, (maxIRSamples - headLength + tailBlock - 1) / tailBlock);
+
+    // JUCE's real-only transforms want 2 * fftSize floats of room
+    headFFTBuffer.assign(4 * headBlock, 0.0f);
+    headPreviousBuffer.assign(4 * headBlock, 0.0f);
+    headAccumulator.assign(headSpectrumSize, 0.0f);
+    tailFFTBuffer.assign(4 * tailBlock, 0.0f);
+    tailAccumulator.assign(tailSpectrumSize, 0.0f);
+
+    for (int ch = 0; ch < 2; ++ch)
+    {
+        headWindow[(size_t) ch].assign(2 * headBlock, 0.0f);
+        headHistory[(size_t) ch].assign((size_t) (numHeadPartitions * headSpectrumSize), 0.0f);
+        outputRing[(size_t) ch].assign(outputRingSize, 0.0f);
+        tailInput[(size_t) ch].assign(tailBlock, 0.0f);
+        tailHistory[(size_t) ch].assign((size_t) maxTailPartitions * tailSpectrumSize, 0.0f);
+        tailPrevious[(size_t) ch].assign(tailBlock, 0.0f);
+
+        for (auto& job : jobs)
+        {
+            job.input[(size_t) ch].assign(tailBlock, 0.0f);
+            job.output[(size_t) ch].assign(tailBlock, 0.0f);
+            job.previousOutput[(size_t) ch].assign(tailBlock, 0.0f);
+        }
+    }
+
+    for (auto& job : jobs)
+        job.state.store(idle);
+
+    headHistoryPos = 0;
+    headFill = 0;
+    tailHistoryPos = 0;
+    time = 0;
+    lastPostedJob = 1;
+    jobSequence = workerSequence = 0;
+    epoch = workerEpoch = 0;
+    fading = false;
+    hasRequested = false;
+    tailOverruns.store(0);
+
+    irSource.prepare(fs, renderBlockSize);
+
+    tailThread->startThread(juce::Thread::Priority::high);
+    builderThread->startThread(juce::Thread::Priority::low);
+}
+
+void ConvolutionReverb::reset() noexcept
+{
+    for (int ch = 0; ch < 2; ++ch)
+    {
+        std::fill(headWindow[(size_t) ch].begin(), headWindow[(size_t) ch].end(), 0.0f);
+        std::fill(headHistory[(size_t) ch].begin(), headHistory[(size_t) ch].end(), 0.0f);
+        std::fill(outputRing[(size_t) ch].begin(), outputRing[(size_t) ch].end(), 0.0f);
+        std::fill(tailInput[(size_t) ch].begin(), tailInput[(size_t) ch].end(), 0.0f);
+    }
+    headFill = 0;
+
+    // jobs already in flight belong to the old signal; the worker clears its own
+    // history when it sees the new epoch
+    ++epoch;
+}
+
+void ConvolutionReverb::setParameters (const ReverbParameters& parameters) noexcept
+{
+    auto shaping = parameters;
+    shaping.eqLow = shaping.eqMid = shaping.eqHigh = 0.0f;
+    shaping.eqLowFrequency = ReverbParameters().eqLowFrequency;
+    shaping.eqHighFrequency = ReverbParameters().eqHighFrequency;
+    shaping.wetDryMix = 1.0f;
+
+    if (hasRequested && shaping == lastRequested)
+        return;
+
+    lastRequested = shaping;
+    hasRequested = true;
+    for (int i = 0; i < ReverbParameters::numParameters; ++i)
+        requestedParameters[(size_t) i].store(shaping[i], std::memory_order_relaxed);
+    requestSequence.fetch_add(1, std::memory_order_release);
+}
+
+void ConvolutionReverb::process (const float* inL, const float* inR, float* wetL, float* wetR, int numSamples) noexcept
+{
+    const float* inputs[2] = { inL, inR };
+    float* outputs[2] = { wetL, wetR };
+
+    for (int n = 0; n < numSamples; ++n)
+    {
+        int ringIndex = static_cast<int>((time - headBlock) & (outputRingSize - 1));
+        int tailIndex = static_cast<int>(time & (tailBlock - 1));
+
+        for (int ch = 0; ch < 2; ++ch)
+        {
+            float x = inputs[ch][n];
+            headWindow[(size_t) ch][(size_t) (headBlock + headFill)] = x;
+            tailInput[(size_t) ch][(size_t) tailIndex] = x;
+
+            auto& ring = outputRing[(size_t) ch];
+            outputs[ch][n] = ring[(size_t) ringIndex];
+            ring[(size_t) ringIndex] = 0.0f;
+        }
+        ++time;
+
+        if (++headFill == headBlock)
+        {
+            processHeadBlock();
+            headFill = 0;
+
+            if ((time & (tailBlock - 1)) == 0)
+                processTailBoundary();
+        }
+    }
+}
+
+void ConvolutionReverb::processHeadBlock() noexcept
+{
+    // nothing to fade from: the first IR goes straight in, rather than waiting for a
+    // tail boundary and fading up from silence
+    if (current == nullptr && previous == nullptr)
+        current = mailbox.exchange(nullptr, std::memory_order_acquire);
+
+    // output for [time - headBlock, time), read back headBlock samples from now
+    juce::int64 blockStart = time - headBlock;
+
+    for (int ch = 0; ch < 2; ++ch)
+    {
+        auto& window = headWindow[(size_t) ch];
+        auto& history = headHistory[(size_t) ch];
+
+        std::copy(window.begin(), window.end(), headFFTBuffer.begin());
+        headFFT.performRealOnlyForwardTransform(headFFTBuffer.data(), true);
+        std::copy(headFFTBuffer.begin(), headFFTBuffer.begin() + headSpectrumSize,
+                  history.begin() + headHistoryPos * headSpectrumSize);
+
+        // overlap-save: JUCE's inverse is already scaled by 1/N, and the second half of
+        // the result is the part that isn't wrapped around
+        auto render = [&](const Kernel* kernel, std::vector<float>& buffer)
+        {
+            if (kernel == nullptr)
+            {
+                std::fill(buffer.begin(), buffer.end(), 0.0f);
+                return;
+            }
+            accumulatePartitions(headAccumulator.data(), history, headHistoryPos, numHeadPartitions,
+                                 kernel->head[(size_t) ch], numHeadPartitions, headSpectrumSize);
+            std::copy(headAccumulator.begin(), headAccumulator.end(), buffer.begin());
+            headFFT.performRealOnlyInverseTransform(buffer.data());
+        };
+
+        render(current, headFFTBuffer);
+        const float* out = headFFTBuffer.data() + headBlock;
+        auto& ring = outputRing[(size_t) ch];
+
+        if (fading)
+        {
+            render(previous, headPreviousBuffer);
+            const float* old = headPreviousBuffer.data() + headBlock;
+            for (int i = 0; i < headBlock; ++i)
+            {
+                float g = juce::jlimit(0.0f, 1.0f, (float) (blockStart + i - fadeStart) / (float) tailBlock);
+                ring[(size_t) ((blockStart + i) & (outputRingSize - 1))] += old[i] + g * (out[i] - old[i]);
+            }
+        }
+        else
+        {
+            for (int i = 0; i < headBlock; ++i)
+                ring[(size_t) ((blockStart + i) & (outputRingSize - 1))] += out[i];
+        }
+
+        std::copy(window.begin() + headBlock, window.end(), window.begin());
+    }
+
+    headHistoryPos = (headHistoryPos + 1) % numHeadPartitions;
+}
+
+void ConvolutionReverb::processTailBoundary() noexcept
+{
+    // The job posted one tail block ago covers output [time, time + tailBlock). If the
+    // worker hasn't finished it, that block of tail is lost.
+    auto& collected = jobs[(size_t) lastPostedJob];
+    int state = collected.state.load(std::memory_order_acquire);
+    while (waitForTail && (state == posted || state == running))
+    {
+        juce::Thread::yield();
+        state = collected.state.load(std::memory_order_acquire);
+    }
+    if (state == done)
+    {
+        // a job that finished late, or before a reset, is stale
+        bool isDue = collected.epoch == epoch && collected.outputStart == time;
+        for (int ch = 0; ch < 2 && isDue; ++ch)
+        {
+            auto& ring = outputRing[(size_t) ch];
+            const float* out = collected.output[(size_t) ch].data();
+            const float* old = collected.previousOutput[(size_t) ch].data();
+            for (int i = 0; i < tailBlock; ++i)
+            {
+                float value = collected.fading ? old[i] + ((float) i / (float) tailBlock) * (out[i] - old[i]) : out[i];
+                ring[(size_t) ((collected.outputStart + i) & (outputRingSize - 1))] += value;
+            }
+        }
+        collected.state.store(idle, std::memory_order_relaxed);
+    }
+    else if (state == posted || state == running)
+    {
+        tailOverruns.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // the head fade lasts exactly one tail block; the old kernel can go once no tail
+    // job refers to it any more
+    fading = false;
+    if (previous != nullptr && ! isKernelInUse(previous))
+    {
+        retire(previous);
+        previous = nullptr;
+    }
+
+    if (previous == nullptr)
+    {
+        if (auto* kernel = mailbox.exchange(nullptr, std::memory_order_acquire))
+        {
+            previous = current;
+            current = kernel;
+            fading = true;
+            fadeStart = time;
+        }
+    }
+
+    // Hand the last tail block of input to the worker; its output is due two tail
+    // blocks after the block started, i.e. one block from now.
+    int slot = lastPostedJob ^ 1;
+    auto& job = jobs[(size_t) slot];
+    int slotState = job.state.load(std::memory_order_acquire);
+    if (slotState == posted || slotState == running)
+    {
+        // the block is dropped, but its number is used up, so the worker can tell it
+        // is missing and keep the later ones in line with the head
+        tailOverruns.fetch_add(1, std::memory_order_relaxed);
+        ++jobSequence;
+        return;
+    }
+
+    for (int ch = 0; ch < 2; ++ch)
+        std::copy(tailInput[(size_t) ch].begin(), tailInput[(size_t) ch].end(), job.input[(size_t) ch].begin());
+    job.kernel = current;
+    job.previousKernel = previous;
+    job.fading = fading;
+    job.outputStart = time + tailBlock;
+    job.epoch = epoch;
+    job.sequence = ++jobSequence;
+    job.state.store(posted, std::memory_order_release);
+    lastPostedJob = slot;
+
+    // The one blocking call on the audio thread: the wake-up takes the worker's event
+    // mutex, which it only holds while going to sleep. Polling instead would cost the
+    // worker up to a scheduler tick of its one-block budget.
+    LLMEFFECTS_ALLOW_BLOCKING;
+    tailThread->notify();
+}
+
+int ConvolutionReverb::getImpulseLength (const ReverbParameters& p, double sampleRate) noexcept
+{
+    // decayTime past the (compensated) pre-delay, which takes the FDN's tail about 60 dB down
+    double seconds = juce::jmax(0.0, (double) p.preDelay - headBlock / sampleRate) + p.decayTime + 0.1;
+    return juce::jlimit(headLength + tailBlock, static_cast<int>(maxIRSeconds * sampleRate), static_cast<int>(seconds * sampleRate));
+}
+
+double ConvolutionReverb::getTailLengthSeconds (const ReverbParameters& p, double sampleRate) noexcept
+{
+    return (getImpulseLength(p, sampleRate) + headBlock) / sampleRate;
+}
+
+bool ConvolutionReverb::isKernelInUse (const Kernel* kernel) const noexcept
+{
+    for (auto& job : jobs)
+    {
+        int state = job.state.load(std::memory_order_acquire);
+        if ((state == posted || state == running) && (job.kernel == kernel || job.previousKernel == kernel))
+            return true;
+    }
+    return false;
+}
+
+void ConvolutionReverb::retire (Kernel* kernel) noexcept
+{
+    if (kernel == nullptr)
+        return;
+
+    // the builder frees these; it only ever has one or two outstanding
+    int start1, size1, start2, size2;
+    retireFifo.prepareToWrite(1, start1, size1, start2, size2);
+    jassert (size1 == 1);
+    if (size1 > 0)
+    {
+        retired[(size_t) start1] = kernel;
+        retireFifo.finishedWrite(1);
+    }
+}
+
+void ConvolutionReverb::runTailWorker()
+{
+    while (! tailThread->threadShouldExit())
+    {
+        // take the oldest posted job
+        TailJob* next = nullptr;
+        for (auto& job : jobs)
+            if (job.state.load(std::memory_order_acquire) == posted && (next == nullptr || job.sequence < next->sequence))
+                next = &job;
+
+        int expected = posted;
+        if (next != nullptr && next->state.compare_exchange_strong(expected, running, std::memory_order_acquire))
+        {
+            computeTailJob(*next);
+            next->state.store(done, std::memory_order_release);
+            continue;
+        }
+
+        tailThread->wait(10);
+    }
+}
+
+void ConvolutionReverb::computeTailJob (TailJob& job) noexcept
+{
+    if (job.epoch != workerEpoch)
+    {
+        for (int ch = 0; ch < 2; ++ch)
+        {
+            std::fill(tailHistory[(size_t) ch].begin(), tailHistory[(size_t) ch].end(), 0.0f);
+            std::fill(tailPrevious[(size_t) ch].begin(), tailPrevious[(size_t) ch].end(), 0.0f);
+        }
+        workerEpoch = job.epoch;
+    }
+    else if (job.sequence - workerSequence > 1)
+    {
+        // blocks the audio thread had to drop go into the history as silence; without
+        // them every later partition would be a block early against the head
+        auto missed = juce::jmin((juce::uint32) maxTailPartitions, job.sequence - workerSequence - 1);
+        for (juce::uint32 i = 0; i < missed; ++i)
+        {
+            for (int ch = 0; ch < 2; ++ch)
+                std::fill_n(tailHistory[(size_t) ch].begin() + tailHistoryPos * tailSpectrumSize, tailSpectrumSize, 0.0f);
+            tailHistoryPos = (tailHistoryPos + 1) % maxTailPartitions;
+        }
+        for (int ch = 0; ch < 2; ++ch)
+            std::fill(tailPrevious[(size_t) ch].begin(), tailPrevious[(size_t) ch].end(), 0.0f);
+    }
+    workerSequence = job.sequence;
+
+    for (int ch = 0; ch < 2; ++ch)
+    {
+        auto& input = job.input[(size_t) ch];
+        auto& previousInput = tailPrevious[(size_t) ch];
+
+        std::copy(previousInput.begin(), previousInput.end(), tailFFTBuffer.begin());
+        std::copy(input.begin(), input.end(), tailFFTBuffer.begin() + tailBlock);
+        tailFFT.performRealOnlyForwardTransform(tailFFTBuffer.data(), true);
+        std::copy(tailFFTBuffer.begin(), tailFFTBuffer.begin() + tailSpectrumSize,
+                  tailHistory[(size_t) ch].begin() + tailHistoryPos * tailSpectrumSize);
+        std::copy(input.begin(), input.end(), previousInput.begin());
+
+        renderTail(job.kernel, ch, job.output[(size_t) ch].data());
+        if (job.fading)
+            renderTail(job.previousKernel, ch, job.previousOutput[(size_t) ch].data());
+    }
+
+    tailHistoryPos = (tailHistoryPos + 1) % maxTailPartitions;
+}
+
+void ConvolutionReverb::renderTail (const Kernel* kernel, int channel, float* output) noexcept
+{
+    if (kernel == nullptr || kernel->numTailPartitions == 0)
+    {
+        std::fill(output, output + tailBlock, 0.0f);
+        return;
+    }
+
+    accumulatePartitions(tailAccumulator.data(), tailHistory[(size_t) channel], tailHistoryPos, maxTailPartitions,
+                         kernel->tail[(size_t) channel], kernel->numTailPartitions, tailSpectrumSize);
+    std::copy(tailAccumulator.begin(), tailAccumulator.end(), tailFFTBuffer.begin());
+    tailFFT.performRealOnlyInverseTransform(tailFFTBuffer.data());
+    std::copy(tailFFTBuffer.begin() + tailBlock, tailFFTBuffer.begin() + 2 * tailBlock, output);
+}
+
+void ConvolutionReverb::runBuilder()
+{
+    juce::uint32 built = 0;
+
+    while (! builderThread->threadShouldExit())
+    {
+        freeRetiredKernels();
+
+        auto sequence = requestSequence.load(std::memory_order_acquire);
+        if (sequence == built)
+        {
+            builderThread->wait(50);
+            continue;
+        }
+
+        // let a slider drag or a streamed LLM answer settle before rendering
+        builderThread->wait(30);
+        if (requestSequence.load(std::memory_order_acquire) != sequence)
+            continue;
+
+        ReverbParameters parameters;
+        for (int i = 0; i < ReverbParameters::numParameters; ++i)
+            parameters[i] = requestedParameters[(size_t) i].load(std::memory_order_relaxed);
+
+        auto kernel = buildKernel(parameters);
+        if (kernel == nullptr)
+            continue;
+
+        // an IR the audio thread never picked up can go straight away
+        delete mailbox.exchange(kernel.release(), std::memory_order_acq_rel);
+        irAvailable.store(true);
+        built = sequence;
+    }
+}
+
+std::unique_ptr<ConvolutionReverb::Kernel> ConvolutionReverb::buildKernel (const ReverbParameters& parameters)
+{
+    // the head adds headBlock samples of latency, so take that out of the pre-delay
+    auto p = parameters;
+    p.preDelay = juce::jmax(0.0f, p.preDelay - (float) headBlock / (float) fs);
+
+    int length = getImpulseLength(parameters, fs);
+
+    // render the FDN's response to an impulse on each input in turn
+    std::array<std::vector<float>, 2> ir;
+    std::vector<float> impulse ((size_t) renderBlockSize, 0.0f), silence ((size_t) renderBlockSize, 0.0f);
+    std::vector<float> wetL ((size_t) renderBlockSize), wetR ((size_t) renderBlockSize);
+    irSource.setParameters(p);
+
+    for (int ch = 0; ch < 2; ++ch)
+    {
+        ir[(size_t) ch].assign((size_t) length, 0.0f);
+        irSource.reset();
+        impulse[0] = 1.0f;
+
+        for (int offset = 0; offset < length; offset += renderBlockSize)
+        {
+            if (builderThread->threadShouldExit())
+                return nullptr;
+
+            int n = juce::jmin(renderBlockSize, length - offset);
+            irSource.process(ch == 0 ? impulse.data() : silence.data(),
+                             ch == 1 ? impulse.data() : silence.data(),
+                             wetL.data(), wetR.data(), n);
+            impulse[0] = 0.0f;
+
+            auto& wet = ch == 0 ? wetL : wetR;
+            std::copy(wet.begin(), wet.begin() + n, ir[(size_t) ch].begin() + offset);
+        }
+
+        // fade the last 10% so the truncation doesn't click
+        int fadeLength = length / 10;
+        for (int i = 0; i < fadeLength; ++i)
+            ir[(size_t) ch][(size_t) (length - fadeLength + i)] *= 0.5f * (1.0f + std::cos(juce::MathConstants<float>::pi * (float) i / (float) fadeLength));
+    }
+
+    auto kernel = std::make_unique<Kernel>();
+    kernel->numTailPartitions = (length - headLength + tailBlock - 1) / tailBlock;
+
+    std::vector<float> buffer ((size_t) (4 * tailBlock));
+    for (int ch = 0; ch < 2; ++ch)
+    {
+        auto& h = ir[(size_t) ch];
+        auto segment = [&](int start, int size)
+        {
+            std::fill(buffer.begin(), buffer.end(), 0.0f);
+            int available = juce::jlimit(0, size, length - start);
+            std::copy(h.begin() + start, h.begin() + start + available, buffer.begin());
+        };
+
+        auto& head = kernel->head[(size_t) ch];
+        head.resize((size_t) (numHeadPartitions * headSpectrumSize));
+        for (int p = 0; p < numHeadPartitions; ++p)
+        {
+            segment(p * headBlock, headBlock);
+            builderHeadFFT.performRealOnlyForwardTransform(buffer.data(), true);
+            std::copy(buffer.begin(), buffer.begin() + headSpectrumSize, head.begin() + p * headSpectrumSize);
+        }
+
+        auto& tail = kernel->tail[(size_t) ch];
+        tail.resize((size_t) kernel->numTailPartitions * tailSpectrumSize);
+        for (int p = 0; p < kernel->numTailPartitions; ++p)
+        {
+            segment(headLength + p * tailBlock, tailBlock);
+            builderTailFFT.performRealOnlyForwardTransform(buffer.data(), true);
+            std::copy(buffer.begin(), buffer.begin() + tailSpectrumSize, tail.begin() + p * tailSpectrumSize);
+        }
+    }
+
+    return kernel;
+}
+
+void ConvolutionReverb::freeRetiredKernels()
+{
+    int start1, size1, start2, size2;
+    retireFifo.prepareToRead(retireFifo.getNumReady(), start1, size1, start2, size2);
+    for (int i = 0; i < size1; ++i)
+        delete retired[(size_t) (start1 + i)];
+    for (int i = 0; i < size2; ++i)
+        delete retired[(size_t) (start2 + i)];
+    retireFifo.finishedRead(size1 + size2);
+}
+
+void ConvolutionReverb::stopThreads()
+{
+    tailThread->stopThread(2000);
+    builderThread->stopThread(2000);
+}
+
+void ConvolutionReverb::deleteAllKernels()
+{
+    freeRetiredKernels();
+    if (previous != current)
+        delete previous;
+    delete current;
+    delete mailbox.exchange(nullptr);
+    previous = current = nullptr;
+    irAvailable.store(false);
+}
@@ -0,0 +1,186 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include "FDNReverb.h"
+#include "ReverbParameters.h"
+
+// Convolution engine. The impulse response of the FDN for the current parameters is
+// rendered on a background thread and played through non-uniformly partitioned FFT
+// convolution (overlap-save):
+//
+//  - the first headLength samples of the IR use short headBlock partitions, computed
+//    on the audio thread, which costs headBlock samples of latency;
+//  - the rest uses long tailBlock partitions computed on a worker thread. The tail
+//    starts two tail blocks into the IR, so each tail job has a whole tail block of
+//    time before its output is due.
+//
+// The first IR goes in at the next head block, without a fade, so the wet signal is
+// complete as soon as hasImpulseResponse() says so. Later ones are picked up at a tail
+// boundary and crossfaded in: the head over the tail block that follows, the tail over
+// the one after that, since the tail job already in flight was started with the old
+// IR. The input history is shared between the two, so neither starts from silence.
+class ConvolutionReverb
+{
+public:
+    static constexpr int headBlock  = 128;
+    static constexpr int tailBlock  = 2048;
+    static constexpr int headLength = 2 * tailBlock;
+    static constexpr float maxIRSeconds = 6.0f;
+
+    ConvolutionReverb();
+    ~ConvolutionReverb();
+
+    // Allocates and restarts the worker threads; not real-time safe.
+    void prepare (double sampleRate);
+    // Renders the IR from FDNReverb variant `index`, decorrelating it from other
+    // instances' on other output channels. Call before prepare().
+    void setVariant (int index) noexcept { irSource.setVariant(index); }
+
+    // Audio thread. Clears the signal history but keeps the current IR.
+    void reset() noexcept;
+
+    // Audio thread. Queues a new IR if anything that shapes it changed; EQ and mix are
+    // applied by the processor, so they don't count.
+    void setParameters (const ReverbParameters& parameters) noexcept;
+
+    // Audio thread. Writes the wet signal only, headBlock samples late.
+    void process (const float* inL, const float* inR, float* wetL, float* wetR, int numSamples) noexcept;
+
+    // Offline rendering: make the audio thread wait for late tail blocks instead of
+    // dropping them, so the output doesn't depend on scheduling.
+    void setNonRealtime (bool shouldWaitForTail) noexcept { waitForTail = shouldWaitForTail; }
+
+    // IR length for these parameters, and the tail that gives once the head latency
+    // is added on.
+    static int getImpulseLength (const ReverbParameters& parameters, double sampleRate) noexcept;
+    static double getTailLengthSeconds (const ReverbParameters& parameters, double sampleRate) noexcept;
+
+    // True once an IR has been built for the latest prepare(); it is in use from the
+    // next head block on.
+    bool hasImpulseResponse() const noexcept { return irAvailable.load(); }
+    // Tail blocks that weren't ready in time and were dropped.
+    int getNumTailOverruns() const noexcept { return tailOverruns.load(); }
+
+private:
+    static constexpr int numHeadPartitions = headLength / headBlock;
+    static constexpr int headSpectrumSize  = 2 * headBlock + 2;   // interleaved complex bins 0..N/2
+    static constexpr int tailSpectrumSize  = 2 * tailBlock + 2;
+    static constexpr int outputRingSize    = 4 * tailBlock;
+
+    struct Kernel
+    {
+        int numTailPartitions { 0 };
+        // partition spectra back to back, per channel
+        std::array<std::vector<float>, 2> head, tail;
+    };
+
+    enum JobState
+    {
+        idle,
+        posted,
+        running,
+        done
+    };
+
+    struct TailJob
+    {
+        std::array<std::vector<float>, 2> input, output, previousOutput;
+        Kernel* kernel { nullptr };
+        Kernel* previousKernel { nullptr };
+        bool fading { false };
+        juce::int64 outputStart { 0 };
+        juce::uint32 epoch { 0 };
+        juce::uint32 sequence { 0 };
+        std::atomic<int> state { idle };
+    };
+
+    class WorkerThread : public juce::Thread
+    {
+    public:
+        WorkerThread (const juce::String& name, ConvolutionReverb& o, void (ConvolutionReverb::*body)())
+            : juce::Thread (name), owner (o), threadBody (body) {}
+        void run() override { (owner.*threadBody)(); }
+
+    private:
+        ConvolutionReverb& owner;
+        void (ConvolutionReverb::*threadBody)();
+    };
+
+    // audio thread
+    void processHeadBlock() noexcept;
+    void processTailBoundary() noexcept;
+    bool isKernelInUse (const Kernel* kernel) const noexcept;
+    void retire (Kernel* kernel) noexcept;
+
+    // tail worker
+    void runTailWorker();
+    void computeTailJob (TailJob& job) noexcept;
+    void renderTail (const Kernel* kernel, int channel, float* output) noexcept;
+
+    // IR builder
+    void runBuilder();
+    std::unique_ptr<Kernel> buildKernel (const ReverbParameters& parameters);
+    void freeRetiredKernels();
+
+    void stopThreads();
+    void deleteAllKernels();
+
+    double fs { 44100.0 };
+
+    // --- audio thread -------------------------------------------------------------
+    juce::dsp::FFT headFFT;
+    std::vector<float> headFFTBuffer, headPreviousBuffer;
+    std::array<std::vector<float>, 2> headWindow;     // [previous block, current block]
+    std::array<std::vector<float>, 2> headHistory;    // input spectra, numHeadPartitions slots
+    std::vector<float> headAccumulator;
+    int headHistoryPos { 0 };
+    int headFill { 0 };
+
+    std::array<std::vector<float>, 2> outputRing;
+    std::array<std::vector<float>, 2> tailInput;
+    juce::int64 time { 0 };
+
+    std::array<TailJob, 2> jobs;
+    int lastPostedJob { 1 };
+    juce::uint32 jobSequence { 0 };
+    juce::uint32 epoch { 0 };
+
+    Kernel* current { nullptr };
+    Kernel* previous { nullptr };
+    bool fading { false };
+    juce::int64 fadeStart { 0 };
+
+    ReverbParameters lastRequested;
+    bool hasRequested { false };
+    bool waitForTail { false };
+
+    // --- handed between threads ------------------------------------------------------
+    std::array<std::atomic<float>, ReverbParameters::numParameters> requestedParameters;
+    std::atomic<juce::uint32> requestSequence { 0 };
+    std::atomic<Kernel*> mailbox { nullptr };          // builder -> audio
+    juce::AbstractFifo retireFifo { 8 };               // audio -> builder
+    std::array<Kernel*, 8> retired {};
+    std::atomic<bool> irAvailable { false };
+    std::atomic<int> tailOverruns { 0 };
+
+    // --- tail worker -----------------------------------------------------------------
+    juce::dsp::FFT tailFFT;
+    std::vector<float> tailFFTBuffer, tailAccumulator;
+    std::array<std::vector<float>, 2> tailHistory, tailPrevious;
+    int maxTailPartitions { 1 };
+    int tailHistoryPos { 0 };
+    juce::uint32 workerEpoch { 0 };
+    juce::uint32 workerSequence { 0 };   // of the last job computed
+
+    // --- IR builder ------------------------------------------------------------------
+    juce::dsp::FFT builderHeadFFT, builderTailFFT;
+    FDNReverb irSource;
+
+    std::unique_ptr<WorkerThread> tailThread, builderThread;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ConvolutionReverb)
+};
@@ -0,0 +1,144 @@
+#include "CrossoverEQ.h"
+
+namespace
+{
+    using Vec = juce::dsp::SIMDRegister<float>;
+
+    const float butterworthQ = 0.70710678f;
+    const float minFrequency = 20.0f;
+
+    struct Coefficients
+    {
+        float b0, b1, b2, a1, a2;
+    };
+
+    // bilinear transform of the 2nd-order Butterworth sections, prewarped to hz
+    enum class Response { lowpass, highpass, allpass };
+
+    Coefficients butterworth (Response response, float hz, double sampleRate) noexcept
+    {
+        double k = std::tan(juce::MathConstants<double>::pi * juce::jlimit((double) minFrequency, 0.45 * sampleRate, (double) hz) / sampleRate);
+        double norm = 1.0 / (1.0 + k / butterworthQ + k * k);
+        double a1 = 2.0 * (k * k - 1.0) * norm;
+        double a2 = (1.0 - k / butterworthQ + k * k) * norm;
+
+        switch (response)
+        {
+            case Response::lowpass:  return { (float) (k * k * norm), (float) (2.0 * k * k * norm), (float) (k * k * norm), (float) a1, (float) a2 };
+            case Response::highpass: return { (float) norm, (float) (-2.0 * norm), (float) norm, (float) a1, (float) a2 };
+            case Response::allpass:  return { (float) a2, (float) a1, 1.0f, (float) a1, (float) a2 };
+        }
+        return { 1.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+    }
+
+    template <typename Biquad>
+    Vec tick (const Biquad& c, Vec& s1, Vec& s2, Vec x) noexcept
+    {
+        Vec y = x * c.b0 + s1;
+        s1 = x * c.b1 - y * c.a1 + s2;
+        s2 = x * c.b2 - y * c.a2;
+        return y;
+    }
+}
+
+void CrossoverEQ::prepare (double sampleRate, int newNumChannels) noexcept
+{
+    jassert (newNumChannels <= maxChannels);
+    fs = sampleRate;
+    numChannels = juce::jlimit(0, maxChannels, newNumChannels);
+
+    // the coefficients depend on the sample rate, so force a rebuild
+    auto low = lowFrequency, high = highFrequency;
+    lowFrequency = highFrequency = -1.0f;
+    if (low > 0.0f)
+        setCrossoverFrequencies(low, high);
+    reset();
+}
+
+void CrossoverEQ::reset() noexcept
+{
+    for (auto& lanes : state)
+    {
+        lanes.s1.fill(Vec::expand(0.0f));
+        lanes.s2.fill(Vec::expand(0.0f));
+    }
+}
+
+void CrossoverEQ::setCrossoverFrequencies (float lowHz, float highHz) noexcept
+{
+    highHz = juce::jmax(highHz, 2.0f * lowHz);
+    if (lowHz == lowFrequency && highHz == highFrequency)
+        return;
+
+    lowFrequency = lowHz;
+    highFrequency = highHz;
+
+    auto assign = [this] (Section section, const Coefficients& c)
+    {
+        sections[(size_t) section] = { c.b0, c.b1, c.b2, c.a1, c.a2 };
+    };
+
+    auto lowLowpass = butterworth(Response::lowpass, lowHz, fs);
+    auto lowHighpass = butterworth(Response::highpass, lowHz, fs);
+    auto highLowpass = butterworth(Response::lowpass, highHz, fs);
+    auto highHighpass = butterworth(Response::highpass, highHz, fs);
+
+    assign(lowLowpass1, lowLowpass);
+    assign(lowLowpass2, lowLowpass);
+    assign(lowHighpass1, lowHighpass);
+    assign(lowHighpass2, lowHighpass);
+    assign(highLowpass1, highLowpass);
+    assign(highLowpass2, highLowpass);
+    assign(highHighpass1, highHighpass);
+    assign(highHighpass2, highHighpass);
+    assign(lowAllpass, butterworth(Response::allpass, highHz, fs));
+}
+
+void CrossoverEQ::process (float* const* channels, int numSamples, Gains gains, Gains step) noexcept
+{
+    alignas (alignof (Vec)) float in[vecSize] = {};
+    alignas (alignof (Vec)) float out[vecSize] = {};
+    const auto& c = sections;
+
+    // a register of channels at a time, so its filter state stays in registers for the
+    // whole block; lanes past the last channel filter silence
+    for (size_t v = 0; v * vecSize < (size_t) numChannels; ++v)
+    {
+        int first = (int) (v * vecSize);
+        int lanesUsed = juce::jmin((int) vecSize, numChannels - first);
+        auto s = state[v];
+
+        Vec lowGain = Vec::expand(gains.low), midGain = Vec::expand(gains.mid), highGain = Vec::expand(gains.high);
+        const Vec lowStep = Vec::expand(step.low), midStep = Vec::expand(step.mid), highStep = Vec::expand(step.high);
+
+        for (int sample = 0; sample < numSamples; ++sample)
+        {
+            for (int lane = 0; lane < lanesUsed; ++lane)
+                in[lane] = channels[first + lane][sample];
+            Vec x = Vec::fromRawArray(in);
+
+            Vec low = tick(c[lowLowpass1], s.s1[lowLowpass1], s.s2[lowLowpass1], x);
+            low = tick(c[lowLowpass2], s.s1[lowLowpass2], s.s2[lowLowpass2], low);
+            low = tick(c[lowAllpass], s.s1[lowAllpass], s.s2[lowAllpass], low);
+
+            Vec rest = tick(c[lowHighpass1], s.s1[lowHighpass1], s.s2[lowHighpass1], x);
+            rest = tick(c[lowHighpass2], s.s1[lowHighpass2], s.s2[lowHighpass2], rest);
+
+            Vec mid = tick(c[highLowpass1], s.s1[highLowpass1], s.s2[highLowpass1], rest);
+            mid = tick(c[highLowpass2], s.s1[highLowpass2], s.s2[highLowpass2], mid);
+
+            Vec high = tick(c[highHighpass1], s.s1[highHighpass1], s.s2[highHighpass1], rest);
+            high = tick(c[highHighpass2], s.s1[highHighpass2], s.s2[highHighpass2], high);
+
+            (low * lowGain + mid * midGain + high * highGain).copyToRawArray(out);
+            for (int lane = 0; lane < lanesUsed; ++lane)
+                channels[first + lane][sample] = out[lane];
+
+            lowGain += lowStep;
+            midGain += midStep;
+            highGain += highStep;
+        }
+
+        state[v] = s;
+    }
+}
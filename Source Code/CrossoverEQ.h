@@ -0,0 +1,71 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+
+// Three-band EQ for the wet signal, split by 4th-order Linkwitz-Riley crossovers. Each
+// crossover is two identical Butterworth biquads in series, and the low band also goes
+// through the allpass the upper crossover puts on the other two, so with every gain at
+// 0 dB the bands sum back to a flat magnitude response.
+//
+// Channels run in SIMD lanes, one register of channels at a time. The biquad
+// coefficients are only recomputed when a crossover frequency changes.
+class CrossoverEQ
+{
+public:
+    static constexpr int maxChannels = 16;
+
+    struct Gains
+    {
+        float low, mid, high;
+    };
+
+    CrossoverEQ() = default;
+
+    // Doesn't allocate, but resets the filters.
+    void prepare (double sampleRate, int numChannels) noexcept;
+    void reset() noexcept;
+
+    // Audio thread, once per block; does nothing unless a frequency has changed. The
+    // upper crossover is kept at least an octave above the lower one.
+    void setCrossoverFrequencies (float lowHz, float highHz) noexcept;
+
+    // Filters channels [0, numChannels) in place and sums the bands with the given
+    // gains, which move by `step` every sample.
+    void process (float* const* channels, int numSamples, Gains gains, Gains step) noexcept;
+
+private:
+    using Vec = juce::dsp::SIMDRegister<float>;
+    static constexpr size_t vecSize = Vec::SIMDNumElements;
+    static constexpr size_t maxVecs = (size_t) maxChannels / vecSize;
+    static_assert (maxChannels % vecSize == 0, "channel count must fill whole SIMD registers");
+
+    // normalised so a0 = 1, run in transposed direct form II
+    struct Biquad
+    {
+        float b0 { 1.0f }, b1 { 0.0f }, b2 { 0.0f }, a1 { 0.0f }, a2 { 0.0f };
+    };
+
+    enum Section
+    {
+        lowLowpass1, lowLowpass2,       // lower crossover, low band
+        lowHighpass1, lowHighpass2,     // lower crossover, everything above it
+        highLowpass1, highLowpass2,     // upper crossover, mid band
+        highHighpass1, highHighpass2,   // upper crossover, high band
+        lowAllpass,                     // upper crossover's phase, applied to the low band
+        numSections
+    };
+
+    struct State
+    {
+        std::array<Vec, numSections> s1 {}, s2 {};
+    };
+
+    double fs { 44100.0 };
+    int numChannels { 0 };
+    std::array<Biquad, numSections> sections;
+    std::array<State, maxVecs> state;
+    float lowFrequency { -1.0f }, highFrequency { -1.0f };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CrossoverEQ)
+};
@@ -0,0 +1,287 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <cstring>
+#include <type_traits>
+#include "BufferPool.h"
+#include "HalfFloat.h"
+
+// Delay line with a power-of-two capacity, so wrapping is a bitmask instead of a modulo.
+// Lanes (channels, FDN lines, ...) are interleaved one frame per sample and share one
+// write head, so SIMD code can load or store every lane of a frame at once.
+//
+// Delays count back from the head: read(lane, 1) is the frame written before the last
+// advance(). Per sample: read, then write, then advance().
+//
+// A float line can also keep its contents in 16 bits (half floats, or int16 with TPDF
+// dither and 12 dB of headroom) to halve its memory and cache traffic. Values are
+// converted on every read and write; the raw frame and span accessors only work with
+// native storage.
+template <typename SampleType>
+class DelayLine
+{
+public:
+    // The fractional readers look one frame either side of the delay, so they need
+    // this much headroom from the head to avoid reading the frame being written.
+    static constexpr float minLinearDelay   = 1.0f;
+    static constexpr float minLagrangeDelay = 2.0f;
+    static constexpr float minAllpassDelay  = 2.0f;
+
+    enum class Storage
+    {
+        native,
+        float16,
+        int16
+    };
+
+    struct Span
+    {
+        SampleType* data;
+        int numFrames;
+    };
+
+    // Allocates, from the pool if one is given; not real-time safe.
+    void prepare (int maxDelayFrames, int lanes = 1, BufferPool* pool = nullptr, Storage storageMode = Storage::native)
+    {
+        jassert (storageMode == Storage::native || (std::is_same<SampleType, float>::value));
+
+        numLanes = juce::jmax(1, lanes);
+        capacity = juce::nextPowerOfTwo(juce::jmax(4, maxDelayFrames + 4));
+        mask = capacity - 1;
+        storageType = storageMode;
+        sampleBytes = storageType == Storage::native ? sizeof (SampleType) : sizeof (juce::uint16);
+
+        // frames start on a cache line, so a frame that is a whole number of SIMD
+        // registers wide can use aligned loads
+        auto numBytes = (size_t) (capacity * numLanes) * sampleBytes;
+        storage = pool != nullptr ? pool->allocate(numBytes) : BufferPool::allocateUnpooled(numBytes);
+        data = static_cast<SampleType*>(storage.getData());
+        compact = static_cast<juce::uint16*>(storage.getData());
+        head = 0;
+    }
+
+    // Gives the memory back; prepare() again before using the line.
+    void release() noexcept
+    {
+        storage = BufferPool::Buffer();
+        data = nullptr;
+        compact = nullptr;
+        capacity = mask = head = 0;
+    }
+
+    void reset() noexcept
+    {
+        // zero bits are zero in every storage format
+        if (capacity > 0)
+            std::memset(storage.getData(), 0, (size_t) (capacity * numLanes) * sampleBytes);
+        head = 0;
+    }
+
+    // Takes over the newest frames of another line, so every delay both lines can serve
+    // reads the same afterwards. For moving into a bigger line. Frames in another storage
+    // format are converted; with a different number of lanes nothing lines up, so this
+    // line just starts out silent.
+    void copyFrom (const DelayLine& other) noexcept
+    {
+        jassert (other.numLanes == numLanes);
+        if (other.numLanes != numLanes)
+        {
+            reset();
+            return;
+        }
+
+        int numFrames = juce::jmin(capacity, other.capacity);
+        auto frameBytes = (size_t) numLanes * sampleBytes;
+
+        if (other.storageType != storageType)
+        {
+            for (int frame = 0; frame < numFrames; ++frame)
+                for (int lane = 0; lane < numLanes; ++lane)
+                    store(frame * numLanes + lane, other.read(lane, numFrames - frame));
+
+            std::memset(static_cast<char*>(storage.getData()) + (size_t) numFrames * frameBytes, 0, (size_t) (capacity - numFrames) * frameBytes);
+            head = numFrames & mask;
+            return;
+        }
+
+        int start = (other.head - numFrames) & other.mask;
+        int firstFrames = juce::jmin(numFrames, other.capacity - start);
+
+        auto* source = static_cast<const char*>(other.storage.getData());
+        auto* dest = static_cast<char*>(storage.getData());
+        std::memcpy(dest, source + (size_t) start * frameBytes, (size_t) firstFrames * frameBytes);
+        std::memcpy(dest + (size_t) firstFrames * frameBytes, source, (size_t) (numFrames - firstFrames) * frameBytes);
+        std::memset(dest + (size_t) numFrames * frameBytes, 0, (size_t) (capacity - numFrames) * frameBytes);
+        head = numFrames & mask;
+    }
+
+    Storage getStorage() const noexcept { return storageType; }
+    int getCapacity() const noexcept { return capacity; }
+    int getNumLanes() const noexcept { return numLanes; }
+    // longest delay every reader can serve
+    int getMaxDelay() const noexcept { return capacity - 3; }
+
+    // native storage only
+    SampleType* getWriteFrame() noexcept                  { jassert (storageType == Storage::native); return data + head * numLanes; }
+    const SampleType* getFrame (int delay) const noexcept { jassert (storageType == Storage::native); return data + ((head - delay) & mask) * numLanes; }
+
+    SampleType read (int lane, int delay) const noexcept { return load(((head - delay) & mask) * numLanes + lane); }
+    void write (int lane, SampleType value) noexcept     { store(head * numLanes + lane, value); }
+
+    // Writes every lane of the frame at the head, packing a whole frame at once when
+    // the storage is compact.
+    void writeFrame (const SampleType* frame) noexcept
+    {
+        int index = head * numLanes;
+        if (storageType == Storage::native)
+        {
+            std::copy(frame, frame + numLanes, data + index);
+            return;
+        }
+
+        if constexpr (std::is_same<SampleType, float>::value)
+        {
+            if (storageType == Storage::float16)
+            {
+                HalfFloat::fromFloats(frame, compact + index, numLanes);
+                return;
+            }
+        }
+
+        for (int lane = 0; lane < numLanes; ++lane)
+            store(index + lane, frame[lane]);
+    }
+
+    void advance() noexcept                { head = (head + 1) & mask; }
+    void advance (int numFrames) noexcept  { head = (head + numFrames) & mask; }
+
+    SampleType readLinear (int lane, float delay) const noexcept
+    {
+        int i = static_cast<int>(delay);
+        auto frac = static_cast<SampleType>(delay - (float) i);
+        auto a = read(lane, i);
+        auto b = read(lane, i + 1);
+        return a + frac * (b - a);
+    }
+
+    // Third-order Lagrange through the four frames around the delay.
+    SampleType readLagrange (int lane, float delay) const noexcept
+    {
+        int i = static_cast<int>(delay) - 1;
+        auto f = static_cast<SampleType>(delay - (float) i); // 1 <= f < 2
+        auto fm1 = f - 1, fm2 = f - 2, fm3 = f - 3;
+
+        return read(lane, i)     * (-fm1 * fm2 * fm3 / 6)
+             + read(lane, i + 1) * (f * fm2 * fm3 / 2)
+             + read(lane, i + 2) * (-f * fm1 * fm3 / 2)
+             + read(lane, i + 3) * (f * fm1 * fm2 / 6);
+    }
+
+    // First-order Thiran allpass. Flat magnitude response, which suits modulated delays
+    // inside feedback loops, but each reader has to keep its own state.
+    SampleType readAllpass (int lane, float delay, SampleType& state) const noexcept
+    {
+        int i = static_cast<int>(delay) - 1;
+        auto d = static_cast<SampleType>(delay - (float) i); // 1 <= d < 2
+        auto a = (1 - d) / (1 + d);
+        state = a * (read(lane, i) - state) + read(lane, i + 1);
+        return state;
+    }
+
+    // Frames from `delay` back towards the head, split where the buffer wraps. The
+    // second span is empty unless the range crosses the end of the buffer. Native
+    // storage only.
+    std::array<Span, 2> getReadSpans (int delay, int numFrames) const noexcept { return spansFrom(head - delay, numFrames); }
+    // The next numFrames frames from the head onwards.
+    std::array<Span, 2> getWriteSpans (int numFrames) const noexcept           { return spansFrom(head, numFrames); }
+
+    // Writes a block into one lane from the head on. Call advance (numFrames) once
+    // every lane has been written.
+    void writeBlock (int lane, const SampleType* source, int numFrames) noexcept
+    {
+        if (storageType != Storage::native)
+        {
+            for (int i = 0; i < numFrames; ++i)
+                store(((head + i) & mask) * numLanes + lane, source[i]);
+            return;
+        }
+
+        for (auto& span : getWriteSpans(numFrames))
+            for (int i = 0; i < span.numFrames; ++i)
+                span.data[i * numLanes + lane] = *source++;
+    }
+
+    void readBlock (int lane, int delay, SampleType* dest, int numFrames) const noexcept
+    {
+        if (storageType != Storage::native)
+        {
+            for (int i = 0; i < numFrames; ++i)
+                dest[i] = load(((head - delay + i) & mask) * numLanes + lane);
+            return;
+        }
+
+        for (auto& span : getReadSpans(delay, numFrames))
+            for (int i = 0; i < span.numFrames; ++i)
+                *dest++ = span.data[i * numLanes + lane];
+    }
+
+private:
+    // int16 full scale, so feedback build-up above 0 dBFS isn't clipped
+    static constexpr float int16Headroom = 4.0f;
+
+    SampleType load (int index) const noexcept
+    {
+        switch (storageType)
+        {
+            case Storage::float16: return static_cast<SampleType>(HalfFloat::toFloat(compact[index]));
+            case Storage::int16:   return static_cast<SampleType>((float) static_cast<juce::int16>(compact[index]) * (int16Headroom / 32767.0f));
+            case Storage::native:  break;
+        }
+        return data[index];
+    }
+
+    void store (int index, SampleType value) noexcept
+    {
+        switch (storageType)
+        {
+            case Storage::float16:
+                compact[index] = HalfFloat::fromFloat(static_cast<float>(value));
+                return;
+            case Storage::int16:
+            {
+                // triangular dither from two uniform draws, one LSB either way
+                ditherState = ditherState * 1664525u + 1013904223u;
+                float r1 = (float) (ditherState >> 8) * (1.0f / 16777216.0f);
+                ditherState = ditherState * 1664525u + 1013904223u;
+                float r2 = (float) (ditherState >> 8) * (1.0f / 16777216.0f);
+                float scaled = static_cast<float>(value) * (32767.0f / int16Headroom) + r1 - r2;
+                auto quantised = juce::jlimit(-32768, 32767, static_cast<int>(std::floor(scaled + 0.5f)));
+                compact[index] = static_cast<juce::uint16>(static_cast<juce::int16>(quantised));
+                return;
+            }
+            case Storage::native:
+                break;
+        }
+        data[index] = value;
+    }
+
+    std::array<Span, 2> spansFrom (int start, int numFrames) const noexcept
+    {
+        jassert (storageType == Storage::native && numFrames <= capacity);
+        start &= mask;
+        int firstLength = juce::jmin(numFrames, capacity - start);
+        return { Span { data + start * numLanes, firstLength }, Span { data, numFrames - firstLength } };
+    }
+
+    BufferPool::Buffer storage;
+    SampleType* data { nullptr };
+    juce::uint16* compact { nullptr };    // same memory, when the storage is 16 bit
+    Storage storageType { Storage::native };
+    size_t sampleBytes { sizeof (SampleType) };
+    juce::uint32 ditherState { 22222u };
+    int numLanes { 1 };
+    int capacity { 0 };
+    int mask { 0 };
+    int head { 0 };
+};
@@ -0,0 +1,252 @@
+#include "FDNReverb.h"
+
+namespace
+{
+    // line lengths at size 1.0, spread out so no two share a small common factor
+    const float baseLineMs[FDNReverb::numLines] = { 29.7f, 37.1f, 41.1f, 43.7f, 53.3f, 59.9f, 67.7f, 79.3f };
+    const float diffuserMs[] = { 4.77f, 3.59f, 12.73f, 9.30f };
+    const float maxSize = 2.0f;
+    const float maxPreDelaySeconds = 0.5f;
+    const float maxModDepthSeconds = 0.0003f;
+    const float maxVariantScale = 1.0f + FDNReverb::variantStep * (FDNReverb::maxVariants - 1);
+
+    bool isPrime (int n) noexcept
+    {
+        if (n < 2)
+            return false;
+        if (n % 2 == 0)
+            return n == 2;
+        for (int d = 3; d * d <= n; d += 2)
+            if (n % d == 0)
+                return false;
+        return true;
+    }
+}
+
+void FDNReverb::setVariant (int index) noexcept
+{
+    variant = juce::jlimit(0, maxVariants - 1, index);
+    lastLengthScale = -1.0f;
+}
+
+void FDNReverb::prepare (double sampleRate, int maxBlockSize)
+{
+    fs = sampleRate;
+
+    lines.prepare(static_cast<int>(baseLineMs[numLines - 1] * maxSize * maxVariantScale * fs / 1000.0 + 2.0f * maxModDepthSeconds * fs) + 64, numLines);
+    modulator.prepare(fs, maxBlockSize, numLines);
+
+    // the pre-delay is written a block ahead of being read, so it needs room for both
+    preDelay.prepare(static_cast<int>(maxPreDelaySeconds * fs) + maxBlockSize, 2);
+    for (auto& buffer : preDelayed)
+        buffer.assign((size_t) juce::jmax(1, maxBlockSize), 0.0f);
+
+    for (auto& channel : diffusers)
+    {
+        for (int i = 0; i < numDiffusers; ++i)
+        {
+            // the right channel gets slightly longer diffusers to decorrelate the inputs
+            auto& d = channel[(size_t) i];
+            float ms = diffuserMs[i] * (&channel == &diffusers[1] ? 1.07f : 1.0f);
+            d.length = juce::jmax(1, static_cast<int>(ms * fs / 1000.0));
+            d.line.prepare(d.length);
+        }
+    }
+
+    // inject left into even lines and right into odd ones, with alternating signs
+    // so the two channels excite different modes; sideSigns is a Hadamard-style row
+    // used to build the stereo difference on the way out
+    alignas (alignof (Vec)) float gainsL[numLines], gainsR[numLines], signs[numLines];
+    for (int i = 0; i < numLines; ++i)
+    {
+        float sign = (i / 2) % 2 == 0 ? 1.0f : -1.0f;
+        gainsL[i] = (i % 2 == 0) ? sign : 0.0f;
+        gainsR[i] = (i % 2 == 1) ? sign : 0.0f;
+        signs[i]  = (i % 2 == 0) ? 1.0f : -1.0f;
+    }
+    for (size_t v = 0; v < numVecs; ++v)
+    {
+        inputGainsL[v] = Vec::fromRawArray(gainsL + v * vecSize);
+        inputGainsR[v] = Vec::fromRawArray(gainsR + v * vecSize);
+        sideSigns[v]   = Vec::fromRawArray(signs + v * vecSize);
+    }
+
+    lastLengthScale = -1.0f;
+    setParameters(ReverbParameters());
+    reset();
+}
+
+void FDNReverb::reset() noexcept
+{
+    lines.reset();
+    preDelay.reset();
+    for (auto& channel : diffusers)
+        for (auto& d : channel)
+            d.line.reset();
+    for (auto& state : lowpassState)
+        state = Vec::expand(0.0f);
+    allpassState.fill(0.0f);
+    modulator.reset();
+    modDepth = targetModDepth;
+}
+
+void FDNReverb::copyStateFrom (const FDNReverb& other) noexcept
+{
+    jassert (other.fs == fs && other.lines.getCapacity() == lines.getCapacity());
+
+    lines.copyFrom(other.lines);
+    preDelay.copyFrom(other.preDelay);
+    for (size_t ch = 0; ch < diffusers.size(); ++ch)
+        for (size_t i = 0; i < (size_t) numDiffusers; ++i)
+            diffusers[ch][i].line.copyFrom(other.diffusers[ch][i].line);
+
+    lengths = other.lengths;
+    preDelaySamples = other.preDelaySamples;
+    diffuserGain = other.diffuserGain;
+    lowpassState = other.lowpassState;
+    feedbackGains = other.feedbackGains;
+    dampingCoef = other.dampingCoef;
+    mixAmount = other.mixAmount;
+    spread = other.spread;
+    variant = other.variant;
+    lastLengthScale = other.lastLengthScale;
+
+    modulator.copyStateFrom(other.modulator);
+    allpassState = other.allpassState;
+    modDepth = other.modDepth;
+    targetModDepth = other.targetModDepth;
+}
+
+void FDNReverb::updateLengths (float lengthScale) noexcept
+{
+    // round each line up to the next unused prime, which makes them mutually prime
+    int previous = 0;
+    for (int i = 0; i < numLines; ++i)
+    {
+        int candidate = juce::jmax(previous + 1, static_cast<int>(baseLineMs[i] * lengthScale * fs / 1000.0));
+        while (! isPrime(candidate))
+            ++candidate;
+        lengths[(size_t) i] = juce::jmin(candidate, lines.getMaxDelay() - static_cast<int>(2.0f * maxModDepthSeconds * fs) - 1);
+        previous = candidate;
+    }
+    lastLengthScale = lengthScale;
+}
+
+void FDNReverb::setParameters (const ReverbParameters& p) noexcept
+{
+    float lengthScale = p.size * (1.0f + variantStep * (float) variant * p.spread);
+    if (lengthScale != lastLengthScale)
+        updateLengths(lengthScale);
+
+    // per-line gain for a 60 dB decay over decayTime: g = 10^(-3 * length / (fs * T60))
+    alignas (alignof (Vec)) float gains[numLines];
+    for (int i = 0; i < numLines; ++i)
+        gains[i] = std::pow(10.0f, -3.0f * (float) lengths[(size_t) i] / ((float) fs * p.decayTime));
+    for (size_t v = 0; v < numVecs; ++v)
+        feedbackGains[v] = Vec::fromRawArray(gains + v * vecSize);
+
+    // damping 0 -> ~18 kHz, 1 -> ~1.5 kHz
+    float cutoff = 18000.0f * std::pow(1500.0f / 18000.0f, p.damping);
+    dampingCoef = 1.0f - std::exp(-2.0f * juce::MathConstants<float>::pi * juce::jmin(cutoff, 0.45f * (float) fs) / (float) fs);
+
+    // full Householder reflection at density 1, independent combs at 0
+    mixAmount = p.density * 2.0f / (float) numLines;
+    diffuserGain = p.diffusion * 0.7f;
+    spread = p.spread;
+
+    // depth comes in over the first hertz of modulation so 0 really is static
+    modulator.setFrequency(p.modulation);
+    modulator.setPhaseSpread(p.spread);
+    targetModDepth = juce::jmin(1.0f, p.modulation) * maxModDepthSeconds * (float) fs;
+    preDelaySamples = juce::jlimit(0, static_cast<int>(maxPreDelaySeconds * fs), static_cast<int>(p.preDelay * fs));
+}
+
+double FDNReverb::getTailLengthSeconds (const ReverbParameters& p, float decibels) noexcept
+{
+    float diffusion = 0.0f;
+    for (auto ms : diffuserMs)
+        diffusion += ms * 1.07f / 1000.0f;
+
+    return juce::jlimit(0.0f, maxPreDelaySeconds, p.preDelay)
+         + diffusion
+         + baseLineMs[numLines - 1] * juce::jmin(maxSize, p.size) * maxVariantScale / 1000.0f
+         + p.decayTime * decibels / 60.0f;
+}
+
+void FDNReverb::process (const float* inL, const float* inR, float* wetL, float* wetR, int numSamples) noexcept
+{
+    jassert (numSamples <= static_cast<int>(preDelayed[0].size()));
+
+    // write the block first, then read it back preDelaySamples later; the extra
+    // numSamples of delay accounts for the head having moved past the whole block
+    preDelay.writeBlock(0, inL, numSamples);
+    preDelay.writeBlock(1, inR, numSamples);
+    preDelay.advance(numSamples);
+    preDelay.readBlock(0, preDelaySamples + numSamples, preDelayed[0].data(), numSamples);
+    preDelay.readBlock(1, preDelaySamples + numSamples, preDelayed[1].data(), numSamples);
+
+    modulator.process(numSamples);
+    const float* lfo[numLines];
+    for (int i = 0; i < numLines; ++i)
+        lfo[i] = modulator.getOutput(i);
+    float depthStep = (targetModDepth - modDepth) / (float) numSamples;
+
+    alignas (alignof (Vec)) float taps[numLines];
+    const float outScale = 1.0f / std::sqrt((float) numLines);
+
+    for (int n = 0; n < numSamples; ++n)
+    {
+        // a short allpass chain to smear the input
+        float in[2];
+        for (int ch = 0; ch < 2; ++ch)
+        {
+            float x = preDelayed[(size_t) ch][(size_t) n];
+            for (auto& d : diffusers[(size_t) ch])
+            {
+                float delayed = d.line.read(0, d.length);
+                float w = x + diffuserGain * delayed;
+                d.line.write(0, w);
+                d.line.advance();
+                x = delayed - diffuserGain * w;
+            }
+            in[ch] = x;
+        }
+
+        // lfo is in [-1, 1], so the read stays between length and length + 2 * depth
+        for (int i = 0; i < numLines; ++i)
+        {
+            float delay = (float) lengths[(size_t) i] + modDepth * (1.0f + lfo[i][n]);
+            taps[i] = lines.readAllpass(i, delay, allpassState[(size_t) i]);
+        }
+        modDepth += depthStep;
+
+        Vec mid = Vec::expand(0.0f), side = Vec::expand(0.0f), total = Vec::expand(0.0f);
+        Vec damped[numVecs];
+        for (size_t v = 0; v < numVecs; ++v)
+        {
+            Vec x = Vec::fromRawArray(taps + v * vecSize);
+            mid += x;
+            side += x * sideSigns[v];
+
+            lowpassState[v] += (x - lowpassState[v]) * dampingCoef;
+            damped[v] = lowpassState[v] * feedbackGains[v];
+            total += damped[v];
+        }
+
+        // Householder: y = x - (2/N) * sum(x), scaled down by density. The frame holds
+        // all eight lines, so the result goes straight into the delay line.
+        Vec reflection = Vec::expand(total.sum() * mixAmount);
+        float* frame = lines.getWriteFrame();
+        for (size_t v = 0; v < numVecs; ++v)
+        {
+            Vec y = damped[v] - reflection + inputGainsL[v] * in[0] + inputGainsR[v] * in[1];
+            y.copyToRawArray(frame + v * vecSize);
+        }
+        lines.advance();
+
+        float m = mid.sum() * outScale;
+        float s = side.sum() * outScale * spread;
+        wetL[n] = m + s;
+        wetR[n] = m - s;
+    }
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <vector>
+#include "DelayLine.h"
+#include "LFO.h"
+#include "ReverbParameters.h"
+
+// Feedback delay network reverb: eight delay lines with mutually prime lengths scaled
+// by `size`, a one-pole damper per line, and a Householder feedback matrix. The
+// per-line maths runs on juce::dsp::SIMDRegister vectors (SSE/AVX/NEON, whatever the
+// build targets). `diffusion` drives a chain of input allpasses, `density` how much
+// the matrix mixes the lines, and `spread` the width of the stereo output taps and how
+// far apart the lines' modulation LFOs are in phase.
+class FDNReverb
+{
+public:
+    static constexpr int numLines = 8;
+    // variants lengthen every line by variantStep * index * spread (see setVariant)
+    static constexpr int maxVariants = 8;
+    static constexpr float variantStep = 0.03f;
+
+    FDNReverb() = default;
+
+    // Reverbs feeding different output pairs of a surround layout use different
+    // variants, so their tails decorrelate as `spread` goes up; 0 is the plain reverb.
+    // Call before prepare().
+    void setVariant (int index) noexcept;
+
+    // Allocates everything; not real-time safe. process() takes at most maxBlockSize samples.
+    void prepare (double sampleRate, int maxBlockSize);
+    void reset() noexcept;
+    // Makes this reverb a running copy of another prepared with the same settings:
+    // delay contents, filter state and parameters. Real-time safe, so a parameter jump
+    // can be crossfaded between the copy (given the new parameters) and the original.
+    void copyStateFrom (const FDNReverb& other) noexcept;
+
+    // Audio thread, once per block when the parameters change.
+    void setParameters (const ReverbParameters& parameters) noexcept;
+
+    // Writes the wet signal only; inputs and outputs may not alias.
+    void process (const float* inL, const float* inR, float* wetL, float* wetR, int numSamples) noexcept;
+
+    // Time for the output to fall by `decibels` once the input stops: pre-delay, one
+    // pass through the diffusers and the longest line, then the decay itself.
+    static double getTailLengthSeconds (const ReverbParameters& parameters, float decibels) noexcept;
+
+private:
+    using Vec = juce::dsp::SIMDRegister<float>;
+    static constexpr size_t vecSize = Vec::SIMDNumElements;
+    static constexpr size_t numVecs = numLines / vecSize;
+    static_assert (numLines % vecSize == 0, "delay line count must fill whole SIMD registers");
+
+    static constexpr int numDiffusers = 4;
+
+    struct Diffuser
+    {
+        DelayLine<float> line;
+        int length { 1 };
+    };
+
+    double fs { 44100.0 };
+
+    // one lane per line, so the feedback vector is stored as a single frame; each line
+    // reads `lengths[i]` frames behind the shared head
+    DelayLine<float> lines;
+    std::array<int, numLines> lengths {};
+
+    // stereo pre-delay, run a whole block at a time
+    DelayLine<float> preDelay;
+    std::array<std::vector<float>, 2> preDelayed;
+    int preDelaySamples { 0 };
+
+    std::array<std::array<Diffuser, numDiffusers>, 2> diffusers;
+    float diffuserGain { 0.0f };
+
+    std::array<Vec, numVecs> lowpassState {};
+    std::array<Vec, numVecs> feedbackGains {};
+    std::array<Vec, numVecs> inputGainsL {}, inputGainsR {}, sideSigns {};
+    float dampingCoef { 0.0f };
+    float mixAmount { 0.0f };
+    float spread { 0.5f };
+    int variant { 0 };
+    float lastLengthScale { -1.0f };
+
+    // each line's read position wobbles by up to modDepth samples, read through an
+    // allpass interpolator so the modulation doesn't dull the tail
+    LFO modulator;
+    std::array<float, numLines> allpassState {};
+    float modDepth { 0.0f }, targetModDepth { 0.0f };
+
+    void updateLengths (float lengthScale) noexcept;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (FDNReverb)
+};
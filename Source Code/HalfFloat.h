@@ -0,0 +1,136 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <cstring>
+
+#if defined (__F16C__)
+ #include <immintrin.h>
+#elif defined (__ARM_NEON) && defined (__aarch64__)
+ #include <arm_neon.h>
+#endif
+
+// IEEE binary16 conversion for compact sample storage. Uses the F16C instructions on
+// x86 builds that enable them and the native half type on AArch64; elsewhere it falls
+// back to bit twiddling. Rounds to nearest even; values past the half range saturate
+// to the largest finite half rather than turning into infinity.
+struct HalfFloat
+{
+    static juce::uint16 fromFloat (float value) noexcept
+    {
+        value = juce::jlimit(-maxValue, maxValue, value);
+       #if defined (__F16C__)
+        return static_cast<juce::uint16>(_cvtss_sh(value, _MM_FROUND_TO_NEAREST_INT));
+       #elif defined (__ARM_NEON) && defined (__aarch64__)
+        __fp16 half = static_cast<__fp16>(value);
+        juce::uint16 bits;
+        std::memcpy(&bits, &half, sizeof (bits));
+        return bits;
+       #else
+        return fromFloatSoftware(value);
+       #endif
+    }
+
+    static float toFloat (juce::uint16 bits) noexcept
+    {
+       #if defined (__F16C__)
+        return _cvtsh_ss(bits);
+       #elif defined (__ARM_NEON) && defined (__aarch64__)
+        __fp16 half;
+        std::memcpy(&half, &bits, sizeof (bits));
+        return static_cast<float>(half);
+       #else
+        return toFloatSoftware(bits);
+       #endif
+    }
+
+    // Whole frames at a time, four lanes per instruction where the hardware allows.
+    static void fromFloats (const float* source, juce::uint16* dest, int numValues) noexcept
+    {
+        int i = 0;
+       #if defined (__F16C__)
+        const auto limit = _mm_set1_ps(maxValue);
+        for (; i + 4 <= numValues; i += 4)
+        {
+            auto v = _mm_max_ps(_mm_min_ps(_mm_loadu_ps(source + i), limit), _mm_sub_ps(_mm_setzero_ps(), limit));
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(dest + i), _mm_cvtps_ph(v, _MM_FROUND_TO_NEAREST_INT));
+        }
+       #elif defined (__ARM_NEON) && defined (__aarch64__)
+        const auto limit = vdupq_n_f32(maxValue);
+        for (; i + 4 <= numValues; i += 4)
+        {
+            auto v = vmaxq_f32(vminq_f32(vld1q_f32(source + i), limit), vnegq_f32(limit));
+            vst1_u16(dest + i, vreinterpret_u16_f16(vcvt_f16_f32(v)));
+        }
+       #endif
+        for (; i < numValues; ++i)
+            dest[i] = fromFloat(source[i]);
+    }
+
+    static void toFloats (const juce::uint16* source, float* dest, int numValues) noexcept
+    {
+        int i = 0;
+       #if defined (__F16C__)
+        for (; i + 4 <= numValues; i += 4)
+            _mm_storeu_ps(dest + i, _mm_cvtph_ps(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(source + i))));
+       #elif defined (__ARM_NEON) && defined (__aarch64__)
+        for (; i + 4 <= numValues; i += 4)
+            vst1q_f32(dest + i, vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(source + i))));
+       #endif
+        for (; i < numValues; ++i)
+            dest[i] = toFloat(source[i]);
+    }
+
+    static juce::uint16 fromFloatSoftware (float value) noexcept
+    {
+        juce::uint32 x;
+        std::memcpy(&x, &value, sizeof (x));
+
+        auto sign = static_cast<juce::uint32>((x >> 16) & 0x8000);
+        int exponent = static_cast<int>((x >> 23) & 0xff) - 127 + 15;
+        juce::uint32 mantissa = x & 0x7fffff;
+
+        if (((x >> 23) & 0xff) == 0xff)
+            return static_cast<juce::uint16>(sign | 0x7c00 | (mantissa != 0 ? 0x200 : 0));
+        if (exponent >= 31)
+            return static_cast<juce::uint16>(sign | 0x7bff);
+
+        int shift = 13;
+        if (exponent <= 0)
+        {
+            // subnormal half: shift the implicit bit in as well
+            if (exponent < -10)
+                return static_cast<juce::uint16>(sign);
+            mantissa |= 0x800000;
+            shift = 14 - exponent;
+            exponent = 0;
+        }
+
+        juce::uint32 half = (static_cast<juce::uint32>(exponent) << 10) + (mantissa >> shift);
+        juce::uint32 remainder = mantissa & ((1u << shift) - 1);
+        juce::uint32 midpoint = 1u << (shift - 1);
+        if (remainder > midpoint || (remainder == midpoint && (half & 1) != 0))
+            ++half;   // a carry out of the mantissa correctly bumps the exponent
+        return static_cast<juce::uint16>(sign | juce::jmin(half, (juce::uint32) 0x7bff));
+    }
+
+    static float toFloatSoftware (juce::uint16 bits) noexcept
+    {
+        auto sign = static_cast<juce::uint32>(bits & 0x8000) << 16;
+        juce::uint32 exponent = (bits >> 10) & 0x1f;
+        juce::uint32 mantissa = bits & 0x3ff;
+
+        if (exponent == 0)
+        {
+            float magnitude = (float) mantissa * 5.9604645e-8f;   // 2^-24
+            return sign != 0 ? -magnitude : magnitude;
+        }
+
+        juce::uint32 x = exponent == 31 ? (sign | 0x7f800000 | (mantissa << 13))
+                                        : (sign | ((exponent + 112) << 23) | (mantissa << 13));
+        float value;
+        std::memcpy(&value, &x, sizeof (value));
+        return value;
+    }
+
+    static constexpr float maxValue = 65504.0f;
+};
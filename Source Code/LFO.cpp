@@ -0,0 +1,129 @@
+#include "LFO.h"
+
+namespace
+{
+    using Vec = juce::dsp::SIMDRegister<float>;
+
+    // phases here are in [0, 2), so one conditional subtraction brings them back to [0, 1)
+    Vec wrap (Vec p) noexcept
+    {
+        const auto one = Vec::expand(1.0f);
+        return p - (one & Vec::greaterThanOrEqual(p, one));
+    }
+
+    Vec abs (Vec x) noexcept
+    {
+        return Vec::max(x, Vec::expand(0.0f) - x);
+    }
+
+    // sin (2 pi p): a parabola through sin (pi t) with t = 2p - 1, plus one correction
+    // step, which is within about 0.001 of the real thing
+    Vec sine (Vec p) noexcept
+    {
+        Vec t = p * 2.0f - Vec::expand(1.0f);
+        Vec y = t * 4.0f * (Vec::expand(1.0f) - abs(t));
+        y = (y * abs(y) - y) * 0.225f + y;
+        return Vec::expand(0.0f) - y;
+    }
+
+    // starts at 0 and rises, like the sine
+    Vec triangle (Vec p) noexcept
+    {
+        Vec q = wrap(p + Vec::expand(0.25f));
+        return Vec::expand(1.0f) - abs(q - Vec::expand(0.5f)) * 4.0f;
+    }
+
+    Vec saw (Vec p) noexcept
+    {
+        return p * 2.0f - Vec::expand(1.0f);
+    }
+
+    Vec square (Vec p) noexcept
+    {
+        const auto one = Vec::expand(1.0f);
+        return one - (one & Vec::greaterThanOrEqual(p, Vec::expand(0.5f))) * 2.0f;
+    }
+}
+
+void LFO::prepare (double sampleRate, int maxBlockSize, int numOutputs)
+{
+    fs = sampleRate;
+
+    auto numVecs = (size_t) ((juce::jmax(1, maxBlockSize) + (int) Vec::SIMDNumElements - 1) / (int) Vec::SIMDNumElements);
+    phases.assign(numVecs, Vec::expand(0.0f));
+    outputs.assign((size_t) juce::jmax(1, numOutputs), std::vector<Vec> (numVecs, Vec::expand(0.0f)));
+
+    ramp.assign(numVecs, Vec::expand(0.0f));
+    auto* rampValues = reinterpret_cast<float*>(ramp.data());
+    for (size_t i = 0; i < numVecs * Vec::SIMDNumElements; ++i)
+        rampValues[i] = (float) i;
+
+    currentOffsets.assign(outputs.size(), 0.0f);
+    targetOffsets.assign(outputs.size(), 0.0f);
+    reset();
+}
+
+void LFO::reset() noexcept
+{
+    phase = 0.0;
+    currentOffsets = targetOffsets;
+}
+
+void LFO::copyStateFrom (const LFO& other) noexcept
+{
+    jassert (other.targetOffsets.size() == targetOffsets.size());
+    phase = other.phase;
+    increment = other.increment;
+    shape = other.shape;
+    std::copy(other.currentOffsets.begin(), other.currentOffsets.end(), currentOffsets.begin());
+    std::copy(other.targetOffsets.begin(), other.targetOffsets.end(), targetOffsets.begin());
+}
+
+void LFO::setFrequency (float hz) noexcept
+{
+    increment = juce::jmax(0.0, (double) hz / fs);
+}
+
+void LFO::setPhaseSpread (float spread) noexcept
+{
+    auto numOutputs = targetOffsets.size();
+    for (size_t k = 0; k < numOutputs; ++k)
+        targetOffsets[k] = juce::jlimit(0.0f, 1.0f, spread) * (float) k / (float) numOutputs;
+}
+
+void LFO::process (int numSamples) noexcept
+{
+    jassert (numSamples <= static_cast<int>(phases.size() * Vec::SIMDNumElements));
+
+    // the accumulator is the only serial part; it stays in double so it doesn't drift
+    auto* phaseValues = reinterpret_cast<float*>(phases.data());
+    for (int n = 0; n < numSamples; ++n)
+    {
+        phaseValues[n] = (float) phase;
+        phase += increment;
+        if (phase >= 1.0)
+            phase -= 1.0;
+    }
+
+    auto numVecs = (size_t) ((numSamples + (int) Vec::SIMDNumElements - 1) / (int) Vec::SIMDNumElements);
+
+    for (size_t k = 0; k < outputs.size(); ++k)
+    {
+        float offsetStep = (targetOffsets[k] - currentOffsets[k]) / (float) numSamples;
+        auto offset = Vec::expand(currentOffsets[k]);
+        auto& out = outputs[k];
+
+        for (size_t v = 0; v < numVecs; ++v)
+        {
+            Vec p = wrap(phases[v] + offset + ramp[v] * offsetStep);
+            switch (shape)
+            {
+                case Shape::sine:     out[v] = sine(p);     break;
+                case Shape::triangle: out[v] = triangle(p); break;
+                case Shape::saw:      out[v] = saw(p);      break;
+                case Shape::square:   out[v] = square(p);   break;
+            }
+        }
+        currentOffsets[k] = targetOffsets[k];
+    }
+}
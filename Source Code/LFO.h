@@ -0,0 +1,58 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <vector>
+
+// Block-rate LFO bank: one phase accumulator that carries over from block to block,
+// and several outputs reading it at different phase offsets (one per channel or per
+// delay line). process() fills a block for every output in one SIMD pass; the sine is
+// a polynomial approximation, so there's no std::sin or table lookup per sample.
+class LFO
+{
+public:
+    enum class Shape
+    {
+        sine,
+        triangle,
+        saw,
+        square
+    };
+
+    LFO() = default;
+
+    // Allocates; not real-time safe.
+    void prepare (double sampleRate, int maxBlockSize, int numOutputs);
+    void reset() noexcept;
+    // Takes over another bank's phase and settings so the two run in lockstep. Both
+    // must have been prepared with the same number of outputs; doesn't allocate.
+    void copyStateFrom (const LFO& other) noexcept;
+
+    void setFrequency (float hz) noexcept;
+    void setShape (Shape newShape) noexcept { shape = newShape; }
+    // Output k runs spread * k / numOutputs of a cycle behind output 0, so 0 keeps them
+    // all in phase and 1 spreads them evenly round the cycle. Changes glide over the
+    // next block rather than jumping.
+    void setPhaseSpread (float spread) noexcept;
+
+    // Values in [-1, 1], valid until the next call.
+    void process (int numSamples) noexcept;
+    const float* getOutput (int index) const noexcept { return reinterpret_cast<const float*>(outputs[(size_t) index].data()); }
+
+    int getNumOutputs() const noexcept { return static_cast<int>(outputs.size()); }
+    int getMaxBlockSize() const noexcept { return static_cast<int>(phases.size() * Vec::SIMDNumElements); }
+
+private:
+    using Vec = juce::dsp::SIMDRegister<float>;
+
+    double fs { 44100.0 };
+    double phase { 0.0 };
+    double increment { 0.0 };
+    Shape shape { Shape::sine };
+
+    std::vector<Vec> phases;                  // shared phase for each sample of the block
+    std::vector<Vec> ramp;                    // 0, 1, 2, ... for gliding the offsets
+    std::vector<std::vector<Vec>> outputs;
+    std::vector<float> currentOffsets, targetOffsets;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LFO)
+};
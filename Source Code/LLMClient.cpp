@@ -0,0 +1,22 @@
+#include "LLMClient.h"
+
+LLMClient::~LLMClient()
+{
+    owner->alive = false;
+    cancelAll();
+}
+
+void LLMClient::submit (const juce::String& requestBody, Callback onComplete, DataCallback onData)
+{
+    service->submit(owner, requestBody, std::move(onComplete), std::move(onData));
+}
+
+void LLMClient::cancelAll()
+{
+    service->cancel(owner);
+}
+
+int LLMClient::getNumPending() const
+{
+    return service->getNumPending(*owner);
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <memory>
+#include "LLMService.h"
+
+// One plugin instance's handle on the process-wide LLMService. Requests go into the
+// shared queue, and deleting the client cancels everything it still has pending; no
+// callback of its runs after that. An identical request from another instance keeps
+// going for that one.
+class LLMClient
+{
+public:
+    using Options = LLMService::Options;
+    using Response = LLMService::Response;
+    using Metrics = LLMService::Metrics;
+    using Callback = LLMService::Callback;
+    using DataCallback = LLMService::DataCallback;
+
+    LLMClient() = default;
+    ~LLMClient();
+
+    // Queues a JSON request body. onComplete (and onData, for each streamed delta) is
+    // called on the message thread unless the request gets cancelled first.
+    void submit (const juce::String& requestBody, Callback onComplete, DataCallback onData = nullptr);
+
+    // Drops this client's queued requests and abandons the ones in flight.
+    void cancelAll();
+
+    int getNumPending() const;
+    const Options& getOptions() const noexcept { return service->getOptions(); }
+    // for the whole process, not just this client
+    Metrics getMetrics() const { return service->getMetrics(); }
+
+private:
+    juce::SharedResourcePointer<LLMService> service;
+    std::shared_ptr<LLMService::Owner> owner { std::make_shared<LLMService::Owner>() };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LLMClient)
+};
@@ -0,0 +1,422 @@
+#include "LLMService.h"
+
+namespace
+{
+    // Put your key in here, or set LLMEFFECTS_API_KEY.
+    const char* const builtInKey = "YOUR KEY HERE";
+}
+
+class LLMService::Worker  : public juce::Thread
+{
+public:
+    Worker (LLMService& s, int index)
+        : juce::Thread ("LLM request worker " + juce::String(index)), service (s) {}
+
+    void run() override { service.runWorker(*this); }
+
+private:
+    LLMService& service;
+};
+
+LLMService::Options LLMService::Options::fromEnvironment()
+{
+    Options o;
+    o.apiKey = juce::SystemStats::getEnvironmentVariable("LLMEFFECTS_API_KEY", builtInKey);
+    o.url = juce::SystemStats::getEnvironmentVariable("LLMEFFECTS_API_URL", o.url);
+    o.maxConcurrentRequests = juce::SystemStats::getEnvironmentVariable("LLMEFFECTS_MAX_REQUESTS", juce::String(o.maxConcurrentRequests)).getIntValue();
+    o.requestsPerMinute = juce::SystemStats::getEnvironmentVariable("LLMEFFECTS_REQUESTS_PER_MINUTE", juce::String(o.requestsPerMinute)).getDoubleValue();
+    o.tokenBudget = juce::SystemStats::getEnvironmentVariable("LLMEFFECTS_TOKEN_BUDGET", juce::String(o.tokenBudget)).getIntValue();
+    return o;
+}
+
+bool LLMService::Options::hasApiKey() const
+{
+    return apiKey.isNotEmpty() && apiKey != "YOUR KEY HERE";
+}
+
+LLMService::LLMService()
+    : LLMService (Options::fromEnvironment())
+{
+}
+
+LLMService::LLMService (const Options& o)
+    : options (o)
+{
+    // the bucket starts full, so the first few prompts of a session go straight out
+    tokens = (double) juce::jmax(1, options.burstSize);
+    lastRefillMs = juce::Time::getMillisecondCounterHiRes();
+
+    for (int i = 0; i < juce::jmax(1, options.maxConcurrentRequests); ++i)
+    {
+        workers.push_back(std::make_unique<Worker>(*this, i));
+        workers.back()->startThread();
+    }
+}
+
+LLMService::~LLMService()
+{
+    for (auto& worker : workers)
+        worker->signalThreadShouldExit();
+
+    {
+        const juce::ScopedLock sl (lock);
+        queue.clear();
+        for (auto& request : inFlight)
+            if (request->stream != nullptr)
+                request->stream->cancel();
+    }
+
+    notifyWorkers();
+    for (auto& worker : workers)
+        worker->stopThread(options.connectionTimeoutMs + 1000);
+}
+
+void LLMService::submit (const std::shared_ptr<Owner>& owner, const juce::String& requestBody,
+                         Callback onComplete, DataCallback onData)
+{
+    Waiter waiter { owner, owner->generation.load(), std::move(onComplete), std::move(onData) };
+
+    {
+        const juce::ScopedLock sl (lock);
+
+        // the same question is already on its way: wait for that answer instead
+        if (auto request = findRequest(requestBody))
+        {
+            ++coalesced;
+            if (waiter.onData != nullptr && request->content.isNotEmpty())
+            {
+                auto onDelta = waiter.onData;
+                auto soFar = request->content;
+                deliver(waiter, [onDelta, soFar]() { onDelta(soFar); });
+            }
+            request->waiters.push_back(std::move(waiter));
+            return;
+        }
+
+        auto request = std::make_shared<Request>();
+        request->body = requestBody;
+        request->submittedMs = juce::Time::getMillisecondCounterHiRes();
+        request->waiters.push_back(std::move(waiter));
+        queue.push_back(std::move(request));
+    }
+
+    notifyWorkers();
+}
+
+void LLMService::cancel (const std::shared_ptr<Owner>& owner)
+{
+    ++owner->generation;
+
+    {
+        const juce::ScopedLock sl (lock);
+        auto dropOwner = [&owner](Request& request)
+        {
+            auto& w = request.waiters;
+            w.erase(std::remove_if(w.begin(), w.end(), [&owner](const Waiter& waiter) { return waiter.owner == owner; }), w.end());
+            return w.empty();
+        };
+
+        queue.erase(std::remove_if(queue.begin(), queue.end(),
+                                   [&dropOwner](const std::shared_ptr<Request>& request) { return dropOwner(*request); }),
+                    queue.end());
+
+        // the worker notices it has been abandoned and moves on
+        for (auto& request : inFlight)
+            if (dropOwner(*request) && request->stream != nullptr)
+                request->stream->cancel();
+    }
+
+    // wake workers sleeping between retries or waiting for a token
+    notifyWorkers();
+}
+
+int LLMService::getNumPending (const Owner& owner) const
+{
+    const juce::ScopedLock sl (lock);
+    auto isWaiting = [&owner](const std::shared_ptr<Request>& request)
+    {
+        for (auto& waiter : request->waiters)
+            if (waiter.owner.get() == &owner)
+                return true;
+        return false;
+    };
+    return (int) (std::count_if(queue.begin(), queue.end(), isWaiting) + std::count_if(inFlight.begin(), inFlight.end(), isWaiting));
+}
+
+LLMService::Metrics LLMService::getMetrics() const
+{
+    const juce::ScopedLock sl (lock);
+    Metrics m;
+    m.queued = (int) queue.size();
+    m.inFlight = (int) inFlight.size();
+    m.sent = sent;
+    m.completed = completed;
+    m.failed = failed;
+    m.coalesced = coalesced;
+    m.lastLatencyMs = lastLatencyMs;
+    m.meanQueueMs = numStarted > 0 ? totalQueueMs / (double) numStarted : 0.0;
+
+    if (numLatencies > 0)
+    {
+        std::vector<double> sorted (latencies.begin(), latencies.begin() + numLatencies);
+        std::sort(sorted.begin(), sorted.end());
+        m.medianLatencyMs = sorted[sorted.size() / 2];
+        m.p95LatencyMs = sorted[juce::jmin(sorted.size() - 1, (size_t) (0.95 * (double) sorted.size()))];
+    }
+    return m;
+}
+
+std::shared_ptr<LLMService::Request> LLMService::findRequest (const juce::String& body) const
+{
+    for (auto& request : queue)
+        if (request->body == body)
+            return request;
+    // one that everybody cancelled is on its way out, its stream possibly cut already,
+    // so joining it would get a truncated answer
+    for (auto& request : inFlight)
+        if (request->body == body && ! request->waiters.empty())
+            return request;
+    return nullptr;
+}
+
+void LLMService::notifyWorkers()
+{
+    for (auto& worker : workers)
+        worker->notify();
+}
+
+bool LLMService::isAbandoned (Worker& worker, const Request& request) const
+{
+    if (worker.threadShouldExit())
+        return true;
+    const juce::ScopedLock sl (lock);
+    return request.waiters.empty();
+}
+
+int LLMService::takeToken()
+{
+    auto now = juce::Time::getMillisecondCounterHiRes();
+    double perMs = juce::jmax(0.001, options.requestsPerMinute) / 60000.0;
+    tokens = juce::jmin((double) juce::jmax(1, options.burstSize), tokens + (now - lastRefillMs) * perMs);
+    lastRefillMs = now;
+
+    if (tokens >= 1.0)
+    {
+        tokens -= 1.0;
+        return 0;
+    }
+    return juce::jmax(1, (int) std::ceil((1.0 - tokens) / perMs));
+}
+
+bool LLMService::waitForToken (Worker& worker, const Request& request)
+{
+    while (! isAbandoned(worker, request))
+    {
+        int waitMs = 0;
+        {
+            const juce::ScopedLock sl (lock);
+            waitMs = takeToken();
+        }
+        if (waitMs == 0)
+            return true;
+        worker.wait(waitMs);
+    }
+    return false;
+}
+
+void LLMService::runWorker (Worker& worker)
+{
+    while (! worker.threadShouldExit())
+    {
+        std::shared_ptr<Request> request;
+        {
+            const juce::ScopedLock sl (lock);
+            if (! queue.empty())
+            {
+                request = std::move(queue.front());
+                queue.pop_front();
+                inFlight.push_back(request);
+            }
+        }
+
+        if (request == nullptr)
+        {
+            worker.wait(-1);
+            continue;
+        }
+
+        finish(request, perform(worker, *request));
+    }
+}
+
+void LLMService::finish (const std::shared_ptr<Request>& request, const Response& response)
+{
+    std::vector<Waiter> waiters;
+    {
+        const juce::ScopedLock sl (lock);
+        inFlight.erase(std::remove(inFlight.begin(), inFlight.end(), request), inFlight.end());
+        waiters = std::move(request->waiters);
+        request->waiters.clear();
+
+        // abandoned requests say nothing about the endpoint
+        if (waiters.empty())
+            return;
+
+        if (response.succeeded)
+            ++completed;
+        else
+            ++failed;
+        if (response.statusCode != 0)
+        {
+            lastLatencyMs = juce::Time::getMillisecondCounterHiRes() - request->submittedMs;
+            latencies[(size_t) nextLatency] = lastLatencyMs;
+            nextLatency = (nextLatency + 1) % latencyWindow;
+            numLatencies = juce::jmin(latencyWindow, numLatencies + 1);
+        }
+    }
+
+    for (auto& waiter : waiters)
+    {
+        if (waiter.onComplete == nullptr)
+            continue;
+        auto callback = waiter.onComplete;
+        deliver(waiter, [callback, response]() { callback(response); });
+    }
+}
+
+void LLMService::deliver (const Waiter& waiter, std::function<void()> callback)
+{
+    auto owner = waiter.owner;
+    auto generation = waiter.generation;
+    juce::MessageManager::callAsync([owner, generation, callback]()
+    {
+        if (owner->alive && owner->generation == generation)
+            callback();
+    });
+}
+
+LLMService::Response LLMService::perform (Worker& worker, Request& request)
+{
+    Response response;
+    int backoffMs = options.initialBackoffMs;
+
+    // WebInputStream's connection ends with the stream; asking for keep-alive lets a
+    // platform HTTP stack that pools sockets hand the next request the same one
+    juce::String extraHeaders = "Content-Type: application/json\r\nConnection: keep-alive\r\nAuthorization: Bearer " + options.apiKey;
+
+    for (int attempt = 1; attempt <= options.maxAttempts; ++attempt)
+    {
+        if (! waitForToken(worker, request))
+            break;
+
+        response.attempts = attempt;
+        juce::WebInputStream stream (juce::URL(options.url).withPOSTData(request.body), true);
+        stream.withExtraHeaders(extraHeaders)
+              .withConnectionTimeout(options.connectionTimeoutMs)
+              .withNumRedirectsToFollow(5);
+
+        {
+            const juce::ScopedLock sl (lock);
+            if (request.waiters.empty() || worker.threadShouldExit())
+                break;
+            request.stream = &stream;
+            ++sent;
+            if (attempt == 1)
+            {
+                request.startedMs = juce::Time::getMillisecondCounterHiRes();
+                totalQueueMs += request.startedMs - request.submittedMs;
+                ++numStarted;
+            }
+        }
+
+        bool connected = stream.connect(nullptr);
+        response.statusCode = connected ? stream.getStatusCode() : 0;
+        response.body.clear();
+        response.content.clear();
+
+        if (connected && response.statusCode >= 200 && response.statusCode < 300)
+            readEventStream(worker, request, stream, response);
+        else if (connected)
+            response.body = stream.readEntireStreamAsString();
+
+        {
+            const juce::ScopedLock sl (lock);
+            request.stream = nullptr;
+        }
+
+        if (connected && response.statusCode >= 200 && response.statusCode < 300)
+        {
+            response.succeeded = true;
+            response.error.clear();
+            return response;
+        }
+
+        response.error = connected ? "LLM API returned HTTP " + juce::String(response.statusCode) + "."
+                                   : juce::String("Failed to connect to LLM API.");
+
+        // only connection failures, rate limits and server errors are worth retrying,
+        // and never once part of a streamed reply has been handed out
+        bool retryable = (! connected || response.statusCode == 429 || response.statusCode >= 500)
+                            && response.content.isEmpty();
+        if (! retryable || attempt == options.maxAttempts)
+            break;
+
+        // submissions also notify, so keep waiting until the backoff has really elapsed
+        auto retryTime = juce::Time::getMillisecondCounter() + (juce::uint32) backoffMs;
+        for (auto now = juce::Time::getMillisecondCounter(); now < retryTime && ! isAbandoned(worker, request); now = juce::Time::getMillisecondCounter())
+            worker.wait((int) (retryTime - now));
+
+        backoffMs = juce::jmin(backoffMs * 2, options.maxBackoffMs);
+    }
+
+    return response;
+}
+
+// Reads "data: {...}" lines of a chat-completions event stream and forwards each
+// choices[0].delta.content as soon as its line is complete. A server that ignores
+// "stream": true and sends a plain JSON body ends up in response.body as usual.
+void LLMService::readEventStream (Worker& worker, Request& request, juce::WebInputStream& stream, Response& response)
+{
+    bool sawEvents = false;
+
+    while (! stream.isExhausted() && ! isAbandoned(worker, request))
+    {
+        auto line = stream.readNextLine();
+        response.body << line << "\n";
+
+        if (! line.startsWith("data:"))
+            continue;
+
+        sawEvents = true;
+        auto data = line.substring(5).trim();
+        if (data == "[DONE]")
+            break;
+
+        auto event = juce::JSON::parse(data);
+        juce::var choices = event.getProperty("choices", juce::var());
+        if (! choices.isArray() || choices.getArray()->size() == 0)
+            continue;
+
+        juce::var delta = (*choices.getArray())[0].getProperty("delta", juce::var());
+        auto text = delta.getProperty("content", juce::var()).toString();
+        if (text.isEmpty())
+            continue;
+
+        response.content << text;
+
+        // under the lock, so a waiter joining now gets either this delta or a replay
+        // that includes it, never both
+        const juce::ScopedLock sl (lock);
+        request.content << text;
+        for (auto& waiter : request.waiters)
+        {
+            if (waiter.onData == nullptr)
+                continue;
+            auto onData = waiter.onData;
+            deliver(waiter, [onData, text]() { onData(text); });
+        }
+    }
+
+    if (sawEvents)
+        response.body.clear();
+}
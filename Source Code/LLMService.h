@@ -0,0 +1,155 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+
+// The completion endpoint as a single service for the whole process, shared by every
+// plugin instance through juce::SharedResourcePointer (each editor talks to it through
+// an LLMClient). A session full of instances queues its requests in one place instead
+// of every editor opening connections of its own.
+//
+// Requests run on a fixed set of worker threads, which is the global concurrency
+// limit. Every attempt first takes a token from a token bucket, which caps the request
+// rate, and a request whose body matches one already queued or in flight joins that
+// one instead of going out again. Failed attempts back off exponentially. Streamed
+// ("stream": true) replies are read as server-sent events, and each content delta is
+// forwarded as it arrives. Callbacks run on the message thread.
+class LLMService
+{
+public:
+    struct Options
+    {
+        juce::String url { "https://api.openai.com/v1/chat/completions" };
+        juce::String apiKey;
+        int connectionTimeoutMs   { 10000 };
+        int maxAttempts           { 3 };
+        int initialBackoffMs      { 500 };
+        int maxBackoffMs          { 8000 };
+        int maxConcurrentRequests { 4 };
+        double requestsPerMinute  { 60.0 };
+        int burstSize             { 10 };
+        int tokenBudget           { 2000 };   // per request, conversation history included
+
+        // LLMEFFECTS_API_KEY, LLMEFFECTS_API_URL (e.g. a local mock server, see
+        // Tools/MockLLM), LLMEFFECTS_MAX_REQUESTS, LLMEFFECTS_REQUESTS_PER_MINUTE and
+        // LLMEFFECTS_TOKEN_BUDGET.
+        static Options fromEnvironment();
+        bool hasApiKey() const;
+    };
+
+    struct Response
+    {
+        bool succeeded  { false };
+        int statusCode  { 0 };
+        int attempts    { 0 };
+        juce::String body;
+        juce::String content;   // concatenated deltas of a streamed reply, empty otherwise
+        juce::String error;
+    };
+
+    // Latencies are from submission to the last byte, over the last latencyWindow
+    // requests that got an answer.
+    struct Metrics
+    {
+        int queued { 0 };
+        int inFlight { 0 };
+        juce::int64 sent { 0 };        // attempts, retries included
+        juce::int64 completed { 0 };
+        juce::int64 failed { 0 };
+        juce::int64 coalesced { 0 };   // submissions that joined an identical request
+        double lastLatencyMs { 0.0 };
+        double medianLatencyMs { 0.0 };
+        double p95LatencyMs { 0.0 };
+        double meanQueueMs { 0.0 };    // waiting for a worker and a token
+    };
+
+    using Callback = std::function<void (const Response&)>;
+    using DataCallback = std::function<void (const juce::String& delta)>;
+
+    // Whoever submits requests. Shared with callbacks sitting in the message queue, so
+    // they can tell whether it (or its request) has gone away in the meantime.
+    struct Owner
+    {
+        std::atomic<bool> alive { true };
+        std::atomic<int> generation { 0 };
+    };
+
+    LLMService();
+    explicit LLMService (const Options& options);
+    ~LLMService();
+
+    // Queues a JSON request body. onComplete (and onData, for each streamed delta) is
+    // called on the message thread unless the owner cancels first. Joining a request
+    // that is already streaming replays what has arrived so far as one delta.
+    void submit (const std::shared_ptr<Owner>& owner, const juce::String& requestBody,
+                 Callback onComplete, DataCallback onData = nullptr);
+
+    // Drops the owner's requests. One that nobody else is waiting on is abandoned,
+    // which aborts it if it is in flight.
+    void cancel (const std::shared_ptr<Owner>& owner);
+
+    int getNumPending (const Owner& owner) const;
+    const Options& getOptions() const noexcept { return options; }
+    Metrics getMetrics() const;
+
+private:
+    static constexpr int latencyWindow = 64;
+
+    struct Waiter
+    {
+        std::shared_ptr<Owner> owner;
+        int generation { 0 };
+        Callback onComplete;
+        DataCallback onData;
+    };
+
+    struct Request
+    {
+        juce::String body;
+        std::vector<Waiter> waiters;
+        juce::String content;                       // streamed so far, for late joiners
+        juce::WebInputStream* stream { nullptr };
+        double submittedMs { 0.0 };
+        double startedMs { 0.0 };
+    };
+
+    class Worker;
+
+    void runWorker (Worker& worker);
+    Response perform (Worker& worker, Request& request);
+    void readEventStream (Worker& worker, Request& request, juce::WebInputStream& stream, Response& response);
+    void finish (const std::shared_ptr<Request>& request, const Response& response);
+
+    bool isAbandoned (Worker& worker, const Request& request) const;
+    bool waitForToken (Worker& worker, const Request& request);
+    // ms until a token is free, or 0 having taken one; lock held
+    int takeToken();
+    std::shared_ptr<Request> findRequest (const juce::String& body) const;
+    void notifyWorkers();
+
+    static void deliver (const Waiter& waiter, std::function<void()> callback);
+
+    const Options options;
+
+    mutable juce::CriticalSection lock;
+    std::deque<std::shared_ptr<Request>> queue;
+    std::vector<std::shared_ptr<Request>> inFlight;
+
+    double tokens { 0.0 };
+    double lastRefillMs { 0.0 };
+
+    juce::int64 sent { 0 }, completed { 0 }, failed { 0 }, coalesced { 0 };
+    std::array<double, latencyWindow> latencies {};
+    int numLatencies { 0 }, nextLatency { 0 };
+    double lastLatencyMs { 0.0 }, totalQueueMs { 0.0 };
+    juce::int64 numStarted { 0 };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LLMService)
+};
@@ -0,0 +1,211 @@
+#include "LocalResolver.h"
+
+namespace
+{
+    // Bundled examples. "set" replaces values, "adjust" is added to the current ones.
+    const char* bundledCorpus = R"JSON([
+  { "prompts": ["more air", "airier", "add air on top", "more sparkle", "brighter", "make it brighter", "open up the top end"],
+    "adjust": { "eqHigh": 3.0, "damping": -0.15 },
+    "explanation": "Raised the high EQ and reduced damping for a brighter, airier tail." },
+  { "prompts": ["darker", "make it darker", "less bright", "too harsh", "warmer", "softer top end", "less sizzle"],
+    "adjust": { "eqHigh": -3.0, "damping": 0.15 },
+    "explanation": "Lowered the high EQ and increased damping for a darker, warmer tail." },
+  { "prompts": ["less muddy", "cleaner low end", "too boomy", "reduce mud", "thinner"],
+    "adjust": { "eqLow": -3.0, "eqMid": -1.0 },
+    "explanation": "Cut the low and low-mid EQ to clean up the tail." },
+  { "prompts": ["more body", "fuller", "thicker", "more warmth in the lows", "more bass"],
+    "adjust": { "eqLow": 3.0, "density": 0.1 },
+    "explanation": "Boosted the low EQ and density for a fuller tail." },
+  { "prompts": ["tighten the tail", "shorter", "shorter tail", "less decay", "tighter", "too long"],
+    "adjust": { "decayTime": -0.5, "size": -0.15 },
+    "explanation": "Shortened the decay and size for a tighter tail." },
+  { "prompts": ["longer", "longer tail", "more decay", "let it ring", "extend the tail"],
+    "adjust": { "decayTime": 0.7, "size": 0.15 },
+    "explanation": "Lengthened the decay and size so the tail rings out longer." },
+  { "prompts": ["wetter", "more reverb", "more wet", "drench it", "more effect"],
+    "adjust": { "wetDryMix": 0.15 },
+    "explanation": "Increased the wet/dry mix." },
+  { "prompts": ["drier", "less reverb", "more dry", "subtler", "too much reverb", "less effect"],
+    "adjust": { "wetDryMix": -0.15 },
+    "explanation": "Reduced the wet/dry mix." },
+  { "prompts": ["wider", "more stereo", "more spread", "make it wide"],
+    "adjust": { "spread": 0.2 },
+    "explanation": "Increased the stereo spread." },
+  { "prompts": ["narrower", "less wide", "more mono", "less spread"],
+    "adjust": { "spread": -0.2 },
+    "explanation": "Reduced the stereo spread." },
+  { "prompts": ["more movement", "chorus", "more modulation", "shimmer", "lush", "wobble"],
+    "adjust": { "modulation": 1.5, "diffusion": 0.1 },
+    "explanation": "Added modulation and diffusion for a lusher, moving tail." },
+  { "prompts": ["less movement", "no modulation", "static", "less wobble", "stop the chorus"],
+    "set": { "modulation": 0.0 },
+    "explanation": "Turned the modulation off." },
+  { "prompts": ["more pre delay", "more separation", "push the reverb back", "more space before the reverb"],
+    "adjust": { "preDelay": 0.03 },
+    "explanation": "Increased the pre-delay to separate the source from the reverb." },
+  { "prompts": ["less pre delay", "reverb closer", "tighter attack", "less gap"],
+    "adjust": { "preDelay": -0.03 },
+    "explanation": "Reduced the pre-delay so the reverb starts sooner." },
+  { "prompts": ["smoother", "more diffuse", "less grainy", "less metallic", "denser"],
+    "adjust": { "diffusion": 0.15, "density": 0.15 },
+    "explanation": "Raised diffusion and density for a smoother tail." },
+  { "prompts": ["grainier", "more echoes", "less diffuse", "more discrete reflections"],
+    "adjust": { "diffusion": -0.15, "density": -0.15 },
+    "explanation": "Lowered diffusion and density so individual reflections come through." },
+  { "prompts": ["small room", "tight room", "vocal booth", "closet", "dry room"],
+    "set": { "decayTime": 0.4, "preDelay": 0.005, "size": 0.6, "diffusion": 0.4, "density": 0.5, "damping": 0.6, "wetDryMix": 0.25 },
+    "explanation": "Set up a small, tight room." },
+  { "prompts": ["room", "medium room", "live room", "studio room", "natural room"],
+    "set": { "decayTime": 0.9, "preDelay": 0.015, "size": 0.9, "diffusion": 0.5, "density": 0.6, "damping": 0.5, "wetDryMix": 0.3 },
+    "explanation": "Set up a natural medium-sized room." },
+  { "prompts": ["hall", "concert hall", "big hall", "orchestral hall", "large space"],
+    "set": { "decayTime": 2.8, "preDelay": 0.03, "size": 1.6, "diffusion": 0.7, "density": 0.8, "damping": 0.4, "wetDryMix": 0.4 },
+    "explanation": "Set up a large concert hall." },
+  { "prompts": ["cathedral", "church", "huge", "enormous space", "massive reverb", "infinite"],
+    "set": { "decayTime": 4.8, "preDelay": 0.06, "size": 2.0, "diffusion": 0.8, "density": 0.9, "damping": 0.3, "wetDryMix": 0.5 },
+    "explanation": "Set up a huge, cathedral-like space with a very long decay." },
+  { "prompts": ["plate", "vocal plate", "bright plate", "classic plate"],
+    "set": { "decayTime": 1.8, "preDelay": 0.01, "size": 1.0, "diffusion": 0.9, "density": 0.9, "damping": 0.2, "eqHigh": 2.0, "wetDryMix": 0.35 },
+    "explanation": "Set up a bright, dense plate." },
+  { "prompts": ["chamber", "echo chamber", "vintage chamber"],
+    "set": { "decayTime": 1.4, "preDelay": 0.02, "size": 1.1, "diffusion": 0.6, "density": 0.7, "damping": 0.55, "eqLow": -1.0, "wetDryMix": 0.35 },
+    "explanation": "Set up a vintage echo chamber." },
+  { "prompts": ["ambient", "pad", "washy", "dreamy", "ethereal", "atmospheric"],
+    "set": { "decayTime": 4.0, "preDelay": 0.08, "size": 1.8, "diffusion": 0.85, "density": 0.85, "damping": 0.35, "modulation": 2.0, "spread": 0.9, "wetDryMix": 0.6 },
+    "explanation": "Set up a long, modulated ambient wash." },
+  { "prompts": ["slapback", "short slap", "rockabilly"],
+    "set": { "decayTime": 0.3, "preDelay": 0.1, "size": 0.5, "diffusion": 0.1, "density": 0.2, "damping": 0.5, "wetDryMix": 0.3 },
+    "explanation": "Set up a short slapback-style reflection." },
+  { "prompts": ["drums", "drum room", "snare reverb", "punchy drums"],
+    "set": { "decayTime": 1.0, "preDelay": 0.01, "size": 0.9, "diffusion": 0.6, "density": 0.8, "damping": 0.5, "eqLow": -2.0, "wetDryMix": 0.3 },
+    "explanation": "Set up a punchy drum room with the lows kept in check." },
+  { "prompts": ["reset", "default", "start over", "back to default"],
+    "set": { "decayTime": 1.0, "preDelay": 0.05, "size": 1.0, "diffusion": 0.5, "density": 0.5, "damping": 0.5, "eqLow": 0.0, "eqMid": 0.0, "eqHigh": 0.0, "spread": 0.5, "modulation": 0.0, "wetDryMix": 0.5 },
+    "explanation": "Reset every parameter to its default." }
+])JSON";
+
+    bool isStopWord (const juce::String& word)
+    {
+        static const char* stopWords[] = { "a", "an", "the", "it", "and", "to", "of", "please", "make", "with",
+                                           "some", "bit", "little", "my", "this", "that", "is", "be", "can", "you", "me" };
+        for (auto* stop : stopWords)
+            if (word == stop)
+                return true;
+        return false;
+    }
+
+    juce::uint32 hashFeature (const juce::String& feature)
+    {
+        // FNV-1a
+        juce::uint32 hash = 2166136261u;
+        for (auto* p = feature.toRawUTF8(); *p != 0; ++p)
+            hash = (hash ^ (juce::uint8) *p) * 16777619u;
+        return hash;
+    }
+}
+
+LocalResolver::LocalResolver()
+    : LocalResolver (juce::String (bundledCorpus))
+{
+}
+
+LocalResolver::LocalResolver (const juce::String& corpusJson)
+{
+    loadCorpus(corpusJson);
+}
+
+void LocalResolver::loadCorpus (const juce::String& corpusJson)
+{
+    auto corpus = juce::JSON::parse(corpusJson);
+    if (! corpus.isArray())
+        return;
+
+    for (auto& item : *corpus.getArray())
+    {
+        Entry entry;
+        entry.set = item.getProperty("set", juce::var());
+        entry.adjust = item.getProperty("adjust", juce::var());
+        entry.explanation = item.getProperty("explanation", juce::var()).toString();
+        entries.push_back(entry);
+
+        if (auto* prompts = item.getProperty("prompts", juce::var()).getArray())
+            for (auto& prompt : *prompts)
+                examples.push_back({ prompt.toString(), embed(prompt.toString()), static_cast<int>(entries.size()) - 1 });
+    }
+}
+
+// Hashed bag of words plus character trigrams, so "brighter" still lands near "bright".
+LocalResolver::Embedding LocalResolver::embed (const juce::String& text)
+{
+    Embedding embedding {};
+
+    auto words = juce::StringArray::fromTokens(text.toLowerCase().retainCharacters("abcdefghijklmnopqrstuvwxyz0123456789 "), " ", {});
+    for (auto& word : words)
+    {
+        if (word.isEmpty() || isStopWord(word))
+            continue;
+
+        embedding[hashFeature(word) % numDimensions] += 1.0f;
+
+        auto padded = "^" + word + "$";
+        for (int i = 0; i + 3 <= padded.length(); ++i)
+            embedding[hashFeature(padded.substring(i, i + 3)) % numDimensions] += 0.3f;
+    }
+
+    float norm = 0.0f;
+    for (auto v : embedding)
+        norm += v * v;
+
+    if (norm > 0.0f)
+    {
+        float scale = 1.0f / std::sqrt(norm);
+        for (auto& v : embedding)
+            v *= scale;
+    }
+    return embedding;
+}
+
+LocalResolver::Result LocalResolver::resolve (const juce::String& prompt, const ReverbParameters& current) const
+{
+    Result result;
+    result.parameters = current;
+
+    auto query = embed(prompt);
+    const Example* best = nullptr;
+    float bestScore = 0.0f;
+
+    for (auto& example : examples)
+    {
+        float score = 0.0f;
+        for (int i = 0; i < numDimensions; ++i)
+            score += query[(size_t) i] * example.embedding[(size_t) i];
+
+        if (score > bestScore)
+        {
+            bestScore = score;
+            best = &example;
+        }
+    }
+
+    result.score = bestScore;
+    if (best == nullptr || bestScore < minimumScore)
+        return result;
+
+    auto& entry = entries[(size_t) best->entryIndex];
+    auto parameters = ReverbParameters::fromVar(entry.set, current);
+    if (auto* adjust = entry.adjust.getDynamicObject())
+    {
+        for (auto& property : adjust->getProperties())
+        {
+            int index = ReverbParameters::indexOf(property.name.toString());
+            if (index >= 0)
+                parameters[index] += (float) static_cast<double>(property.value);
+        }
+    }
+
+    result.matched = true;
+    result.parameters = parameters.clamped();
+    result.explanation = entry.explanation;
+    result.matchedPrompt = best->prompt;
+    return result;
+}
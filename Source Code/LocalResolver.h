@@ -0,0 +1,60 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <vector>
+#include "ReverbParameters.h"
+
+// Offline prompt -> parameters resolver. Prompts are embedded as hashed bags of words
+// and character trigrams, and matched against a bundled corpus of example prompts by
+// cosine similarity. Each corpus entry either sets absolute values ("cathedral") or
+// nudges the current ones ("more air"). A lookup takes a few microseconds, so the
+// result can be applied straight away while the LLM (if reachable) refines it later.
+class LocalResolver
+{
+public:
+    struct Result
+    {
+        bool matched { false };
+        float score { 0.0f };
+        ReverbParameters parameters;
+        juce::String explanation;
+        juce::String matchedPrompt;
+    };
+
+    LocalResolver();
+    explicit LocalResolver (const juce::String& corpusJson);
+
+    Result resolve (const juce::String& prompt, const ReverbParameters& current) const;
+
+    int getNumExamples() const { return static_cast<int>(examples.size()); }
+
+    // matches scoring below this are treated as "no idea"
+    static constexpr float minimumScore = 0.35f;
+
+private:
+    static constexpr int numDimensions = 512;
+    using Embedding = std::array<float, numDimensions>;
+
+    struct Example
+    {
+        juce::String prompt;
+        Embedding embedding;
+        int entryIndex;
+    };
+
+    struct Entry
+    {
+        juce::var set;      // absolute values
+        juce::var adjust;   // deltas added to the current values
+        juce::String explanation;
+    };
+
+    static Embedding embed (const juce::String& text);
+    void loadCorpus (const juce::String& corpusJson);
+
+    std::vector<Entry> entries;
+    std::vector<Example> examples;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LocalResolver)
+};
@@ -0,0 +1,176 @@
+#include "PerformanceMonitor.h"
+
+class PerformanceMonitor::DumpThread  : public juce::Thread
+{
+public:
+    DumpThread (PerformanceMonitor& m, const juce::File& dir, const juce::String& name, int interval)
+        : juce::Thread ("Perf dump"), monitor (m), directory (dir), baseName (name), intervalMs (interval)
+    {
+    }
+
+    void run() override
+    {
+        while (! threadShouldExit())
+        {
+            wait(intervalMs);
+            auto snapshot = monitor.getSnapshot();
+            directory.createDirectory();
+            writeCSV(snapshot, directory.getChildFile(baseName + ".csv"));
+            writeJSON(snapshot, directory.getChildFile(baseName + ".json"));
+        }
+    }
+
+private:
+    PerformanceMonitor& monitor;
+    const juce::File directory;
+    const juce::String baseName;
+    const int intervalMs;
+};
+
+PerformanceMonitor::PerformanceMonitor()
+{
+    records.resize((size_t) ringSize);
+}
+
+PerformanceMonitor::~PerformanceMonitor()
+{
+    stopPeriodicDump();
+}
+
+void PerformanceMonitor::prepare (double sampleRate)
+{
+    fifo.reset();
+    dropped.store(0);
+    referenceCycles = readCycleCounter();
+    referenceTicks = juce::Time::getHighResolutionTicks();
+
+    const juce::ScopedLock sl (statsLock);
+    stats = Snapshot();
+    stats.sampleRate = sampleRate;
+    totalBusySeconds = totalAudioSeconds = 0.0;
+}
+
+double PerformanceMonitor::getCyclesPerSecond() const
+{
+    auto elapsedTicks = juce::Time::getHighResolutionTicks() - referenceTicks;
+    auto ticksPerSecond = juce::Time::getHighResolutionTicksPerSecond();
+
+    // under 100 ms the two clocks' read jitter would still show in the ratio
+    if (referenceTicks == 0 || elapsedTicks * 10 < ticksPerSecond)
+        return 0.0;
+    return (double) (readCycleCounter() - referenceCycles) * (double) ticksPerSecond / (double) elapsedTicks;
+}
+
+void PerformanceMonitor::collect()
+{
+    // records wait in the ring until the counter's rate is known
+    double cyclesPerSecond = getCyclesPerSecond();
+    if (cyclesPerSecond <= 0.0)
+        return;
+
+    int start1, size1, start2, size2;
+    fifo.prepareToRead(fifo.getNumReady(), start1, size1, start2, size2);
+
+    const juce::ScopedLock sl (statsLock);
+    if (stats.sampleRate <= 0.0)
+    {
+        fifo.finishedRead(size1 + size2);
+        return;
+    }
+
+    double busySeconds = 0.0, audioSeconds = 0.0;
+    auto accumulate = [&] (int start, int size)
+    {
+        for (int i = start; i < start + size; ++i)
+        {
+            auto& r = records[(size_t) i];
+            double seconds = (double) r.cycles / cyclesPerSecond;
+            double deadline = (double) juce::jmax(1, r.numSamples) / stats.sampleRate;
+            double load = seconds / deadline;
+
+            ++stats.blocks;
+            if (load > 1.0)
+                ++stats.overruns;
+            if (load > stats.worstLoad)
+            {
+                stats.worstLoad = load;
+                stats.worstBlockSeconds = seconds;
+            }
+            ++stats.histogram[(size_t) juce::jmin(numBuckets - 1, static_cast<int>(load / bucketWidth))];
+
+            busySeconds += seconds;
+            audioSeconds += deadline;
+        }
+    };
+    accumulate(start1, size1);
+    accumulate(start2, size2);
+    fifo.finishedRead(size1 + size2);
+
+    // an idle host sends no blocks, which reads as no load
+    double load = audioSeconds > 0.0 ? busySeconds / audioSeconds : 0.0;
+    stats.recentLoad += 0.25 * (load - stats.recentLoad);
+    totalBusySeconds += busySeconds;
+    totalAudioSeconds += audioSeconds;
+    stats.averageLoad = totalAudioSeconds > 0.0 ? totalBusySeconds / totalAudioSeconds : 0.0;
+    stats.dropped = dropped.load(std::memory_order_relaxed);
+}
+
+PerformanceMonitor::Snapshot PerformanceMonitor::getSnapshot() const
+{
+    const juce::ScopedLock sl (statsLock);
+    return stats;
+}
+
+bool PerformanceMonitor::writeCSV (const Snapshot& snapshot, const juce::File& file)
+{
+    juce::String csv;
+    csv << "# blocks=" << snapshot.blocks << " overruns=" << snapshot.overruns << " dropped=" << snapshot.dropped
+        << " averageLoad=" << snapshot.averageLoad << " worstLoad=" << snapshot.worstLoad << "\n";
+    csv << "loadFromPercent,loadToPercent,blocks\n";
+    for (int i = 0; i < numBuckets; ++i)
+    {
+        double from = i * bucketWidth * 100.0;
+        csv << from << "," << (i + 1 < numBuckets ? juce::String(from + bucketWidth * 100.0) : juce::String("inf"))
+            << "," << snapshot.histogram[(size_t) i] << "\n";
+    }
+    return file.replaceWithText(csv);
+}
+
+bool PerformanceMonitor::writeJSON (const Snapshot& snapshot, const juce::File& file)
+{
+    juce::DynamicObject::Ptr root = new juce::DynamicObject();
+    root->setProperty("sampleRate", snapshot.sampleRate);
+    root->setProperty("blocks", snapshot.blocks);
+    root->setProperty("overruns", snapshot.overruns);
+    root->setProperty("dropped", snapshot.dropped);
+    root->setProperty("recentLoad", snapshot.recentLoad);
+    root->setProperty("averageLoad", snapshot.averageLoad);
+    root->setProperty("worstLoad", snapshot.worstLoad);
+    root->setProperty("worstBlockSeconds", snapshot.worstBlockSeconds);
+    root->setProperty("bucketWidth", bucketWidth);
+
+    juce::Array<juce::var> histogram;
+    for (auto count : snapshot.histogram)
+        histogram.add(count);
+    root->setProperty("histogram", histogram);
+
+    return file.replaceWithText(juce::JSON::toString(juce::var(root.get())));
+}
+
+void PerformanceMonitor::startPeriodicDump (const juce::File& directory, const juce::String& baseName, int intervalMs)
+{
+    stopPeriodicDump();
+    dumpThread = std::make_unique<DumpThread>(*this, directory, baseName, juce::jmax(100, intervalMs));
+    dumpThread->startThread(juce::Thread::Priority::background);
+}
+
+void PerformanceMonitor::stopPeriodicDump()
+{
+    if (dumpThread != nullptr)
+    {
+        dumpThread->signalThreadShouldExit();
+        dumpThread->notify();
+        dumpThread->stopThread(2000);
+        dumpThread.reset();
+    }
+}
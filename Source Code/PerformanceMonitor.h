@@ -0,0 +1,137 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#if JUCE_INTEL
+ #if JUCE_MSVC
+  #include <intrin.h>
+ #else
+  #include <x86intrin.h>
+ #endif
+#endif
+
+// Block timing is on unless the build sets LLMEFFECTS_PERF_MONITOR=0, which removes
+// it from the processor entirely: no counter reads, no ring buffer, no editor readout.
+#ifndef LLMEFFECTS_PERF_MONITOR
+ #define LLMEFFECTS_PERF_MONITOR 1
+#endif
+
+// Per-instance DSP load. The audio thread reads the CPU's cycle counter either side of
+// processBlock and pushes (cycles, samples) into a lock-free single-producer ring; that
+// is all it does. collect() drains the ring on another thread and turns the cycles into
+// load against each block's deadline (numSamples / sampleRate), a load histogram and an
+// overrun count. Snapshots and the CSV/JSON dumps can be taken from any thread.
+class PerformanceMonitor
+{
+public:
+    // load buckets of 2% from 0 to 200%, and a last one for anything slower
+    static constexpr int numBuckets = 101;
+    static constexpr double bucketWidth = 0.02;
+
+    struct Snapshot
+    {
+        double sampleRate { 0.0 };
+        juce::int64 blocks { 0 };
+        juce::int64 overruns { 0 };        // blocks that took longer than they last
+        juce::int64 dropped { 0 };         // records lost to a full ring
+        double recentLoad { 0.0 };         // smoothed over the last few collect() calls
+        double averageLoad { 0.0 };
+        double worstLoad { 0.0 };
+        double worstBlockSeconds { 0.0 };
+        std::array<juce::int64, numBuckets> histogram {};
+    };
+
+    PerformanceMonitor();
+    ~PerformanceMonitor();
+
+    // Clears the statistics. Not real-time safe; call while the audio thread is stopped.
+    void prepare (double sampleRate);
+
+    // Audio thread only.
+    static juce::uint64 readCycleCounter() noexcept
+    {
+       #if JUCE_INTEL
+        return (juce::uint64) __rdtsc();
+       #elif JUCE_ARM && JUCE_64BIT && ! JUCE_MSVC
+        juce::uint64 value;
+        asm volatile ("mrs %0, cntvct_el0" : "=r" (value));
+        return value;
+       #else
+        return (juce::uint64) juce::Time::getHighResolutionTicks();
+       #endif
+    }
+
+    void record (juce::uint64 startCycles, int numSamples) noexcept
+    {
+        auto cycles = readCycleCounter() - startCycles;
+        int start1, size1, start2, size2;
+        fifo.prepareToWrite(1, start1, size1, start2, size2);
+        if (size1 + size2 == 0)
+        {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        records[(size_t) (size1 > 0 ? start1 : start2)] = { cycles, numSamples };
+        fifo.finishedWrite(1);
+    }
+
+    // Times the enclosing scope, e.g. the body of processBlock.
+    struct ScopedBlockTimer
+    {
+        ScopedBlockTimer (PerformanceMonitor& m, int n) noexcept : monitor (m), numSamples (n), start (readCycleCounter()) {}
+        ~ScopedBlockTimer() { monitor.record(start, numSamples); }
+
+        PerformanceMonitor& monitor;
+        int numSamples;
+        juce::uint64 start;
+    };
+
+    // Drains the ring into the statistics. Any one thread at a time, e.g. a timer.
+    void collect();
+    Snapshot getSnapshot() const;
+
+    static bool writeCSV (const Snapshot& snapshot, const juce::File& file);
+    static bool writeJSON (const Snapshot& snapshot, const juce::File& file);
+
+    // Rewrites <directory>/<baseName>.csv and .json from a background thread every
+    // intervalMs, for offline analysis of a long session.
+    void startPeriodicDump (const juce::File& directory, const juce::String& baseName, int intervalMs);
+    void stopPeriodicDump();
+
+private:
+    struct Record
+    {
+        juce::uint64 cycles;
+        int numSamples;
+    };
+
+    static constexpr int ringSize = 4096;
+    juce::AbstractFifo fifo { ringSize };
+    std::vector<Record> records;
+    std::atomic<juce::int64> dropped { 0 };
+
+    // The counter's rate isn't known up front, so it is measured against the
+    // high-resolution clock over the time since prepare().
+    juce::uint64 referenceCycles { 0 };
+    juce::int64 referenceTicks { 0 };
+    double getCyclesPerSecond() const;
+
+    mutable juce::CriticalSection statsLock;
+    Snapshot stats;
+    double totalBusySeconds { 0.0 }, totalAudioSeconds { 0.0 };
+
+    class DumpThread;
+    std::unique_ptr<DumpThread> dumpThread;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PerformanceMonitor)
+};
+
+#if LLMEFFECTS_PERF_MONITOR
+ #define LLMEFFECTS_TIME_BLOCK(monitor, numSamples) const PerformanceMonitor::ScopedBlockTimer blockTimer_ (monitor, numSamples)
+#else
+ #define LLMEFFECTS_TIME_BLOCK(monitor, numSamples)
+#endif
@@ -1,6 +1,16 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
 
+namespace
+{
+    const char* const greeting = "Hey! Describe how you'd like your reverb to sound.\n";
+
+    juce::String getCandidateName (int index)
+    {
+        return juce::String::charToString((juce::juce_wchar) ('A' + index));
+    }
+}
+
 LLMEffectsAudioProcessorEditor::LLMEffectsAudioProcessorEditor (LLMEffectsAudioProcessor& p)
     : AudioProcessorEditor (&p), audioProcessor (p)
 {
@@ -10,8 +20,9 @@ LLMEffectsAudioProcessorEditor::LLMEffectsAudioProcessorEditor (LLMEffectsAudioP
     chatHistory.setMultiLine(true);
     chatHistory.setReadOnly(true);
     chatHistory.setScrollbarsShown(true);
-    chatHistory.setText("Hey! Describe how you'd like your reverb to sound.\n");
     addAndMakeVisible(chatHistory);
+    showChatHistory();
+    audioProcessor.getChatHistory().addChangeListener(this);
 
     messageBox.setMultiLine(false);
     messageBox.setReturnKeyStartsNewLine(false);
@@ -23,68 +34,76 @@ LLMEffectsAudioProcessorEditor::LLMEffectsAudioProcessorEditor (LLMEffectsAudioP
     sendButton.addListener(this);
     addAndMakeVisible(sendButton);
 
-    auto setupSlider = [this](juce::Slider& slider, juce::Label& label, const juce::String& name)
+    for (int i = 0; i < numCandidates; ++i)
+    {
+        candidateButtons[(size_t) i].setButtonText(getCandidateName(i));
+        candidateButtons[(size_t) i].addListener(this);
+        addChildComponent(candidateButtons[(size_t) i]);
+    }
+    useCandidateButton.addListener(this);
+    addChildComponent(useCandidateButton);
+    previewRenderer.onPreviewsChanged = [this] { updateAudition(); };
+
+    auto setupSlider = [this](juce::Slider& slider, juce::Label& label, const juce::String& name, int parameterIndex)
     {
         slider.setSliderStyle(juce::Slider::Rotary);
         slider.setTextBoxStyle(juce::Slider::TextBoxBelow, true, 50, 20);
-        slider.addListener(this);
         addAndMakeVisible(slider);
+        sliderAttachments.add(new juce::AudioProcessorValueTreeState::SliderAttachment(
+            audioProcessor.getValueTreeState(), ReverbParameters::getInfo(parameterIndex).id, slider));
 
         label.setText(name, juce::dontSendNotification);
         label.setJustificationType(juce::Justification::centred);
         addAndMakeVisible(label);
     };
 
-    setupSlider(decayTimeSlider,   decayTimeLabel,   "Decay Time (s)");
-    decayTimeSlider.setRange(0.1, 5.0, 0.01);
-    decayTimeSlider.setValue(audioProcessor.getDecayTime());
-
-    setupSlider(preDelaySlider,    preDelayLabel,    "Pre-Delay (s)");
-    preDelaySlider.setRange(0.0, 0.5, 0.001);
-    preDelaySlider.setValue(audioProcessor.getPreDelay());
+    setupSlider(decayTimeSlider,   decayTimeLabel,   "Decay Time (s)", ReverbParameters::decayTimeIndex);
+    setupSlider(preDelaySlider,    preDelayLabel,    "Pre-Delay (s)",  ReverbParameters::preDelayIndex);
+    setupSlider(sizeSlider,        sizeLabel,        "Size",           ReverbParameters::sizeIndex);
+    setupSlider(diffusionSlider,   diffusionLabel,   "Diffusion",      ReverbParameters::diffusionIndex);
+    setupSlider(densitySlider,     densityLabel,     "Density",        ReverbParameters::densityIndex);
+    setupSlider(dampingSlider,     dampingLabel,     "Damping",        ReverbParameters::dampingIndex);
+    setupSlider(eqLowSlider,       eqLowLabel,       "EQ Low (dB)",    ReverbParameters::eqLowIndex);
+    setupSlider(eqMidSlider,       eqMidLabel,       "EQ Mid (dB)",    ReverbParameters::eqMidIndex);
+    setupSlider(eqHighSlider,      eqHighLabel,      "EQ High (dB)",   ReverbParameters::eqHighIndex);
+    setupSlider(spreadSlider,      spreadLabel,      "Spread",         ReverbParameters::spreadIndex);
+    setupSlider(modulationSlider,  modulationLabel,  "Modulation",     ReverbParameters::modulationIndex);
+    setupSlider(wetDryMixSlider,   wetDryMixLabel,   "Wet/Dry",        ReverbParameters::wetDryMixIndex);
+    setupSlider(eqLowFrequencySlider,  eqLowFrequencyLabel,  "Low/Mid (Hz)",  ReverbParameters::eqLowFrequencyIndex);
+    setupSlider(eqHighFrequencySlider, eqHighFrequencyLabel, "Mid/High (Hz)", ReverbParameters::eqHighFrequencyIndex);
 
-    setupSlider(sizeSlider,        sizeLabel,        "Size");
-    sizeSlider.setRange(0.5, 2.0, 0.01);
-    sizeSlider.setValue(audioProcessor.getSize());
+    engineBox.addItemList({ "Legacy", "FDN", "Convolution" }, 1);
+    addAndMakeVisible(engineBox);
+    engineAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(
+        audioProcessor.getValueTreeState(), LLMEffectsAudioProcessor::engineParameterID, engineBox);
+    engineLabel.setJustificationType(juce::Justification::centredRight);
+    addAndMakeVisible(engineLabel);
 
-    setupSlider(diffusionSlider,   diffusionLabel,   "Diffusion");
-    diffusionSlider.setRange(0.0, 1.0, 0.01);
-    diffusionSlider.setValue(audioProcessor.getDiffusion());
+    presetSearch.setTextToShowWhenEmpty("Search or name a preset", juce::Colours::grey);
+    presetSearch.addListener(this);
+    addAndMakeVisible(presetSearch);
+    presetBox.setTextWhenNothingSelected("Presets");
+    presetBox.onChange = [this] { loadSelectedPreset(); };
+    addAndMakeVisible(presetBox);
+    savePresetButton.addListener(this);
+    addAndMakeVisible(savePresetButton);
+    refreshPresetList();
 
-    setupSlider(densitySlider,     densityLabel,     "Density");
-    densitySlider.setRange(0.0, 1.0, 0.01);
-    densitySlider.setValue(audioProcessor.getDensity());
-
-    setupSlider(dampingSlider,     dampingLabel,     "Damping");
-    dampingSlider.setRange(0.0, 1.0, 0.01);
-    dampingSlider.setValue(audioProcessor.getDamping());
-
-    setupSlider(eqLowSlider, eqLowLabel, "EQ Low (dB)");
-    eqLowSlider.setRange(-12.0, 12.0, 0.1);
-    eqLowSlider.setValue(audioProcessor.getEQLow());
-
-    setupSlider(eqMidSlider, eqMidLabel, "EQ Mid (dB)");
-    eqMidSlider.setRange(-12.0, 12.0, 0.1);
-    eqMidSlider.setValue(audioProcessor.getEQMid());
-
-    setupSlider(eqHighSlider, eqHighLabel, "EQ High (dB)");
-    eqHighSlider.setRange(-12.0, 12.0, 0.1);
-    eqHighSlider.setValue(audioProcessor.getEQHigh());
-
-    setupSlider(spreadSlider,      spreadLabel,      "Spread");
-    spreadSlider.setRange(0.0, 1.0, 0.01);
-    spreadSlider.setValue(audioProcessor.getSpread());
-
-    setupSlider(modulationSlider,  modulationLabel,  "Modulation");
-    modulationSlider.setRange(0.0, 10.0, 0.1);
-    modulationSlider.setValue(audioProcessor.getModulation());
-
-    setupSlider(wetDryMixSlider,   wetDryMixLabel,   "Wet/Dry");
-    wetDryMixSlider.setRange(0.0, 1.0, 0.01);
-    wetDryMixSlider.setValue(audioProcessor.getWetDryMix());
+   #if LLMEFFECTS_PERF_MONITOR
+    performanceLabel.setJustificationType(juce::Justification::centredRight);
+    performanceLabel.setFont(12.0f);
+    addAndMakeVisible(performanceLabel);
+    startTimerHz(4);
+   #endif
 }
 
-LLMEffectsAudioProcessorEditor::~LLMEffectsAudioProcessorEditor() {}
+LLMEffectsAudioProcessorEditor::~LLMEffectsAudioProcessorEditor()
+{
+    stopTimer();
+    audioProcessor.getChatHistory().removeChangeListener(this);
+    // nothing would be left to stop it
+    audioProcessor.stopAudition();
+}
 
 void LLMEffectsAudioProcessorEditor::paint (juce::Graphics& g)
 {
@@ -97,15 +116,34 @@ void LLMEffectsAudioProcessorEditor::resized()
 
     
     auto chatArea = bounds.removeFromLeft(bounds.getWidth() * 0.6);
-    chatHistory.setBounds(chatArea.removeFromTop(getHeight() - 50).reduced(10));
+    chatHistory.setBounds(chatArea.removeFromTop(getHeight() - 80).reduced(10));
+    auto candidateArea = chatArea.removeFromTop(30).reduced(10, 0);
+    useCandidateButton.setBounds(candidateArea.removeFromRight(60));
+    for (auto& button : candidateButtons)
+    {
+        button.setBounds(candidateArea.removeFromLeft(50));
+        candidateArea.removeFromLeft(4);
+    }
     auto bottomChat = chatArea.reduced(10);
     messageBox.setBounds(bottomChat.removeFromLeft(chatArea.getWidth() - 80));
     sendButton.setBounds(bottomChat);
 
     
     auto reverbArea = bounds.reduced(10);
+    auto engineArea = reverbArea.removeFromTop(30);
+    engineBox.setBounds(engineArea.removeFromRight(engineArea.getWidth() / 2).reduced(0, 3));
+    engineLabel.setBounds(engineArea);
+    auto presetArea = reverbArea.removeFromTop(30).reduced(0, 3);
+    savePresetButton.setBounds(presetArea.removeFromRight(50));
+    presetArea.removeFromRight(4);
+    presetSearch.setBounds(presetArea.removeFromLeft(presetArea.getWidth() / 2));
+    presetArea.removeFromLeft(4);
+    presetBox.setBounds(presetArea);
+   #if LLMEFFECTS_PERF_MONITOR
+    performanceLabel.setBounds(reverbArea.removeFromBottom(18));
+   #endif
     int numCols = 4;
-    int numRows = 3;
+    int numRows = 4;
     int sliderWidth = reverbArea.getWidth() / numCols;
     int sliderHeight = reverbArea.getHeight() / numRows;
     int labelHeight = 20;
@@ -124,7 +162,9 @@ void LLMEffectsAudioProcessorEditor::resized()
         { &eqHighSlider,      &eqHighLabel },
         { &spreadSlider,      &spreadLabel },
         { &modulationSlider,  &modulationLabel },
-        { &wetDryMixSlider,   &wetDryMixLabel }
+        { &wetDryMixSlider,   &wetDryMixLabel },
+        { &eqLowFrequencySlider,  &eqLowFrequencyLabel },
+        { &eqHighFrequencySlider, &eqHighFrequencyLabel }
     };
     int numKnobs = sizeof(knobs) / sizeof(knobs[0]);
     for (int i = 0; i < numKnobs; ++i)
@@ -142,6 +182,14 @@ void LLMEffectsAudioProcessorEditor::buttonClicked (juce::Button* button)
 {
     if (button == &sendButton)
         sendMessage();
+    else if (button == &savePresetButton)
+        saveCurrentPreset();
+    else if (button == &useCandidateButton)
+        useSelectedCandidate();
+
+    for (int i = 0; i < numCandidates; ++i)
+        if (button == &candidateButtons[(size_t) i])
+            selectCandidate(i);
 }
 
 void LLMEffectsAudioProcessorEditor::textEditorReturnKeyPressed (juce::TextEditor& editor)
@@ -150,32 +198,88 @@ void LLMEffectsAudioProcessorEditor::textEditorReturnKeyPressed (juce::TextEdito
         sendMessage();
 }
 
-void LLMEffectsAudioProcessorEditor::sliderValueChanged (juce::Slider* slider)
+void LLMEffectsAudioProcessorEditor::textEditorTextChanged (juce::TextEditor& editor)
+{
+    if (&editor == &presetSearch)
+        refreshPresetList();
+}
+
+void LLMEffectsAudioProcessorEditor::addToChat (ChatHistory::Role role, const juce::String& text)
+{
+    audioProcessor.getChatHistory().add(role, text);
+    chatHistory.moveCaretToEnd();
+    chatHistory.insertTextAtCaret("\n" + ChatHistory::format({ role, text }) + "\n");
+}
+
+void LLMEffectsAudioProcessorEditor::showChatHistory()
+{
+    juce::String transcript (greeting);
+    for (auto& message : audioProcessor.getChatHistory().getMessages())
+        transcript << "\n" << ChatHistory::format(message) << "\n";
+    chatHistory.setText(transcript);
+    chatHistory.moveCaretToEnd();
+}
+
+void LLMEffectsAudioProcessorEditor::changeListenerCallback (juce::ChangeBroadcaster* source)
+{
+    if (source == &audioProcessor.getChatHistory())
+        showChatHistory();
+}
+
+void LLMEffectsAudioProcessorEditor::timerCallback()
+{
+   #if LLMEFFECTS_PERF_MONITOR
+    auto stats = audioProcessor.getPerformanceMonitor().getSnapshot();
+    juce::String text ("DSP " + juce::String(stats.recentLoad * 100.0, 1) + "%   worst block "
+                           + juce::String(stats.worstLoad * 100.0, 1) + "%   overruns "
+                           + juce::String(stats.overruns));
+
+    // the shared client's, across every instance in the process
+    auto llm = llmClient.getMetrics();
+    if (llm.sent > 0)
+        text << "   LLM " << juce::roundToInt(llm.medianLatencyMs) << " ms (p95 " << juce::roundToInt(llm.p95LatencyMs)
+             << "), " << llm.queued << " queued";
+    performanceLabel.setText(text, juce::dontSendNotification);
+   #endif
+}
+
+void LLMEffectsAudioProcessorEditor::refreshPresetList()
 {
-    if (slider == &decayTimeSlider)
-        audioProcessor.setDecayTime((float)decayTimeSlider.getValue());
-    else if (slider == &preDelaySlider)
-        audioProcessor.setPreDelay((float)preDelaySlider.getValue());
-    else if (slider == &sizeSlider)
-        audioProcessor.setSize((float)sizeSlider.getValue());
-    else if (slider == &diffusionSlider)
-        audioProcessor.setDiffusion((float)diffusionSlider.getValue());
-    else if (slider == &densitySlider)
-        audioProcessor.setDensity((float)densitySlider.getValue());
-    else if (slider == &dampingSlider)
-        audioProcessor.setDamping((float)dampingSlider.getValue());
-    else if (slider == &eqLowSlider)
-        audioProcessor.setEQLow((float)eqLowSlider.getValue());
-    else if (slider == &eqMidSlider)
-        audioProcessor.setEQMid((float)eqMidSlider.getValue());
-    else if (slider == &eqHighSlider)
-        audioProcessor.setEQHigh((float)eqHighSlider.getValue());
-    else if (slider == &spreadSlider)
-        audioProcessor.setSpread((float)spreadSlider.getValue());
-    else if (slider == &modulationSlider)
-        audioProcessor.setModulation((float)modulationSlider.getValue());
-    else if (slider == &wetDryMixSlider)
-        audioProcessor.setWetDryMix((float)wetDryMixSlider.getValue());
+    presetMatches = presetBank->search(presetSearch.getText());
+    presetBox.clear(juce::dontSendNotification);
+    for (size_t i = 0; i < presetMatches.size(); ++i)
+        presetBox.addItem(presetBank->getPreset(presetMatches[i]).name, (int) i + 1);
+}
+
+void LLMEffectsAudioProcessorEditor::loadSelectedPreset()
+{
+    int item = presetBox.getSelectedItemIndex();
+    if (! juce::isPositiveAndBelow(item, (int) presetMatches.size()))
+        return;
+
+    auto preset = presetBank->getPreset(presetMatches[(size_t) item]);
+    audioProcessor.recallPreset(preset.parameters, preset.engine);
+}
+
+void LLMEffectsAudioProcessorEditor::saveCurrentPreset()
+{
+    auto name = presetSearch.getText().trim();
+    if (name.isEmpty())
+    {
+        addToChat(ChatHistory::Role::notice, "Type a name in the preset box to save the current sound.");
+        return;
+    }
+
+    // the explanation of how we got here makes the preset findable by what it sounds like
+    PresetBank::Preset preset;
+    preset.name = name;
+    preset.description = audioProcessor.getChatHistory().getLastExplanation();
+    preset.parameters = audioProcessor.getCurrentParameters();
+    preset.engine = audioProcessor.getEngine();
+
+    if (! presetBank->store(preset))
+        addToChat(ChatHistory::Role::notice, "Couldn't write the preset bank.");
+    refreshPresetList();
 }
 
 //llm
@@ -184,153 +288,312 @@ void LLMEffectsAudioProcessorEditor::sendMessage()
     juce::String userMessage = messageBox.getText().trim();
     if (userMessage.isNotEmpty())
     {
-        chatHistory.moveCaretToEnd();
-        chatHistory.insertTextAtCaret("\nYou: " + userMessage + "\n");
+        addToChat(ChatHistory::Role::user, userMessage);
         messageBox.clear();
+        clearCandidates();
         
+        juce::String model = "gpt-4o-mini";
+        auto currentParameters = audioProcessor.getCurrentParameters();
+
+        // The system message never changes, so it is escaped once, and every turn of the
+        // conversation was serialised when it happened; a request is put together from
+        // those finished pieces, with as much history as the token budget allows.
+        static const juce::String systemFragment = []
+        {
+            juce::String systemMessage = "You are an audio plugin parameter modifier. When given a JSON payload containing 'currentParameters' and 'userPrompt', respond strictly with a valid JSON object containing exactly one key, 'candidates': an array of " + juce::String(numCandidates) + " distinct interpretations of the prompt, best first. Each candidate is an object with exactly two keys: 'parameters' and 'explanation'. The 'parameters' object must include only numeric values for the reverb parameters, and the 'explanation' should be a concise string that describes what changes you made. Do not include any additional text, markdown formatting, or commentary outside of the JSON. Make sure each explanation clearly states what you did and how it differs from the other candidates. Earlier turns of the conversation may come first, with each of your past answers cut down to the parameters it changed ('changes') and its explanation; use them to make sense of follow-ups such as 'a bit less', but always start from 'currentParameters', which include any changes the user made by hand since.";
+            return "{\"role\": \"system\", \"content\": " + juce::JSON::toString(systemMessage) + "}";
+        }();
+
         juce::DynamicObject::Ptr rootObj = new juce::DynamicObject();
-        juce::DynamicObject::Ptr paramsObj = new juce::DynamicObject();
-        paramsObj->setProperty("decayTime",   audioProcessor.getDecayTime());
-        paramsObj->setProperty("preDelay",    audioProcessor.getPreDelay());
-        paramsObj->setProperty("size",        audioProcessor.getSize());
-        paramsObj->setProperty("diffusion",   audioProcessor.getDiffusion());
-        paramsObj->setProperty("density",     audioProcessor.getDensity());
-        paramsObj->setProperty("damping",     audioProcessor.getDamping());
-        paramsObj->setProperty("eqLow",       audioProcessor.getEQLow());
-        paramsObj->setProperty("eqMid",       audioProcessor.getEQMid());
-        paramsObj->setProperty("eqHigh",      audioProcessor.getEQHigh());
-        paramsObj->setProperty("spread",      audioProcessor.getSpread());
-        paramsObj->setProperty("modulation",  audioProcessor.getModulation());
-        paramsObj->setProperty("wetDryMix",   audioProcessor.getWetDryMix());
-        rootObj->setProperty("currentParameters", juce::var(paramsObj.get()));
+        rootObj->setProperty("currentParameters", currentParameters.toVar());
         rootObj->setProperty("userPrompt", userMessage);
-        juce::String payload = juce::JSON::toString(juce::var(rootObj.get()));
-        
-        juce::String apiKey = "YOUR KEY HERE";
-        juce::String url = "https://api.openai.com/v1/chat/completions";
-        juce::String model = "gpt-4o-mini";
-        
-        juce::String systemMessage = "You are an audio plugin parameter modifier. When given a JSON payload containing 'currentParameters' and 'userPrompt', respond strictly with a valid JSON object containing exactly two keys: 'parameters' and 'explanation'. The 'parameters' object must include only numeric values for the reverb parameters, and the 'explanation' should be a concise string that describes what changes you made. Do not include any additional text, markdown formatting, or commentary outside of the JSON. Make sure the explanation clearly states what you did.";
-        
-        juce::String userContent = juce::JSON::toString(payload);
-        
-        juce::String fullPayload = "{\"model\": \"" + model + "\", \"messages\": ["
-            "{\"role\": \"system\", \"content\": " + juce::JSON::toString(systemMessage) + "},"
-            "{\"role\": \"user\", \"content\": " + juce::JSON::toString(userContent) + "}"
-            "] }";
-        
-        juce::URL requestURL(url);
-        requestURL = requestURL.withPOSTData(fullPayload);
-        
-        juce::String extraHeaders = "Content-Type: application/json\r\nAuthorization: Bearer " + apiKey;
+        juce::String userFragment = ",{\"role\": \"user\", \"content\": "
+                                  + juce::JSON::toString(juce::JSON::toString(juce::var(rootObj.get()))) + "}";
+
+        juce::MemoryOutputStream history;
+        int fixedTokens = Conversation::estimateTokens(systemFragment) + Conversation::estimateTokens(userFragment);
+        audioProcessor.getConversation().writeHistory(history, llmClient.getOptions().tokenBudget - fixedTokens);
+
+        // same prompt against the same settings, following the same answer: reuse the
+        // earlier answer, no round trip. Keyed on the last turn rather than the whole
+        // history, which changes every turn and would make repeats all but never hit.
+        auto cacheKey = ResponseCache::makeKey(userMessage, currentParameters, model,
+                                               audioProcessor.getConversation().getLastTurn());
+        juce::String cachedAnswer;
+        if (responseCache->lookup(cacheKey, cachedAnswer))
+        {
+            LLMClient::Response cachedReply;
+            cachedReply.succeeded = true;
+            cachedReply.content = cachedAnswer;
+            if (handleLLMResponse(cachedReply, StreamingResponseParser(), currentParameters).isNotEmpty())
+                recordTurn(userMessage, currentParameters);
+            return;
+        }
+
+        // answer locally first so something happens straight away, even offline;
+        // the LLM (if we can reach it) refines from the original settings afterwards
+        auto local = localResolver->resolve(userMessage, currentParameters);
+        if (local.matched)
+        {
+            audioProcessor.applyParameters(local.parameters);
+            addToChat(ChatHistory::Role::local, local.explanation);
+        }
+
+        if (! llmClient.getOptions().hasApiKey())
+        {
+            if (local.matched)
+                recordTurn(userMessage, currentParameters);
+            else
+                addToChat(ChatHistory::Role::notice, "No API key set, and nothing in the offline presets matches that prompt.");
+            return;
+        }
+
+        juce::MemoryOutputStream request;
+        request << "{\"model\": " << juce::JSON::toString(model) << ", \"stream\": true, \"messages\": [" << systemFragment;
+        request << history;
+        request << userFragment << "] }";
         
-        std::unique_ptr<juce::InputStream> stream(requestURL.createInputStream(
-            juce::URL::InputStreamOptions(juce::URL::ParameterHandling::inPostData)
-                .withExtraHeaders(extraHeaders)
-                .withConnectionTimeoutMs(10000)
-                .withNumRedirectsToFollow(5)
-        ));
+        // The request runs on the client's worker thread; the SafePointer covers the
+        // editor being closed before the answer arrives. While the reply streams in,
+        // each parameter of the first candidate is applied as soon as its value is complete.
+        juce::Component::SafePointer<LLMEffectsAudioProcessorEditor> safeThis (this);
+        auto parser = std::make_shared<StreamingResponseParser>();
+
+        parser->onParameter = [safeThis](int parameterIndex, float value)
+        {
+            if (safeThis != nullptr)
+                safeThis->audioProcessor.setParameterValue(parameterIndex, value);
+        };
+
+        parser->onExplanationText = [safeThis, parser](const juce::String& text)
+        {
+            if (safeThis == nullptr)
+                return;
+            safeThis->chatHistory.moveCaretToEnd();
+            if (! parser->hasStreamedExplanation())
+                safeThis->chatHistory.insertTextAtCaret("\nLLM Explanation: ");
+            safeThis->chatHistory.insertTextAtCaret(text);
+        };
+
+        llmClient.submit(request.toString(),
+                         [safeThis, parser, cacheKey, userMessage, currentParameters](const LLMClient::Response& response)
+                         {
+                             if (safeThis == nullptr)
+                                 return;
+                             auto answer = safeThis->handleLLMResponse(response, *parser, currentParameters);
+                             if (answer.isNotEmpty())
+                             {
+                                 safeThis->responseCache->store(cacheKey, answer);
+                                 safeThis->recordTurn(userMessage, currentParameters);
+                             }
+                         },
+                         [parser](const juce::String& delta) { parser->feed(delta); });
+    }
+}
+
+juce::String LLMEffectsAudioProcessorEditor::handleLLMResponse (const LLMClient::Response& llmReply, const StreamingResponseParser& streamed,
+                                                               const ReverbParameters& base)
+{
+    if (! llmReply.succeeded)
+    {
+        addToChat(ChatHistory::Role::notice, llmReply.error);
+        return {};
+    }
+
+    // streamed replies arrive as plain content; otherwise dig it out of the completion object
+    juce::String llmResponse = llmReply.content;
+    if (llmResponse.isEmpty())
+    {
+        juce::var jsonResponse = juce::JSON::parse(llmReply.body);
+        juce::var choices = jsonResponse.getProperty("choices", juce::var());
+        if (! choices.isArray() || choices.getArray()->size() == 0)
+            return {};
+
+        juce::var messageObj = (*choices.getArray())[0].getProperty("message", juce::var());
+        if (! messageObj.isObject())
+            return {};
+
+        llmResponse = messageObj.getDynamicObject()->getProperty("content").toString();
+    }
+
+    juce::var responseJson = juce::JSON::parse(llmResponse);
+    if (responseJson.isObject())
+    {
+        auto* respObj = responseJson.getDynamicObject();
+
+        // a single answer is still accepted, from the cache or a model that ignored the format
+        juce::var candidateList = respObj->getProperty("candidates");
+        if (candidateList.isArray())
+            return handleCandidates(*candidateList.getArray(), streamed, base) ? llmResponse : juce::String();
+
+        juce::var newParams = respObj->getProperty("parameters");
+        juce::var explanation = respObj->getProperty("explanation");
         
-        if (stream)
+        if (!explanation.toString().isEmpty())
         {
-            juce::String response = stream->readEntireStreamAsString();
-            juce::var jsonResponse = juce::JSON::parse(response);
-            if (jsonResponse.isObject())
-            {
-                auto* jsonObject = jsonResponse.getDynamicObject();
-                juce::var choices = jsonObject->getProperty("choices");
-                if (choices.isArray() && choices.getArray()->size() > 0)
-                {
-                    juce::var messageObj = (*choices.getArray())[0].getProperty("message", juce::var());
-                    if (messageObj.isObject())
-                    {
-                        auto* messageDynamic = messageObj.getDynamicObject();
-                        juce::String llmResponse = messageDynamic->getProperty("content").toString();
-                        juce::var responseJson = juce::JSON::parse(llmResponse);
-                        if (responseJson.isObject())
-                        {
-                            auto* respObj = responseJson.getDynamicObject();
-                            juce::var newParams = respObj->getProperty("parameters");
-                            juce::var explanation = respObj->getProperty("explanation");
-                            
-                            if (!explanation.toString().isEmpty())
-                            {
-                                if (newParams.isObject())
-                                {
-                                    auto* pObj = newParams.getDynamicObject();
-                                    if (pObj->hasProperty("decayTime"))
-                                        audioProcessor.setDecayTime((float) static_cast<double>(pObj->getProperty("decayTime")));
-                                    if (pObj->hasProperty("preDelay"))
-                                        audioProcessor.setPreDelay((float) static_cast<double>(pObj->getProperty("preDelay")));
-                                    if (pObj->hasProperty("size"))
-                                        audioProcessor.setSize((float) static_cast<double>(pObj->getProperty("size")));
-                                    if (pObj->hasProperty("diffusion"))
-                                        audioProcessor.setDiffusion((float) static_cast<double>(pObj->getProperty("diffusion")));
-                                    if (pObj->hasProperty("density"))
-                                        audioProcessor.setDensity((float) static_cast<double>(pObj->getProperty("density")));
-                                    if (pObj->hasProperty("damping"))
-                                        audioProcessor.setDamping((float) static_cast<double>(pObj->getProperty("damping")));
-                                    if (pObj->hasProperty("eqLow"))
-                                        audioProcessor.setEQLow((float) static_cast<double>(pObj->getProperty("eqLow")));
-                                    if (pObj->hasProperty("eqMid"))
-                                        audioProcessor.setEQMid((float) static_cast<double>(pObj->getProperty("eqMid")));
-                                    if (pObj->hasProperty("eqHigh"))
-                                        audioProcessor.setEQHigh((float) static_cast<double>(pObj->getProperty("eqHigh")));
-                                    if (pObj->hasProperty("spread"))
-                                        audioProcessor.setSpread((float) static_cast<double>(pObj->getProperty("spread")));
-                                    if (pObj->hasProperty("modulation"))
-                                        audioProcessor.setModulation((float) static_cast<double>(pObj->getProperty("modulation")));
-                                    if (pObj->hasProperty("wetDryMix"))
-                                        audioProcessor.setWetDryMix((float) static_cast<double>(pObj->getProperty("wetDryMix")));
-                                }
-                                
-                                decayTimeSlider.setValue(audioProcessor.getDecayTime());
-                                preDelaySlider.setValue(audioProcessor.getPreDelay());
-                                sizeSlider.setValue(audioProcessor.getSize());
-                                diffusionSlider.setValue(audioProcessor.getDiffusion());
-                                densitySlider.setValue(audioProcessor.getDensity());
-                                dampingSlider.setValue(audioProcessor.getDamping());
-                                eqLowSlider.setValue(audioProcessor.getEQLow());
-                                eqMidSlider.setValue(audioProcessor.getEQMid());
-                                eqHighSlider.setValue(audioProcessor.getEQHigh());
-                                spreadSlider.setValue(audioProcessor.getSpread());
-                                modulationSlider.setValue(audioProcessor.getModulation());
-                                wetDryMixSlider.setValue(audioProcessor.getWetDryMix());
-                                
-                                juce::MessageManager::callAsync([this, explanation]()
-                                {
-                                    chatHistory.moveCaretToEnd();
-                                    chatHistory.insertTextAtCaret("\nLLM Explanation: " + juce::String(explanation.toString()) + "\n");
-                                });
-                            }
-                            else
-                            {
-                                juce::MessageManager::callAsync([this]()
-                                {
-                                    chatHistory.moveCaretToEnd();
-                                    chatHistory.insertTextAtCaret("\nLLM did not provide an explanation.\n");
-                                });
-                            }
-                        }
-                        else
-                        {
-                            juce::MessageManager::callAsync([this, llmResponse]()
-                            {
-                                chatHistory.moveCaretToEnd();
-                                chatHistory.insertTextAtCaret("\nLLM response is not valid JSON: " + llmResponse + "\n");
-                            });
-                        }
-                    }
-                }
-            }
+            // applied as one update so the audio thread never sees half a preset
+            // (values already streamed in are simply set again); the slider
+            // attachments pick the new values up from the parameters. Keys it leaves
+            // out go back to what they were when the prompt was sent, not to the
+            // local resolver's guess.
+            if (newParams.isObject())
+                audioProcessor.applyParameters(ReverbParameters::fromVar(newParams, base));
+            
+            addExplanation(explanation.toString(), streamed);
+            return llmResponse;
         }
         else
         {
-            juce::MessageManager::callAsync([this]()
-            {
-                chatHistory.moveCaretToEnd();
-                chatHistory.insertTextAtCaret("\nFailed to connect to LLM API.\n");
-            });
+            addToChat(ChatHistory::Role::notice, "LLM did not provide an explanation.");
         }
     }
+    else
+    {
+        addToChat(ChatHistory::Role::notice, "LLM response is not valid JSON: " + llmResponse);
+    }
+
+    return {};
+}
+
+void LLMEffectsAudioProcessorEditor::addExplanation (const juce::String& explanation, const StreamingResponseParser& streamed)
+{
+    // a streamed explanation is already on screen, it only needs recording
+    if (streamed.hasStreamedExplanation())
+    {
+        audioProcessor.getChatHistory().add(ChatHistory::Role::assistant, explanation);
+        chatHistory.moveCaretToEnd();
+        chatHistory.insertTextAtCaret("\n");
+    }
+    else
+    {
+        addToChat(ChatHistory::Role::assistant, explanation);
+    }
+}
+
+bool LLMEffectsAudioProcessorEditor::handleCandidates (const juce::Array<juce::var>& list, const StreamingResponseParser& streamed,
+                                                       const ReverbParameters& base)
+{
+    // every candidate is relative to the settings the prompt was made against, not to
+    // what is applied by now (the first candidate as it streamed, or the local guess)
+    std::vector<Candidate> parsed;
+    for (auto& item : list)
+    {
+        auto newParams = item.getProperty("parameters", juce::var());
+        auto explanation = item.getProperty("explanation", juce::var()).toString();
+        if (newParams.isObject() && explanation.isNotEmpty() && (int) parsed.size() < numCandidates)
+            parsed.push_back({ ReverbParameters::fromVar(newParams, base), explanation });
+    }
+
+    if (parsed.empty())
+    {
+        addToChat(ChatHistory::Role::notice, "LLM did not provide any usable candidates.");
+        return false;
+    }
+
+    // the first one is what streamed in; applied again as one update all the same
+    audioProcessor.applyParameters(parsed.front().parameters);
+    addExplanation(parsed.front().explanation, streamed);
+
+    if (parsed.size() > 1)
+    {
+        juce::String others ("Takes on that; click one to hear it, then Use to keep it:");
+        for (size_t i = 0; i < parsed.size(); ++i)
+            others << "\n" << getCandidateName((int) i) << ": " << (i == 0 ? juce::String("(applied) ") : juce::String()) << parsed[i].explanation;
+        addToChat(ChatHistory::Role::notice, others);
+    }
+
+    showCandidates(std::move(parsed));
+    return true;
+}
+
+void LLMEffectsAudioProcessorEditor::showCandidates (std::vector<Candidate> newCandidates)
+{
+    clearCandidates();
+    if (newCandidates.size() < 2)
+        return;
+
+    candidates = std::move(newCandidates);
+    for (size_t i = 0; i < candidateButtons.size(); ++i)
+        candidateButtons[i].setVisible(i < candidates.size());
+    useCandidateButton.setVisible(true);
+
+    auto snippet = std::make_shared<juce::AudioBuffer<float>>(audioProcessor.getRecentInput());
+    if (snippet->getNumSamples() == 0 || snippet->getMagnitude(0, snippet->getNumSamples()) == 0.0f)
+    {
+        addToChat(ChatHistory::Role::notice, "Nothing has played through the plugin lately, so there's nothing to preview the takes with; Use still applies the selected one.");
+    }
+    else
+    {
+        std::vector<ReverbParameters> settings;
+        for (auto& candidate : candidates)
+            settings.push_back(candidate.parameters);
+
+        previewsPending = true;
+        previewRenderer.render(snippet, audioProcessor.getSampleRate(), audioProcessor.getBusesLayout(),
+                               audioProcessor.getEngine(), settings);
+    }
+
+    updateAudition();
+}
+
+void LLMEffectsAudioProcessorEditor::clearCandidates()
+{
+    previewRenderer.cancel();
+    candidates.clear();
+    selectedCandidate = -1;
+    previewsPending = false;
+    for (auto& button : candidateButtons)
+        button.setVisible(false);
+    useCandidateButton.setVisible(false);
+    audioProcessor.stopAudition();
+}
+
+void LLMEffectsAudioProcessorEditor::selectCandidate (int index)
+{
+    if (! juce::isPositiveAndBelow(index, (int) candidates.size()))
+        return;
+
+    // clicking the one that's playing goes back to the live sound
+    selectedCandidate = index == selectedCandidate ? -1 : index;
+    updateAudition();
+}
+
+void LLMEffectsAudioProcessorEditor::useSelectedCandidate()
+{
+    if (! juce::isPositiveAndBelow(selectedCandidate, (int) candidates.size()))
+        return;
+
+    auto& candidate = candidates[(size_t) selectedCandidate];
+    audioProcessor.applyParameters(candidate.parameters);
+    addToChat(ChatHistory::Role::assistant, candidate.explanation);
+    audioProcessor.getConversation().amendLastTurn(candidate.parameters, candidate.explanation);
+    selectedCandidate = -1;
+    updateAudition();
+}
+
+void LLMEffectsAudioProcessorEditor::updateAudition()
+{
+    for (int i = 0; i < numCandidates; ++i)
+    {
+        // "..." while its preview is still rendering
+        bool rendering = previewsPending && previewRenderer.getPreview(i) == nullptr;
+        auto& button = candidateButtons[(size_t) i];
+        button.setButtonText(getCandidateName(i) + (rendering ? "..." : ""));
+        button.setToggleState(i == selectedCandidate, juce::dontSendNotification);
+    }
+    useCandidateButton.setEnabled(selectedCandidate >= 0);
+
+    // a take that hasn't finished rendering starts playing as soon as it has
+    auto preview = previewRenderer.getPreview(selectedCandidate);
+    if (preview != nullptr)
+        audioProcessor.startAudition(preview);
+    else
+        audioProcessor.stopAudition();
+}
+
+void LLMEffectsAudioProcessorEditor::recordTurn (const juce::String& prompt, const ReverbParameters& before)
+{
+    // whatever the answer left applied, which is what the next prompt builds on
+    audioProcessor.getConversation().addTurn(prompt, before, audioProcessor.getCurrentParameters(),
+                                             audioProcessor.getChatHistory().getLastExplanation());
 }
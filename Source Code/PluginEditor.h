@@ -1,12 +1,21 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include <array>
+#include <vector>
 #include "PluginProcessor.h"
+#include "LLMClient.h"
+#include "LocalResolver.h"
+#include "PresetBank.h"
+#include "PreviewRenderer.h"
+#include "ResponseCache.h"
+#include "StreamingResponseParser.h"
 
 class LLMEffectsAudioProcessorEditor  : public juce::AudioProcessorEditor,
                                               public juce::Button::Listener,
                                               public juce::TextEditor::Listener,
-                                              public juce::Slider::Listener
+                                              private juce::ChangeListener,
+                                              private juce::Timer
 {
 public:
     LLMEffectsAudioProcessorEditor (LLMEffectsAudioProcessor&);
@@ -17,7 +26,7 @@ public:
 
     void buttonClicked (juce::Button* button) override;
     void textEditorReturnKeyPressed (juce::TextEditor& editor) override;
-    void sliderValueChanged (juce::Slider* slider) override;
+    void textEditorTextChanged (juce::TextEditor& editor) override;
 
 private:
     LLMEffectsAudioProcessor& audioProcessor;
@@ -27,6 +36,23 @@ private:
     juce::TextEditor messageBox;
     juce::TextButton sendButton;
 
+    // Each reply carries a few takes on the prompt. The first is applied straight away;
+    // all of them are rendered over the last few seconds of input so the buttons can
+    // A/B them instantly, and Use applies the one being auditioned.
+    static constexpr int numCandidates = 3;
+    static_assert (numCandidates <= PreviewRenderer::maxCandidates, "every candidate needs a preview slot");
+
+    struct Candidate
+    {
+        ReverbParameters parameters;
+        juce::String explanation;
+    };
+    std::vector<Candidate> candidates;
+    int selectedCandidate { -1 };
+    bool previewsPending { false };
+    std::array<juce::TextButton, numCandidates> candidateButtons;
+    juce::TextButton useCandidateButton { "Use" };
+
     // knob
     juce::Slider decayTimeSlider      { juce::Slider::Rotary, juce::Slider::NoTextBox };
     juce::Slider preDelaySlider       { juce::Slider::Rotary, juce::Slider::NoTextBox };
@@ -40,6 +66,8 @@ private:
     juce::Slider spreadSlider         { juce::Slider::Rotary, juce::Slider::NoTextBox };
     juce::Slider modulationSlider     { juce::Slider::Rotary, juce::Slider::NoTextBox };
     juce::Slider wetDryMixSlider      { juce::Slider::Rotary, juce::Slider::NoTextBox };
+    juce::Slider eqLowFrequencySlider  { juce::Slider::Rotary, juce::Slider::NoTextBox };
+    juce::Slider eqHighFrequencySlider { juce::Slider::Rotary, juce::Slider::NoTextBox };
 
     juce::Label decayTimeLabel        { {}, "Decay Time (s)" };
     juce::Label preDelayLabel         { {}, "Pre-Delay (s)" };
@@ -53,8 +81,65 @@ private:
     juce::Label spreadLabel           { {}, "Spread" };
     juce::Label modulationLabel       { {}, "Modulation" };
     juce::Label wetDryMixLabel        { {}, "Wet/Dry Mix" };
+    juce::Label eqLowFrequencyLabel   { {}, "EQ Low/Mid (Hz)" };
+    juce::Label eqHighFrequencyLabel  { {}, "EQ Mid/High (Hz)" };
+
+    juce::ComboBox engineBox;
+    juce::Label engineLabel           { {}, "Engine" };
+
+    // presets: the search box filters the list, and names the preset Save writes
+    juce::TextEditor presetSearch;
+    juce::ComboBox presetBox;
+    juce::TextButton savePresetButton  { "Save" };
+    std::vector<int> presetMatches;
+
+   #if LLMEFFECTS_PERF_MONITOR
+    // live DSP load of this instance, refreshed by the timer
+    juce::Label performanceLabel;
+   #endif
+    void timerCallback() override;
+
+    // knobs follow the processor's parameters (and host automation) through these
+    juce::OwnedArray<juce::AudioProcessorValueTreeState::SliderAttachment> sliderAttachments;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> engineAttachment;
 
     void sendMessage();
+    // Adds a line to the processor's history and to the chat box.
+    void addToChat (ChatHistory::Role role, const juce::String& text);
+    // Rebuilds the chat box from the processor's history, e.g. after a session loads.
+    void showChatHistory();
+    void changeListenerCallback (juce::ChangeBroadcaster* source) override;
+
+    void refreshPresetList();
+    void loadSelectedPreset();
+    void saveCurrentPreset();
+
+    // Applies a reply to a prompt made against `base`; returns the answer JSON if it was
+    // valid, so it can be cached.
+    juce::String handleLLMResponse (const LLMClient::Response& response, const StreamingResponseParser& streamed,
+                                    const ReverbParameters& base);
+    bool handleCandidates (const juce::Array<juce::var>& list, const StreamingResponseParser& streamed,
+                           const ReverbParameters& base);
+    // Records the explanation of what was applied, which may already be on screen.
+    void addExplanation (const juce::String& explanation, const StreamingResponseParser& streamed);
+    // Adds the prompt, and what its answer changed since `before`, to the conversation.
+    void recordTurn (const juce::String& prompt, const ReverbParameters& before);
+
+    void showCandidates (std::vector<Candidate> newCandidates);
+    void clearCandidates();
+    void selectCandidate (int index);
+    void useSelectedCandidate();
+    // Brings the buttons and the processor's audition in line with the selection.
+    void updateAudition();
+
+    PreviewRenderer previewRenderer;
+
+    juce::SharedResourcePointer<ResponseCache> responseCache;
+    juce::SharedResourcePointer<LocalResolver> localResolver;
+    juce::SharedResourcePointer<PresetBank> presetBank;
+
+    // declared last so it is destroyed first, cancelling any request still in flight
+    LLMClient llmClient;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LLMEffectsAudioProcessorEditor)
 };
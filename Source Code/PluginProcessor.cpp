@@ -1,6 +1,43 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
 
+namespace
+{
+    // SIMDRegister is compiled for one instruction set (SSE2, AVX2 or NEON). Check the
+    // machine we are running on really has it before taking the vector path.
+    bool cpuSupportsSIMDBuild()
+    {
+       #if defined (__AVX2__)
+        return juce::SystemStats::hasAVX2();
+       #elif JUCE_USE_SSE_INTRINSICS
+        return juce::SystemStats::hasSSE2();
+       #elif JUCE_USE_ARM_NEON
+        return juce::SystemStats::hasNeon();
+       #else
+        return false;
+       #endif
+    }
+
+    // Session state: magic and version, then tagged chunks (id, size, payload) so a
+    // reader can skip chunks it doesn't know and older sessions load in newer builds.
+    const int stateMagic          = 0x534d4c4c; // "LLMS"
+    const int stateVersion        = 1;
+    const int parametersChunkID   = 0x4d524150; // "PARM": count, then (id, value) pairs
+    const int engineChunkID       = 0x4e474e45; // "ENGN"
+    const int chatChunkID         = 0x54414843; // "CHAT": see ChatHistory::writeTo
+    const int turnsChunkID        = 0x4e525554; // "TURN": see Conversation::writeTo
+
+    template <typename WriteFunction>
+    void writeChunk (juce::OutputStream& out, int id, WriteFunction&& writePayload)
+    {
+        juce::MemoryOutputStream payload;
+        writePayload(payload);
+        out.writeInt(id);
+        out.writeCompressedInt((int) payload.getDataSize());
+        out << payload;
+    }
+}
+
 LLMEffectsAudioProcessor::LLMEffectsAudioProcessor()
 #ifndef JucePlugin_PreferredChannelConfigurations
      : AudioProcessor (BusesProperties()
@@ -10,19 +47,69 @@ LLMEffectsAudioProcessor::LLMEffectsAudioProcessor()
 #endif
          .withOutput("Output", juce::AudioChannelSet::stereo(), true)
 #endif
-     )
+     ),
+#else
+     :
 #endif
+       parameters (*this, nullptr, "Parameters", createParameterLayout())
 {
+    engineValue = parameters.getRawParameterValue(engineParameterID);
+    jassert (engineValue != nullptr);
+    for (int i = 0; i < ReverbParameters::numParameters; ++i)
+    {
+        auto* id = ReverbParameters::getInfo(i).id;
+        parameterObjects[(size_t) i] = parameters.getParameter(id);
+        parameterValues[(size_t) i] = parameters.getRawParameterValue(id);
+        jassert (parameterObjects[(size_t) i] != nullptr && parameterValues[(size_t) i] != nullptr);
+    }
+
+   #if LLMEFFECTS_PERF_MONITOR
+    // LLMEFFECTS_PERF_DUMP=<folder> keeps a CSV and JSON load histogram per instance there
+    auto dumpFolder = juce::SystemStats::getEnvironmentVariable("LLMEFFECTS_PERF_DUMP", {});
+    if (dumpFolder.isNotEmpty())
+        performance.startPeriodicDump(juce::File(dumpFolder), "perf-" + juce::String::toHexString((juce::pointer_sized_int) this), 5000);
+   #endif
+
+    startTimerHz(20);
 }
 
-LLMEffectsAudioProcessor::~LLMEffectsAudioProcessor() {}
+LLMEffectsAudioProcessor::~LLMEffectsAudioProcessor()
+{
+    stopTimer();
+    deleteGrowthHandover();
+}
+
+juce::AudioProcessorValueTreeState::ParameterLayout LLMEffectsAudioProcessor::createParameterLayout()
+{
+    auto layout = ReverbParameters::createParameterLayout();
+    layout.add(std::make_unique<juce::AudioParameterChoice>(juce::ParameterID { engineParameterID, 1 },
+                                                            "Engine",
+                                                            juce::StringArray { "Legacy", "FDN", "Convolution" },
+                                                            legacyEngine));
+    return layout;
+}
 
 const juce::String LLMEffectsAudioProcessor::getName() const { return JucePlugin_Name; }
 
 bool LLMEffectsAudioProcessor::acceptsMidi() const { return false; }
 bool LLMEffectsAudioProcessor::producesMidi() const { return false; }
 bool LLMEffectsAudioProcessor::isMidiEffect() const { return false; }
-double LLMEffectsAudioProcessor::getTailLengthSeconds() const { return 0.0; }
+double LLMEffectsAudioProcessor::getTailLengthSeconds() const
+{
+    return computeTailSeconds(getCurrentParameters(), getSelectedEngine());
+}
+
+bool LLMEffectsAudioProcessor::isEngineReady() const
+{
+    if (getSelectedEngine() != convolutionEngine)
+        return true;
+    if (groups.empty())
+        return false;
+    for (auto& group : groups)
+        if (! group->convolution.hasImpulseResponse())
+            return false;
+    return true;
+}
 
 int LLMEffectsAudioProcessor::getNumPrograms() { return 1; }
 int LLMEffectsAudioProcessor::getCurrentProgram() { return 0; }
@@ -33,29 +120,108 @@ void LLMEffectsAudioProcessor::changeProgramName (int index, const juce::String&
 void LLMEffectsAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
     fs = sampleRate;
-    int maxDelaySamples = static_cast<int>(sampleRate * 2.0);
+   #if LLMEFFECTS_PERF_MONITOR
+    performance.prepare(sampleRate);
+   #endif
     int numChannels = getTotalNumOutputChannels();
-    delayBuffers.clear();
-    writePositions.clear();
-    lastDelayedSamples.clear();
-    delayBuffers.resize(numChannels);
-    writePositions.resize(numChannels, 0);
-    lastDelayedSamples.resize(numChannels, 0.0f);
-    
-    eqLowState.clear();
-    eqHighState.clear();
-    eqHighLastInput.clear();
-    eqLowState.resize(numChannels, 0.0f);
-    eqHighState.resize(numChannels, 0.0f);
-    eqHighLastInput.resize(numChannels, 0.0f);
-    
-    for (int ch = 0; ch < numChannels; ++ch)
+    jassert (numChannels <= maxLanes);
+
+    useSIMD = ! forceScalar && numChannels <= (int) Vec::SIMDNumElements && cpuSupportsSIMDBuild();
+
+    // just enough delay for the current settings; the timer grows it if they change
+    deleteGrowthHandover();
+    delayLanes = juce::jmax(numChannels, (int) Vec::SIMDNumElements);
+    grantedDelayFrames = requiredDelayFrames(getCurrentParameters());
+    requestedDelayFrames.store(grantedDelayFrames);
+    delayLine.prepare(grantedDelayFrames, delayLanes, &bufferPool.get(), delayStorage);
+    maxDelaySamples = (float) (delayLine.getMaxDelay() - 1);
+    lanes = Lanes();
+    // golden-ratio steps keep neighbouring channels, such as left and right, far apart
+    for (int channel = 0; channel < maxLanes; ++channel)
+        lanes.delayOffset[channel] = std::fmod((float) channel * 0.618034f, 1.0f);
+
+    // nobody previews against an offline render, so it needn't hold seconds of audio
+    if (isNonRealtime())
+        capture.release();
+    else
+        capture.prepare(fs, getTotalNumInputChannels(), juce::jmax(1, samplesPerBlock), captureSeconds);
+
+    wetBuffer.setSize(numChannels, juce::jmax(1, samplesPerBlock));
+    fadingWet.setSize(numChannels, juce::jmax(1, samplesPerBlock));
+    crossover.prepare(fs, numChannels);
+    engineFadeRemaining = 0;
+    tapFadeRemaining = 0;
+
+    int numGroups = juce::jmin(FDNReverb::maxVariants, (numChannels + 1) / 2);
+    if ((int) groups.size() != numGroups)
     {
-        delayBuffers[ch].resize(maxDelaySamples, 0.0f);
+        groups.clear();
+        for (int i = 0; i < numGroups; ++i)
+            groups.push_back(std::make_unique<ChannelGroup>());
     }
+    recallFadeLength = juce::jmax(1, static_cast<int>(0.05 * fs));
+    for (int i = 0; i < numGroups; ++i)
+    {
+        auto& group = *groups[(size_t) i];
+        group.firstChannel = 2 * i;
+        group.numChannels = juce::jmin(2, numChannels - 2 * i);
+        for (auto& fdn : group.fdns)
+        {
+            fdn.setVariant(i);
+            fdn.prepare(fs, juce::jmax(1, samplesPerBlock));
+        }
+        group.activeFdn = 0;
+        group.fdnFadeRemaining = 0;
+        group.convolution.setVariant(i);
+        group.convolution.setNonRealtime(isNonRealtime());
+        group.convolution.prepare(fs);
+        group.wet.setSize(2, juce::jmax(1, samplesPerBlock));
+        group.fadeWet.setSize(2, juce::jmax(1, samplesPerBlock));
+    }
+
+    // a few workers for wide layouts; the audio thread still takes its share of groups
+    int workers = numWorkerThreads >= 0 ? numWorkerThreads
+                : numChannels >= parallelChannelThreshold ? juce::jlimit(0, 3, juce::SystemStats::getNumPhysicalCpus() - 1)
+                : 0;
+    workers = juce::jmin(workers, numGroups - 1);
+    if (workers <= 0)
+        workerPool.reset();
+    else if (workerPool == nullptr || workerPool->getNumWorkers() != workers)
+        workerPool = std::make_unique<AudioWorkerPool>(workers);
+
+    lfo.prepare(fs, juce::jmax(1, samplesPerBlock), numChannels);
+    activeEngine = getSelectedEngine();
+
+    // 20 ms ramps are long enough to avoid zipper noise when several parameters jump at once
+    rampLengthSamples = juce::jmax(1, static_cast<int>(0.02 * fs));
+    blockParameters = getCurrentParameters();
+    targetCoeffs = computeCoefficients(blockParameters);
+    currentCoeffs = targetCoeffs;
+    rampSamplesRemaining = 0;
+    updateEngines(blockParameters);
+    lfo.reset();
+
+    tailSamples = static_cast<int>(computeTailSeconds(blockParameters, activeEngine) * fs);
+    silentInputSamples = 0;
+    idle = false;
 }
 
-void LLMEffectsAudioProcessor::releaseResources() {}
+void LLMEffectsAudioProcessor::releaseResources()
+{
+    // an idle instance shouldn't sit on delay memory another one could use
+    deleteGrowthHandover();
+    delayLine.release();
+    maxDelaySamples = 1.0f;
+    workerPool.reset();
+    capture.release();
+}
+
+void LLMEffectsAudioProcessor::setNonRealtime (bool isNonRealtime) noexcept
+{
+    AudioProcessor::setNonRealtime(isNonRealtime);
+    for (auto& group : groups)
+        group->convolution.setNonRealtime(isNonRealtime);
+}
 
 #ifndef JucePlugin_PreferredChannelConfigurations
 bool LLMEffectsAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) const
@@ -64,10 +230,17 @@ bool LLMEffectsAudioProcessor::isBusesLayoutSupported (const BusesLayout& layout
     juce::ignoreUnused (layouts);
     return true;
 #else
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+    const juce::AudioChannelSet supported[] = { juce::AudioChannelSet::mono(),
+                                                juce::AudioChannelSet::stereo(),
+                                                juce::AudioChannelSet::create5point1(),
+                                                juce::AudioChannelSet::create7point1(),
+                                                juce::AudioChannelSet::create7point1point4() };
+    auto output = layouts.getMainOutputChannelSet();
+    if (std::find(std::begin(supported), std::end(supported), output) == std::end(supported))
         return false;
   #if ! JucePlugin_IsSynth
-    if (layouts.getMainInputChannelSet() != juce::AudioChannelSet::stereo())
+    // processed in place, so every output channel needs its own input
+    if (layouts.getMainInputChannelSet() != output)
         return false;
   #endif
     return true;
@@ -78,90 +251,620 @@ bool LLMEffectsAudioProcessor::isBusesLayoutSupported (const BusesLayout& layout
 
 void LLMEffectsAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
+    LLMEFFECTS_AUDIO_THREAD_SCOPE;
+    LLMEFFECTS_TIME_BLOCK(performance, buffer.getNumSamples());
     juce::ScopedNoDenormals noDenormals;
     int totalNumInputChannels  = getTotalNumInputChannels();
     int totalNumOutputChannels = getTotalNumOutputChannels();
     int numSamples = buffer.getNumSamples();
 
-    
-    
-    float fc_low = 200.0f;
-    float a_low = std::exp(-2.0f * juce::MathConstants<float>::pi * fc_low / (float)fs);
-    
-    float fc_high = 3000.0f;
-    float a_high = std::exp(-2.0f * juce::MathConstants<float>::pi * fc_high / (float)fs);
+    if (numSamples == 0)
+        return;
+
+    capture.write(buffer, totalNumInputChannels, numSamples);
+
+    // pick up the parameters once per block; if an update is half-written we keep
+    // the previous snapshot and catch up next block
+    ReverbParameters snapshot;
+    bool newSnapshot = readParameterSnapshot(snapshot) && snapshot != blockParameters;
+    bool recall = newSnapshot && recallPending.exchange(false, std::memory_order_acquire);
+
+    // recallPreset sets the engine before the parameters, so a recall's engine is
+    // always in by the time its snapshot is
+    int engine = getSelectedEngine();
+    bool switched = engine != activeEngine;
+    if (switched)
+        switchEngine(engine);
+
+    if (newSnapshot)
+    {
+        blockParameters = snapshot;
+        targetCoeffs = computeCoefficients(blockParameters);
+        rampSamplesRemaining = rampLengthSamples;
+        // a new engine starts from silence, so its delay taps can go straight to the new
+        // settings; a recall that brought its own engine is covered by the engine fade
+        if (switched)
+            jumpDelayTaps();
+        else if (recall && ! idle)
+            startRecallFade();
+
+        int frames = requiredDelayFrames(blockParameters);
+        if (frames > delayLine.getMaxDelay() - 1 && frames > requestedDelayFrames.load(std::memory_order_relaxed))
+            requestedDelayFrames.store(frames, std::memory_order_release);
+    }
+    if (newSnapshot || switched)
+    {
+        updateEngines(blockParameters);
+        tailSamples = static_cast<int>(computeTailSeconds(blockParameters, activeEngine) * fs);
+    }
+    swapInGrownDelayLine();
+
+    // Work out where the ramp ends up at the end of this block, then interpolate
+    // linearly across the block so every channel sees the same trajectory.
+    Coefficients blockEnd = targetCoeffs;
+    if (rampSamplesRemaining > numSamples)
+    {
+        blockEnd = currentCoeffs;
+        blockEnd.advance(Coefficients::difference(currentCoeffs, targetCoeffs, (float)numSamples / (float)rampSamplesRemaining));
+        rampSamplesRemaining -= numSamples;
+    }
+    else
+    {
+        rampSamplesRemaining = 0;
+    }
+    Coefficients step = Coefficients::difference(currentCoeffs, blockEnd, 1.0f / (float)numSamples);
+
+    float inputPeak = 0.0f;
+    for (int channel = 0; channel < totalNumInputChannels; ++channel)
+        inputPeak = juce::jmax(inputPeak, buffer.getMagnitude(channel, 0, numSamples));
+
+    if (inputPeak > silenceThreshold)
+    {
+        silentInputSamples = 0;
+        idle = false;
+    }
+    else
+    {
+        silentInputSamples = juce::jmin(tailSamples, silentInputSamples + numSamples);
+    }
+
+    if (idle)
+    {
+        buffer.clear();
+        currentCoeffs = blockEnd;
+        playAudition(buffer);
+        return;
+    }
+
+    processEngines(buffer, step);
+
+    currentCoeffs = blockEnd;
+
+    // The tail has run its course and what's left is below the threshold: clear the
+    // engine so it wakes up from true silence, and stop running it.
+    if (silentInputSamples >= tailSamples)
+    {
+        float outputPeak = 0.0f;
+        for (int channel = 0; channel < totalNumOutputChannels; ++channel)
+            outputPeak = juce::jmax(outputPeak, buffer.getMagnitude(channel, 0, numSamples));
+
+        if (outputPeak <= silenceThreshold)
+        {
+            crossover.reset();
+            resetEngine(activeEngine);
+            if (engineFadeRemaining > 0)
+                resetEngine(fadingEngine);
+            engineFadeRemaining = 0;
+            idle = true;
+        }
+    }
+
+    for (int channel = totalNumInputChannels; channel < totalNumOutputChannels; ++channel)
+        buffer.clear(channel, 0, numSamples);
+
+    playAudition(buffer);
+}
+
+void LLMEffectsAudioProcessor::playAudition (juce::AudioBuffer<float>& buffer) noexcept
+{
+    auto* request = auditionRequest.load();
+    auditionInUse.store(request);
+    // withdrawn in between, so the timer may be freeing it already
+    if (request != auditionRequest.load())
+    {
+        auditionInUse.store(nullptr);
+        request = nullptr;
+    }
+
+    auto generation = request != nullptr ? request->generation : 0u;
+    if (generation != auditionPlaying)
+    {
+        auditionPlaying = generation;
+        auditionPosition = 0;
+    }
+    if (request == nullptr || request->preview->getNumSamples() == 0)
+        return;
+
+    auto* preview = request->preview.get();
+
+    int numSamples = buffer.getNumSamples();
+    int length = preview->getNumSamples();
+    int numChannels = juce::jmin(buffer.getNumChannels(), preview->getNumChannels());
+    for (int done = 0; done < numSamples;)
+    {
+        int chunk = juce::jmin(numSamples - done, length - auditionPosition);
+        for (int channel = 0; channel < numChannels; ++channel)
+            buffer.copyFrom(channel, done, *preview, channel, auditionPosition, chunk);
+        auditionPosition = (auditionPosition + chunk) % length;
+        done += chunk;
+    }
+    for (int channel = numChannels; channel < buffer.getNumChannels(); ++channel)
+        buffer.clear(channel, 0, numSamples);
+}
+
+void LLMEffectsAudioProcessor::processEngines (juce::AudioBuffer<float>& buffer, const Coefficients& step)
+{
+    // the engines work on the channel pointers, never on the buffer object itself
+    const float* const* channels = buffer.getArrayOfReadPointers();
+    float* const* wet = wetBuffer.getArrayOfWritePointers();
+    int numSamples = buffer.getNumSamples();
+    Coefficients c = currentCoeffs;
+
+    // hosts may send bigger blocks than they promised, so work through wet-sized chunks
+    for (int offset = 0; offset < numSamples; offset += wetBuffer.getNumSamples())
+    {
+        int chunk = juce::jmin(wetBuffer.getNumSamples(), numSamples - offset);
+        Coefficients chunkStart = c;
+
+        renderWet(activeEngine, channels, offset, chunk, c, step, wet);
+        if (engineFadeRemaining > 0)
+            crossfadeEngines(channels, offset, chunk);
+
+        // the EQ runs every channel at once, so it waits for all the groups
+        mixWet(buffer, offset, chunk, chunkStart, step);
+    }
+}
+
+void LLMEffectsAudioProcessor::renderWet (int engine, const float* const* channels, int offset, int numSamples,
+                                          Coefficients& c, const Coefficients& step, float* const* wet) noexcept
+{
+    if (engine == legacyEngine)
+    {
+        if (useSIMD)
+            renderLegacySIMD(channels, offset, numSamples, c, step, wet);
+        else
+            renderLegacy(channels, offset, numSamples, c, step, wet);
+        return;
+    }
+
+    if (workerPool != nullptr)
+    {
+        workerPool->run((int) groups.size(), [&] (int index) { processGroup(*groups[(size_t) index], engine, channels, offset, numSamples, wet); });
+    }
+    else
+    {
+        for (auto& group : groups)
+            processGroup(*group, engine, channels, offset, numSamples, wet);
+    }
+    c.advance(step, (float) numSamples);
+}
+
+float LLMEffectsAudioProcessor::readLegacyTap (int channel, float modulation, const Coefficients& c) const noexcept
+{
+    auto read = [&](const Coefficients& k)
+    {
+        return delayLine.readLinear(channel, juce::jlimit(DelayLine<float>::minLinearDelay, maxDelaySamples,
+                                                          k.delaySamples + k.delaySpread * lanes.delayOffset[channel] + modulation * k.modDepth));
+    };
+
+    float delayed = read(c);
+    if (tapFadeRemaining == 0)
+        return delayed;
+
+    float old = read(tapFadeFrom);
+    float gain = (float) (recallFadeLength - tapFadeRemaining) / (float) recallFadeLength;
+    return old + gain * (delayed - old);
+}
+
+// Scalar reference: the per-sample algorithm the SIMD kernel has to reproduce.
+void LLMEffectsAudioProcessor::renderLegacy (const float* const* channels, int offset, int numSamples,
+                                             Coefficients& c, const Coefficients& step, float* const* wet) noexcept
+{
+    int numChannels = getTotalNumOutputChannels();
+    lfo.process(numSamples);
+
+    for (int sample = 0; sample < numSamples; ++sample)
+    {
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            float in = channels[channel][offset + sample];
+            float delayedSample = readLegacyTap(channel, lfo.getOutput(channel)[sample], c);
+
+            float dampedSample = c.dampingGain * delayedSample + c.dampingMemory * lanes.lastDelayed[channel];
+            dampedSample = c.smoothing * dampedSample + c.smoothingBypass * delayedSample;
+            lanes.lastDelayed[channel] = dampedSample;
+
+            delayLine.write(channel, in + c.feedbackGain * dampedSample);
+            wet[channel][sample] = dampedSample;
+        }
+
+        delayLine.advance();
+        c.advance(step);
+        if (tapFadeRemaining > 0)
+            --tapFadeRemaining;
+    }
+}
+
+// Same algorithm with every channel in its own lane. Each channel's LFO has its own
+// phase, so the interpolated reads are gathered per lane; everything after that runs
+// on whole frames.
+void LLMEffectsAudioProcessor::renderLegacySIMD (const float* const* channels, int offset, int numSamples,
+                                                 Coefficients& c, const Coefficients& step, float* const* wet) noexcept
+{
+    int numChannels = getTotalNumOutputChannels();
+    Vec lastDelayed = Vec::fromRawArray(lanes.lastDelayed);
+
+    alignas (32) float frame[maxLanes] = {};
+    alignas (32) float delayedFrame[maxLanes] = {};
+    const bool nativeDelay = delayLine.getStorage() == DelayLine<float>::Storage::native;
+    lfo.process(numSamples);
+
+    for (int sample = 0; sample < numSamples; ++sample)
+    {
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            frame[channel] = channels[channel][offset + sample];
+            delayedFrame[channel] = readLegacyTap(channel, lfo.getOutput(channel)[sample], c);
+        }
+        Vec in = Vec::fromRawArray(frame);
+        Vec delayed = Vec::fromRawArray(delayedFrame);
+
+        Vec damped = delayed * c.dampingGain + lastDelayed * c.dampingMemory;
+        damped = damped * c.smoothing + delayed * c.smoothingBypass;
+        lastDelayed = damped;
+
+        Vec written = in + damped * c.feedbackGain;
+        if (nativeDelay)
+        {
+            written.copyToRawArray(delayLine.getWriteFrame());
+        }
+        else
+        {
+            written.copyToRawArray(frame);
+            delayLine.writeFrame(frame);
+        }
+
+        damped.copyToRawArray(frame);
+        for (int channel = 0; channel < numChannels; ++channel)
+            wet[channel][sample] = frame[channel];
+
+        delayLine.advance();
+        c.advance(step);
+        if (tapFadeRemaining > 0)
+            --tapFadeRemaining;
+    }
+
+    lastDelayed.copyToRawArray(lanes.lastDelayed);
+}
+
+void LLMEffectsAudioProcessor::processGroup (ChannelGroup& group, int engine, const float* const* channels, int offset, int numSamples,
+                                             float* const* wet) noexcept
+{
+    int lastInput = juce::jmax(0, getTotalNumInputChannels() - 1);
+    const float* inL = channels[juce::jmin(group.firstChannel, lastInput)] + offset;
+    const float* inR = channels[juce::jmin(group.firstChannel + group.numChannels - 1, lastInput)] + offset;
+
+    // a pair renders straight into its rows of the wet buffer
+    bool mono = group.numChannels == 1;
+    float* wetL = mono ? group.wet.getWritePointer(0) : wet[group.firstChannel];
+    float* wetR = mono ? group.wet.getWritePointer(1) : wet[group.firstChannel + 1];
+
+    if (engine == convolutionEngine)
+        group.convolution.process(inL, inR, wetL, wetR, numSamples);
+    else
+        group.fdns[(size_t) group.activeFdn].process(inL, inR, wetL, wetR, numSamples);
+
+    if (engine == fdnEngine && group.fdnFadeRemaining > 0)
+        crossfadeFDN(group, inL, inR, wetL, wetR, numSamples);
 
-    for (int channel = 0; channel < totalNumOutputChannels; ++channel)
+    // a mono output takes the mid of the pair
+    if (mono)
     {
-        float* channelData = buffer.getWritePointer(channel);
-        auto& delayBuffer = delayBuffers[channel];
-        int bufferSize = static_cast<int>(delayBuffer.size());
-        int& writePos = writePositions[channel];
+        float* out = wet[group.firstChannel];
+        for (int sample = 0; sample < numSamples; ++sample)
+            out[sample] = 0.5f * (wetL[sample] + wetR[sample]);
+    }
+}
+
+void LLMEffectsAudioProcessor::mixWet (juce::AudioBuffer<float>& buffer, int offset, int numSamples, const Coefficients& c, const Coefficients& step) noexcept
+{
+    crossover.process(wetBuffer.getArrayOfWritePointers(), numSamples,
+                      { c.lowGain, c.midGain, c.highGain }, { step.lowGain, step.midGain, step.highGain });
+
+    for (int channel = 0; channel < wetBuffer.getNumChannels(); ++channel)
+    {
+        float* channelData = buffer.getWritePointer(channel, offset);
+        const float* wet = wetBuffer.getReadPointer(channel);
+        float dryGain = c.dryGain, wetGain = c.wetGain;
 
         for (int sample = 0; sample < numSamples; ++sample)
         {
-            float in = channelData[sample];
+            channelData[sample] = dryGain * channelData[sample] + wetGain * wet[sample];
+            dryGain += step.dryGain;
+            wetGain += step.wetGain;
+        }
+    }
+}
 
-            int preDelaySamples = static_cast<int>(preDelay * fs);
-            int sizeDelaySamples = static_cast<int>(size * decayTime * fs / 2.0f);
-            float mod = std::sin(2.0f * juce::MathConstants<float>::pi * modulation * sample / (float)fs);
-            int modulatedDelay = preDelaySamples + sizeDelaySamples + static_cast<int>(mod * 10.0f);
-            modulatedDelay = juce::jlimit(1, bufferSize - 1, modulatedDelay);
+void LLMEffectsAudioProcessor::switchEngine (int engine) noexcept
+{
+    // a switch mid-fade stops the engine that was already on its way out
+    if (engineFadeRemaining > 0)
+        resetEngine(fadingEngine);
+    engineFadeRemaining = 0;
 
-            int readPos = (writePos + bufferSize - modulatedDelay) % bufferSize;
-            float delayedSample = delayBuffer[readPos];
+    // The new engine starts from silence rather than replaying stale state. While there
+    // is sound, the old one plays on under it with the coefficients it had and fades out;
+    // the EQ carries on with the mix of the two.
+    if (idle)
+    {
+        crossover.reset();
+    }
+    else
+    {
+        fadingEngine = activeEngine;
+        fadingCoeffs = currentCoeffs;
+        engineFadeRemaining = recallFadeLength;
+    }
 
-            float smoothing = juce::jmap(diffusion, 0.0f, 1.0f, 0.8f, 0.95f);
-            float dampedSample = damping * delayedSample + (1.0f - damping) * lastDelayedSamples[channel];
-            dampedSample = smoothing * dampedSample + (1.0f - smoothing) * delayedSample;
-            lastDelayedSamples[channel] = dampedSample;
+    activeEngine = engine;
+    resetEngine(engine);
+}
 
+void LLMEffectsAudioProcessor::startRecallFade() noexcept
+{
+    if (activeEngine == fdnEngine)
+    {
+        for (auto& group : groups)
+            startFDNCrossfade(*group);
+    }
+    else if (activeEngine == legacyEngine)
+    {
+        // The taps jump to where the new settings put them and the old ones fade out;
+        // sliding them along the ramp would sweep the pitch. A second recall mid-fade
+        // just moves the new taps.
+        if (tapFadeRemaining == 0)
+        {
+            tapFadeFrom = currentCoeffs;
+            tapFadeRemaining = recallFadeLength;
+        }
+        jumpDelayTaps();
+    }
+    // the convolution engine crossfades to each new IR by itself
+}
 
-            
-            float feedbackGain = juce::jmap(decayTime * density, 0.1f, 5.0f, 0.3f, 0.9f);
-            delayBuffer[writePos] = in + feedbackGain * dampedSample;
-            
+void LLMEffectsAudioProcessor::jumpDelayTaps() noexcept
+{
+    currentCoeffs.delaySamples = targetCoeffs.delaySamples;
+    currentCoeffs.delaySpread = targetCoeffs.delaySpread;
+    currentCoeffs.modDepth = targetCoeffs.modDepth;
+}
 
-            
+void LLMEffectsAudioProcessor::crossfadeEngines (const float* const* channels, int offset, int numSamples) noexcept
+{
+    auto hold = Coefficients::difference(fadingCoeffs, fadingCoeffs, 0.0f);
+    float* const* old = fadingWet.getArrayOfWritePointers();
+    renderWet(fadingEngine, channels, offset, numSamples, fadingCoeffs, hold, old);
 
+    // a convolution that is still building its first IR is silent, so the old engine
+    // carries on at full level until it has one
+    bool waiting = false;
+    if (activeEngine == convolutionEngine)
+        for (auto& group : groups)
+            waiting = waiting || ! group->convolution.hasImpulseResponse();
 
+    int numChannels = wetBuffer.getNumChannels();
+    if (waiting)
+    {
+        for (int channel = 0; channel < numChannels; ++channel)
+            wetBuffer.copyFrom(channel, 0, old[channel], numSamples);
+        return;
+    }
 
+    const float step = 1.0f / (float) recallFadeLength;
+    int fadeSamples = juce::jmin(numSamples, engineFadeRemaining);
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        float* wet = wetBuffer.getWritePointer(channel);
+        float gain = (float) (recallFadeLength - engineFadeRemaining) * step;
+        for (int sample = 0; sample < fadeSamples; ++sample)
+        {
+            wet[sample] = old[channel][sample] + gain * (wet[sample] - old[channel][sample]);
+            gain += step;
+        }
+    }
 
+    engineFadeRemaining -= fadeSamples;
+    if (engineFadeRemaining == 0)
+        resetEngine(fadingEngine);
+}
 
+void LLMEffectsAudioProcessor::startFDNCrossfade (ChannelGroup& group) noexcept
+{
+    // a second recall mid-fade just retunes the incoming FDN
+    if (group.fdnFadeRemaining > 0)
+        return;
 
+    auto& outgoing = group.fdns[(size_t) group.activeFdn];
+    group.activeFdn ^= 1;
+    group.fdns[(size_t) group.activeFdn].copyStateFrom(outgoing);
+    group.fdnFadeRemaining = recallFadeLength;
+}
 
-            // eq
-            float lowOut = (1.0f - a_low) * dampedSample + a_low * eqLowState[channel];
-            eqLowState[channel] = lowOut;
+// wetL and wetR hold the incoming FDN's output; run the outgoing one on the same input
+// and fade linearly from it. The two start from identical state, so their outputs are
+// correlated and a linear fade keeps the level steady.
+void LLMEffectsAudioProcessor::crossfadeFDN (ChannelGroup& group, const float* inL, const float* inR, float* wetL, float* wetR, int numSamples) noexcept
+{
+    float* fadeL = group.fadeWet.getWritePointer(0);
+    float* fadeR = group.fadeWet.getWritePointer(1);
+    group.fdns[(size_t) (group.activeFdn ^ 1)].process(inL, inR, fadeL, fadeR, numSamples);
 
-            
-            
-            float highOut = a_high * (eqHighState[channel] + dampedSample - eqHighLastInput[channel]);
-            eqHighState[channel] = highOut;
-            eqHighLastInput[channel] = dampedSample;
-            
-            
-            float midOut = dampedSample - lowOut - highOut;
-            
-            
-            float lowGain = std::pow(10.0f, eqLow / 20.0f);
-            float midGain = std::pow(10.0f, eqMid / 20.0f);
-            float highGain = std::pow(10.0f, eqHigh / 20.0f);
-            
-            
-            float wetEQ = lowOut * lowGain + midOut * midGain + highOut * highGain;
-            
-            
-            channelData[sample] = (1.0f - wetDryMix) * in + wetDryMix * wetEQ;
+    const float step = 1.0f / (float) recallFadeLength;
+    float* wet[] = { wetL, wetR };
+    const float* old[] = { fadeL, fadeR };
+    int fadeSamples = juce::jmin(numSamples, group.fdnFadeRemaining);
 
-            
-            writePos = (writePos + 1) % bufferSize;
+    for (int channel = 0; channel < 2; ++channel)
+    {
+        float gain = (float) (recallFadeLength - group.fdnFadeRemaining) * step;
+        for (int sample = 0; sample < fadeSamples; ++sample)
+        {
+            wet[channel][sample] = old[channel][sample] + gain * (wet[channel][sample] - old[channel][sample]);
+            gain += step;
         }
     }
-    
-    
-    for (int channel = totalNumInputChannels; channel < totalNumOutputChannels; ++channel)
-        buffer.clear(channel, 0, numSamples);
+    group.fdnFadeRemaining -= fadeSamples;
+}
+
+void LLMEffectsAudioProcessor::resetEngine (int engine) noexcept
+{
+    if (engine == fdnEngine)
+    {
+        for (auto& group : groups)
+        {
+            group->fdns[(size_t) group->activeFdn].reset();
+            group->fdnFadeRemaining = 0;
+        }
+    }
+    else if (engine == convolutionEngine)
+    {
+        for (auto& group : groups)
+            group->convolution.reset();
+    }
+    else
+    {
+        resetLegacyState();
+    }
+}
+
+double LLMEffectsAudioProcessor::computeTailSeconds (const ReverbParameters& p, int engine) const
+{
+    float decibels = -juce::Decibels::gainToDecibels(silenceThreshold);
+
+    if (engine == fdnEngine)
+        return FDNReverb::getTailLengthSeconds(p, decibels);
+    if (engine == convolutionEngine)
+        return ConvolutionReverb::getTailLengthSeconds(p, fs);
+
+    // The legacy loop is one delay with feedbackGain round it (the damper has unity
+    // gain at DC), so it needs log (threshold) / log (feedbackGain) trips round the loop.
+    Coefficients c = computeCoefficients(p);
+    double loopSeconds = (c.delaySamples + c.delaySpread + c.modDepth) / fs;
+    double trips = std::log(silenceThreshold) / std::log(juce::jlimit(0.01f, 0.999f, c.feedbackGain));
+    return loopSeconds * (1.0 + std::ceil(trips));
+}
+
+void LLMEffectsAudioProcessor::updateEngines (const ReverbParameters& p) noexcept
+{
+    for (auto& group : groups)
+    {
+        // Only the engine in use follows the parameters: one fading out after a switch,
+        // and the outgoing FDN of a recall crossfade, keep the settings they had, and
+        // building an IR is expensive anyway. Switching engines brings the new one up
+        // to date.
+        if (activeEngine == fdnEngine)
+            group->fdns[(size_t) group->activeFdn].setParameters(p);
+        else if (activeEngine == convolutionEngine)
+            group->convolution.setParameters(p);
+    }
+    lfo.setFrequency(p.modulation);
+    lfo.setPhaseSpread(p.spread);
+    crossover.setCrossoverFrequencies(p.eqLowFrequency, p.eqHighFrequency);
+}
+
+int LLMEffectsAudioProcessor::requiredDelayFrames (const ReverbParameters& p) const
+{
+    Coefficients c = computeCoefficients(p);
+    return static_cast<int>(std::ceil(c.delaySamples + c.delaySpread + c.modDepth)) + 2;
+}
+
+void LLMEffectsAudioProcessor::swapInGrownDelayLine() noexcept
+{
+    // the timer hasn't freed the last one yet
+    if (retiredDelayLine.load(std::memory_order_acquire) != nullptr)
+        return;
+
+    if (auto* grown = grownDelayLine.exchange(nullptr, std::memory_order_acq_rel))
+    {
+        // one copy of the old history, then the old storage goes back for freeing
+        grown->copyFrom(delayLine);
+        std::swap(delayLine, *grown);
+        maxDelaySamples = (float) (delayLine.getMaxDelay() - 1);
+        retiredDelayLine.store(grown, std::memory_order_release);
+    }
+}
+
+void LLMEffectsAudioProcessor::timerCallback()
+{
+   #if LLMEFFECTS_PERF_MONITOR
+    performance.collect();
+   #endif
+
+    delete retiredDelayLine.exchange(nullptr, std::memory_order_acq_rel);
+
+    auto* inUse = auditionInUse.load();
+    retiredAuditions.erase(std::remove_if(retiredAuditions.begin(), retiredAuditions.end(),
+                                          [inUse](const std::shared_ptr<const Audition>& retired) { return retired.get() != inUse; }),
+                           retiredAuditions.end());
+
+    int requested = requestedDelayFrames.load(std::memory_order_acquire);
+    if (requested > grantedDelayFrames && grownDelayLine.load(std::memory_order_acquire) == nullptr)
+    {
+        // match the line in use, not the settings: the storage may have been changed
+        // since prepareToPlay and only takes effect at the next one
+        auto grown = std::make_unique<DelayLine<float>>();
+        grown->prepare(requested, delayLine.getNumLanes(), &bufferPool.get(), delayLine.getStorage());
+        grantedDelayFrames = requested;
+        grownDelayLine.store(grown.release(), std::memory_order_release);
+    }
+}
+
+juce::AudioBuffer<float> LLMEffectsAudioProcessor::getRecentInput() const
+{
+    juce::AudioBuffer<float> snippet;
+    capture.readLatest(snippet, captureSeconds);
+    return snippet;
+}
+
+void LLMEffectsAudioProcessor::startAudition (Preview preview)
+{
+    if (preview == (audition != nullptr ? audition->preview : nullptr))
+        return;
+
+    if (audition != nullptr)
+        retiredAuditions.push_back(std::move(audition));
+    if (preview != nullptr)
+    {
+        // never 0, which stands for nothing playing
+        if (++auditionGeneration == 0)
+            ++auditionGeneration;
+        audition = std::make_shared<const Audition>(Audition { std::move(preview), auditionGeneration });
+    }
+    auditionRequest.store(audition.get());
+}
+
+void LLMEffectsAudioProcessor::deleteGrowthHandover() noexcept
+{
+    delete grownDelayLine.exchange(nullptr);
+    delete retiredDelayLine.exchange(nullptr);
+}
+
+void LLMEffectsAudioProcessor::resetLegacyState()
+{
+    delayLine.reset();
+    std::fill(std::begin(lanes.lastDelayed), std::end(lanes.lastDelayed), 0.0f);
+    tapFadeRemaining = 0;
 }
 
 bool LLMEffectsAudioProcessor::hasEditor() const { return true; }
@@ -170,58 +873,232 @@ juce::AudioProcessorEditor* LLMEffectsAudioProcessor::createEditor()
     return new LLMEffectsAudioProcessorEditor (*this);
 }
 
-void LLMEffectsAudioProcessor::getStateInformation (juce::MemoryBlock& destData) {}
-void LLMEffectsAudioProcessor::setStateInformation (const void* data, int sizeInBytes) {}
-
-void LLMEffectsAudioProcessor::setDecayTime (float newDecayTime)
+void LLMEffectsAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
 {
-    decayTime = juce::jlimit(0.1f, 5.0f, newDecayTime);
+    juce::MemoryOutputStream out (destData, false);
+    out.writeInt(stateMagic);
+    out.writeInt(stateVersion);
+
+    auto p = getCurrentParameters();
+    writeChunk(out, parametersChunkID, [&p] (juce::OutputStream& chunk)
+    {
+        chunk.writeCompressedInt(ReverbParameters::numParameters);
+        for (int i = 0; i < ReverbParameters::numParameters; ++i)
+        {
+            chunk.writeString(ReverbParameters::getInfo(i).id);
+            chunk.writeFloat(p[i]);
+        }
+    });
+    writeChunk(out, engineChunkID, [this] (juce::OutputStream& chunk) { chunk.writeCompressedInt(getSelectedEngine()); });
+    writeChunk(out, chatChunkID, [this] (juce::OutputStream& chunk) { chatHistory.writeTo(chunk); });
+    writeChunk(out, turnsChunkID, [this] (juce::OutputStream& chunk) { conversation.writeTo(chunk); });
 }
-void LLMEffectsAudioProcessor::setPreDelay (float newPreDelay)
+
+void LLMEffectsAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
-    preDelay = juce::jlimit(0.0f, 0.5f, newPreDelay);
+    juce::MemoryInputStream in (data, (size_t) juce::jmax(0, sizeInBytes), false);
+    if (sizeInBytes < 8 || in.readInt() != stateMagic)
+        return;
+    int version = in.readInt();
+    if (version < 1 || version > stateVersion)
+        return;
+
+    // anything the session doesn't mention goes back to its default
+    ReverbParameters p;
+    int engine = legacyEngine;
+
+    while (in.getNumBytesRemaining() >= 5)
+    {
+        int id = in.readInt();
+        int size = in.readCompressedInt();
+        if (size < 0 || size > in.getNumBytesRemaining())
+            break;
+
+        juce::MemoryInputStream chunk (static_cast<const char*>(data) + in.getPosition(), (size_t) size, false);
+        in.skipNextBytes(size);
+
+        if (id == parametersChunkID)
+        {
+            int count = chunk.readCompressedInt();
+            for (int i = 0; i < count && ! chunk.isExhausted(); ++i)
+            {
+                auto paramID = chunk.readString();
+                float value = chunk.readFloat();
+                int index = ReverbParameters::indexOf(paramID);
+                if (index >= 0)
+                    p[index] = value;
+            }
+        }
+        else if (id == engineChunkID)
+        {
+            engine = juce::jlimit((int) legacyEngine, (int) convolutionEngine, chunk.readCompressedInt());
+        }
+        else if (id == chatChunkID)
+        {
+            chatHistory.readFrom(chunk);
+        }
+        else if (id == turnsChunkID)
+        {
+            conversation.readFrom(chunk);
+        }
+    }
+
+    recallPreset(p, engine);
 }
-void LLMEffectsAudioProcessor::setSize (float newSize)
+
+LLMEffectsAudioProcessor::Coefficients LLMEffectsAudioProcessor::computeCoefficients (const ReverbParameters& p) const
 {
-    size = juce::jlimit(0.5f, 2.0f, newSize);
+    Coefficients c;
+    c.delaySamples    = (float)(p.preDelay * fs) + (float)(p.size * p.decayTime * fs / 2.0f);
+    c.delaySpread     = c.delaySamples * 0.05f * p.spread;
+    c.modDepth        = 10.0f * juce::jmin(1.0f, p.modulation);
+    c.dampingGain     = p.damping;
+    c.dampingMemory   = 1.0f - p.damping;
+    c.smoothing       = juce::jmap(p.diffusion, 0.0f, 1.0f, 0.8f, 0.95f);
+    c.smoothingBypass = 1.0f - c.smoothing;
+    c.feedbackGain    = juce::jmap(p.decayTime * p.density, 0.1f, 5.0f, 0.3f, 0.9f);
+    c.lowGain         = juce::Decibels::decibelsToGain(p.eqLow, -1000.0f);
+    c.midGain         = juce::Decibels::decibelsToGain(p.eqMid, -1000.0f);
+    c.highGain        = juce::Decibels::decibelsToGain(p.eqHigh, -1000.0f);
+    c.wetGain         = p.wetDryMix;
+    c.dryGain         = 1.0f - p.wetDryMix;
+    return c;
 }
-void LLMEffectsAudioProcessor::setDiffusion (float newDiffusion)
+
+void LLMEffectsAudioProcessor::Coefficients::advance (const Coefficients& step) noexcept
 {
-    diffusion = juce::jlimit(0.0f, 1.0f, newDiffusion);
+    delaySamples    += step.delaySamples;
+    delaySpread     += step.delaySpread;
+    modDepth        += step.modDepth;
+    dampingGain     += step.dampingGain;
+    dampingMemory   += step.dampingMemory;
+    smoothing       += step.smoothing;
+    smoothingBypass += step.smoothingBypass;
+    feedbackGain    += step.feedbackGain;
+    lowGain         += step.lowGain;
+    midGain         += step.midGain;
+    highGain        += step.highGain;
+    wetGain         += step.wetGain;
+    dryGain         += step.dryGain;
 }
-void LLMEffectsAudioProcessor::setDensity (float newDensity)
+
+void LLMEffectsAudioProcessor::Coefficients::advance (const Coefficients& step, float numSteps) noexcept
 {
-    density = juce::jlimit(0.0f, 1.0f, newDensity);
+    delaySamples    += step.delaySamples    * numSteps;
+    delaySpread     += step.delaySpread     * numSteps;
+    modDepth        += step.modDepth        * numSteps;
+    dampingGain     += step.dampingGain     * numSteps;
+    dampingMemory   += step.dampingMemory   * numSteps;
+    smoothing       += step.smoothing       * numSteps;
+    smoothingBypass += step.smoothingBypass * numSteps;
+    feedbackGain    += step.feedbackGain    * numSteps;
+    lowGain         += step.lowGain         * numSteps;
+    midGain         += step.midGain         * numSteps;
+    highGain        += step.highGain        * numSteps;
+    wetGain         += step.wetGain         * numSteps;
+    dryGain         += step.dryGain         * numSteps;
 }
-void LLMEffectsAudioProcessor::setDamping (float newDamping)
+
+LLMEffectsAudioProcessor::Coefficients LLMEffectsAudioProcessor::Coefficients::difference (const Coefficients& from, const Coefficients& to, float scale) noexcept
 {
-    damping = juce::jlimit(0.0f, 1.0f, newDamping);
+    Coefficients d;
+    d.delaySamples    = (to.delaySamples    - from.delaySamples)    * scale;
+    d.delaySpread     = (to.delaySpread     - from.delaySpread)     * scale;
+    d.modDepth        = (to.modDepth        - from.modDepth)        * scale;
+    d.dampingGain     = (to.dampingGain     - from.dampingGain)     * scale;
+    d.dampingMemory   = (to.dampingMemory   - from.dampingMemory)   * scale;
+    d.smoothing       = (to.smoothing       - from.smoothing)       * scale;
+    d.smoothingBypass = (to.smoothingBypass - from.smoothingBypass) * scale;
+    d.feedbackGain    = (to.feedbackGain    - from.feedbackGain)    * scale;
+    d.lowGain         = (to.lowGain         - from.lowGain)         * scale;
+    d.midGain         = (to.midGain         - from.midGain)         * scale;
+    d.highGain        = (to.highGain        - from.highGain)        * scale;
+    d.wetGain         = (to.wetGain         - from.wetGain)         * scale;
+    d.dryGain         = (to.dryGain         - from.dryGain)         * scale;
+    return d;
 }
-void LLMEffectsAudioProcessor::setEQLow (float newEQLow)
+
+ReverbParameters LLMEffectsAudioProcessor::getCurrentParameters() const
 {
-    eqLow = juce::jlimit(-12.0f, 12.0f, newEQLow);
+    ReverbParameters p;
+    for (int i = 0; i < ReverbParameters::numParameters; ++i)
+        p[i] = parameterValues[(size_t) i]->load();
+    return p;
 }
-void LLMEffectsAudioProcessor::setEQMid (float newEQMid)
+
+void LLMEffectsAudioProcessor::applyParameters (const ReverbParameters& newParameters)
 {
-    eqMid = juce::jlimit(-12.0f, 12.0f, newEQMid);
+    auto p = newParameters.clamped();
+
+    parameterSequence.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (int i = 0; i < ReverbParameters::numParameters; ++i)
+        setParameterValue(i, p[i]);
+    parameterSequence.fetch_add(1, std::memory_order_release);
 }
-void LLMEffectsAudioProcessor::setEQHigh (float newEQHigh)
+
+void LLMEffectsAudioProcessor::recallPreset (const ReverbParameters& newParameters, int engine)
 {
-    eqHigh = juce::jlimit(-12.0f, 12.0f, newEQHigh);
+    // the engine goes first, so a snapshot with the new parameters always finds it
+    setEngine(engine);
+
+    // Nothing would change, and a flag left pending would crossfade some later tweak.
+    // Compared as the parameters will hold them, snapped to their intervals, or an
+    // off-grid value would never match.
+    auto p = newParameters.clamped();
+    for (int i = 0; i < ReverbParameters::numParameters; ++i)
+    {
+        auto* param = parameterObjects[(size_t) i];
+        p[i] = param->convertFrom0to1(param->convertTo0to1(p[i]));
+    }
+
+    if (p != getCurrentParameters())
+    {
+        recallPending.store(true, std::memory_order_release);
+        applyParameters(p);
+    }
 }
-void LLMEffectsAudioProcessor::setSpread (float newSpread)
+
+void LLMEffectsAudioProcessor::setEngine (int engine)
 {
-    spread = juce::jlimit(0.0f, 1.0f, newSpread);
+    auto* param = parameters.getParameter(engineParameterID);
+    param->setValueNotifyingHost(param->convertTo0to1((float) engine));
 }
-void LLMEffectsAudioProcessor::setModulation (float newModulation)
+
+void LLMEffectsAudioProcessor::setParameterValue (int index, float newValue)
 {
-    modulation = newModulation;
+    auto* param = parameterObjects[(size_t) index];
+    param->setValueNotifyingHost(param->convertTo0to1(newValue));
 }
-void LLMEffectsAudioProcessor::setWetDryMix (float newWetDryMix)
+
+bool LLMEffectsAudioProcessor::readParameterSnapshot (ReverbParameters& snapshot) const noexcept
 {
-    wetDryMix = juce::jlimit(0.0f, 1.0f, newWetDryMix);
+    auto sequence = parameterSequence.load(std::memory_order_acquire);
+    if ((sequence & 1) != 0)
+        return false;
+
+    for (int i = 0; i < ReverbParameters::numParameters; ++i)
+        snapshot[i] = parameterValues[(size_t) i]->load(std::memory_order_relaxed);
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return parameterSequence.load(std::memory_order_relaxed) == sequence;
 }
 
+void LLMEffectsAudioProcessor::setDecayTime  (float newDecayTime)  { setParameterValue(ReverbParameters::decayTimeIndex, newDecayTime); }
+void LLMEffectsAudioProcessor::setPreDelay   (float newPreDelay)   { setParameterValue(ReverbParameters::preDelayIndex, newPreDelay); }
+void LLMEffectsAudioProcessor::setSize       (float newSize)       { setParameterValue(ReverbParameters::sizeIndex, newSize); }
+void LLMEffectsAudioProcessor::setDiffusion  (float newDiffusion)  { setParameterValue(ReverbParameters::diffusionIndex, newDiffusion); }
+void LLMEffectsAudioProcessor::setDensity    (float newDensity)    { setParameterValue(ReverbParameters::densityIndex, newDensity); }
+void LLMEffectsAudioProcessor::setDamping    (float newDamping)    { setParameterValue(ReverbParameters::dampingIndex, newDamping); }
+void LLMEffectsAudioProcessor::setEQLow      (float newEQLow)      { setParameterValue(ReverbParameters::eqLowIndex, newEQLow); }
+void LLMEffectsAudioProcessor::setEQMid      (float newEQMid)      { setParameterValue(ReverbParameters::eqMidIndex, newEQMid); }
+void LLMEffectsAudioProcessor::setEQHigh     (float newEQHigh)     { setParameterValue(ReverbParameters::eqHighIndex, newEQHigh); }
+void LLMEffectsAudioProcessor::setSpread     (float newSpread)     { setParameterValue(ReverbParameters::spreadIndex, newSpread); }
+void LLMEffectsAudioProcessor::setModulation (float newModulation) { setParameterValue(ReverbParameters::modulationIndex, newModulation); }
+void LLMEffectsAudioProcessor::setWetDryMix  (float newWetDryMix)  { setParameterValue(ReverbParameters::wetDryMixIndex, newWetDryMix); }
+void LLMEffectsAudioProcessor::setEQLowFrequency  (float newFrequency) { setParameterValue(ReverbParameters::eqLowFrequencyIndex, newFrequency); }
+void LLMEffectsAudioProcessor::setEQHighFrequency (float newFrequency) { setParameterValue(ReverbParameters::eqHighFrequencyIndex, newFrequency); }
+
 juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
 {
     return new LLMEffectsAudioProcessor();
@@ -1,9 +1,26 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include <array>
+#include <atomic>
+#include <memory>
 #include <vector>
+#include "AudioWorkerPool.h"
+#include "BufferPool.h"
+#include "CaptureBuffer.h"
+#include "ChatHistory.h"
+#include "Conversation.h"
+#include "ConvolutionReverb.h"
+#include "CrossoverEQ.h"
+#include "DelayLine.h"
+#include "FDNReverb.h"
+#include "LFO.h"
+#include "PerformanceMonitor.h"
+#include "RealtimeSafety.h"
+#include "ReverbParameters.h"
 
-class LLMEffectsAudioProcessor  : public juce::AudioProcessor
+class LLMEffectsAudioProcessor  : public juce::AudioProcessor,
+                                  private juce::Timer
 {
 public:
     LLMEffectsAudioProcessor();
@@ -16,6 +33,7 @@ public:
     bool isBusesLayoutSupported (const BusesLayout& layouts) const override;
    #endif
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void setNonRealtime (bool isNonRealtime) noexcept override;
 
     
     juce::AudioProcessorEditor* createEditor() override;
@@ -53,47 +71,304 @@ public:
     void setSpread      (float newSpread);
     void setModulation  (float newModulation);
     void setWetDryMix   (float newWetDryMix);
+    void setEQLowFrequency  (float newFrequency);
+    void setEQHighFrequency (float newFrequency);
 
-    float getDecayTime()    const { return decayTime; }
-    float getPreDelay()     const { return preDelay; }
-    float getSize()         const { return size; }
-    float getDiffusion()    const { return diffusion; }
-    float getDensity()      const { return density; }
-    float getDamping()      const { return damping; }
-    float getEQLow()        const { return eqLow; }
-    float getEQMid()        const { return eqMid; }
-    float getEQHigh()       const { return eqHigh; }
-    float getSpread()       const { return spread; }
-    float getModulation()   const { return modulation; }
-    float getWetDryMix()    const { return wetDryMix; }
+    float getDecayTime()    const { return parameterValues[ReverbParameters::decayTimeIndex]->load(); }
+    float getPreDelay()     const { return parameterValues[ReverbParameters::preDelayIndex]->load(); }
+    float getSize()         const { return parameterValues[ReverbParameters::sizeIndex]->load(); }
+    float getDiffusion()    const { return parameterValues[ReverbParameters::diffusionIndex]->load(); }
+    float getDensity()      const { return parameterValues[ReverbParameters::densityIndex]->load(); }
+    float getDamping()      const { return parameterValues[ReverbParameters::dampingIndex]->load(); }
+    float getEQLow()        const { return parameterValues[ReverbParameters::eqLowIndex]->load(); }
+    float getEQMid()        const { return parameterValues[ReverbParameters::eqMidIndex]->load(); }
+    float getEQHigh()       const { return parameterValues[ReverbParameters::eqHighIndex]->load(); }
+    float getSpread()       const { return parameterValues[ReverbParameters::spreadIndex]->load(); }
+    float getModulation()   const { return parameterValues[ReverbParameters::modulationIndex]->load(); }
+    float getWetDryMix()    const { return parameterValues[ReverbParameters::wetDryMixIndex]->load(); }
+    float getEQLowFrequency()  const { return parameterValues[ReverbParameters::eqLowFrequencyIndex]->load(); }
+    float getEQHighFrequency() const { return parameterValues[ReverbParameters::eqHighFrequencyIndex]->load(); }
+
+    ReverbParameters getCurrentParameters() const;
+    // Applies a whole parameter set (e.g. an LLM response) as a single update: the
+    // audio thread either sees all of it or none of it. Call from the message thread.
+    void applyParameters (const ReverbParameters& newParameters);
+    // Jumps to a different sound (a preset, a saved session) from the message thread.
+    // Same as applyParameters, except the new sound crossfades from the old one instead
+    // of sliding delay lengths, which clicks or sweeps the pitch: the FDN fades from a
+    // copy of its running state, the legacy engine from its old delay taps, and a new
+    // engine in under the old one.
+    void recallPreset (const ReverbParameters& newParameters, int engine);
+    // Sets a single parameter by ReverbParameters index.
+    void setParameterValue (int index, float newValue);
+
+    juce::AudioProcessorValueTreeState& getValueTreeState() { return parameters; }
+
+    // The legacy engine has a vector kernel that runs every channel in its own SIMD
+    // lane, picked in prepareToPlay when the CPU and channel count allow it. Forcing
+    // the scalar reference (before prepareToPlay) is for comparing the two.
+    void setForceScalarProcessing (bool shouldForceScalar) { forceScalar = shouldForceScalar; }
+    bool isUsingSIMD() const { return useSIMD; }
+
+    // How the legacy delay line stores its contents; 16-bit storage halves its memory
+    // and bandwidth at some cost in accuracy. Takes effect at the next prepareToPlay.
+    using DelayStorage = DelayLine<float>::Storage;
+    void setDelayStorage (DelayStorage newStorage) { delayStorage = newStorage; }
+    DelayStorage getDelayStorage() const { return delayStorage; }
+
+    // Layouts of parallelChannelThreshold channels and up (7.1.4) spread the FDN and
+    // convolution channel groups over a few worker threads; smaller ones stay on the
+    // audio thread. -1 decides by layout, 0 never uses workers and n > 0 always uses n.
+    // Takes effect at the next prepareToPlay.
+    static constexpr int parallelChannelThreshold = 12;
+    void setNumWorkerThreads (int numThreads) { numWorkerThreads = numThreads; }
+    int getNumActiveWorkers() const { return workerPool != nullptr ? workerPool->getNumWorkers() : 0; }
+
+    // Reverb algorithm, chosen with the "engine" parameter.
+    enum Engine
+    {
+        legacyEngine,
+        fdnEngine,
+        convolutionEngine
+    };
+    static constexpr const char* engineParameterID = "engine";
+
+    void setEngine (int engine);
+    int getEngine() const { return getSelectedEngine(); }
+
+    // The last captureSeconds of input, so LLM suggestions can be previewed against it.
+    // Message thread; empty while the processor isn't prepared, or rendering offline.
+    static constexpr double captureSeconds = 4.0;
+    juce::AudioBuffer<float> getRecentInput() const;
+
+    // Plays a rendered preview in a loop in place of the output, so suggestions can be
+    // compared without waiting on anything. The engine keeps running underneath, and
+    // stopping goes straight back to it. Message thread.
+    using Preview = std::shared_ptr<const juce::AudioBuffer<float>>;
+    void startAudition (Preview preview);
+    void stopAudition() { startAudition(nullptr); }
+    bool isAuditioning() const { return audition != nullptr; }
+
+    // The editor's conversation, kept here so it is saved with the session: the
+    // transcript as shown, and the turns sent back to the LLM as context.
+    ChatHistory& getChatHistory() { return chatHistory; }
+    Conversation& getConversation() { return conversation; }
+
+   #if LLMEFFECTS_PERF_MONITOR
+    // processBlock timings, collected by the processor's timer.
+    PerformanceMonitor& getPerformanceMonitor() { return performance; }
+   #endif
+
+    // False while the convolution engine is still waiting for its first impulse
+    // response; the other engines are always ready.
+    bool isEngineReady() const;
 
 private:
-    // defaults
-    float decayTime   { 1.0f };
-    float preDelay    { 0.05f };
-    float size        { 1.0f };
-    float diffusion   { 0.5f };
-    float density     { 0.5f };
-    float damping     { 0.5f };
-    float eqLow       { 0.0f };
-    float eqMid       { 0.0f };
-    float eqHigh      { 0.0f };
-    float spread      { 0.5f };
-    float modulation  { 0.0f };
-    float wetDryMix   { 0.5f };
+    static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
+
+    juce::AudioProcessorValueTreeState parameters;
+    std::atomic<float>* engineValue { nullptr };
+    int activeEngine { legacyEngine };
+    int getSelectedEngine() const noexcept { return juce::roundToInt(engineValue->load()); }
+    std::array<juce::RangedAudioParameter*, ReverbParameters::numParameters> parameterObjects {};
+    std::array<std::atomic<float>*, ReverbParameters::numParameters> parameterValues {};
+
+    // Sequence lock around applyParameters. Odd while an update is in flight; the
+    // audio thread never waits on it, it just keeps last block's snapshot instead.
+    std::atomic<juce::uint32> parameterSequence { 0 };
+    ReverbParameters blockParameters;
+
+    bool readParameterSnapshot (ReverbParameters& snapshot) const noexcept;
+    // set by recallPreset, taken by the audio thread with the snapshot it belongs to
+    std::atomic<bool> recallPending { false };
 
     double fs { 44100.0 };
 
-    // For each output channel, we keep a delay buffer and a write position.
-    std::vector<std::vector<float>> delayBuffers;
-    std::vector<int> writePositions;
-    // For smoothing: store last delayed sample per channel.
-    std::vector<float> lastDelayedSamples;
-    
-    // For EQ filtering state per channel
-    std::vector<float> eqLowState;
-    std::vector<float> eqHighState;
-    std::vector<float> eqHighLastInput;
+    // Control-rate coefficients derived from the parameters. They are only rebuilt
+    // when the block's parameter snapshot changes, and processBlock ramps towards
+    // the new target so the sample loop is just multiply-adds.
+    struct Coefficients
+    {
+        float delaySamples    { 0.0f };
+        float delaySpread     { 0.0f };   // extra delay at a channel offset of 1
+        float modDepth        { 0.0f };
+        float dampingGain     { 0.5f };
+        float dampingMemory   { 0.5f };
+        float smoothing       { 0.875f };
+        float smoothingBypass { 0.125f };
+        float feedbackGain    { 0.5f };
+        float lowGain         { 1.0f };
+        float midGain         { 1.0f };
+        float highGain        { 1.0f };
+        float wetGain         { 0.5f };
+        float dryGain         { 0.5f };
+
+        void advance (const Coefficients& step) noexcept;
+        void advance (const Coefficients& step, float numSteps) noexcept;
+        static Coefficients difference (const Coefficients& from, const Coefficients& to, float scale) noexcept;
+    };
+
+    Coefficients computeCoefficients (const ReverbParameters& p) const;
+
+    // Runs the engines a wet-sized chunk at a time and mixes their output in.
+    void processEngines (juce::AudioBuffer<float>& buffer, const Coefficients& step);
+    // Renders an engine's wet signal for one chunk of input into the first rows of
+    // `wet`, ramping `c` by `step` per sample. FDN and convolution go one channel group
+    // at a time or spread over the worker pool.
+    void renderWet (int engine, const float* const* channels, int offset, int numSamples,
+                    Coefficients& c, const Coefficients& step, float* const* wet) noexcept;
+    void renderLegacy (const float* const* channels, int offset, int numSamples,
+                       Coefficients& c, const Coefficients& step, float* const* wet) noexcept;
+    void renderLegacySIMD (const float* const* channels, int offset, int numSamples,
+                           Coefficients& c, const Coefficients& step, float* const* wet) noexcept;
+    // the legacy delay line read for one channel, faded from the old taps after a recall
+    float readLegacyTap (int channel, float modulation, const Coefficients& c) const noexcept;
+    // Runs the EQ over the first numSamples of wetBuffer and mixes it into buffer from
+    // `offset` on, with the ramp starting at `c`.
+    void mixWet (juce::AudioBuffer<float>& buffer, int offset, int numSamples, const Coefficients& c, const Coefficients& step) noexcept;
+    // block-rate settings of the engines and the LFO, which aren't ramped per sample
+    void updateEngines (const ReverbParameters& p) noexcept;
+    void resetLegacyState();
+    void resetEngine (int engine) noexcept;
+
+    // Delay memory for the current parameters. When they ask for more than the line
+    // holds, the audio thread posts a request, the timer allocates a bigger line from
+    // the pool, and the audio thread swaps it in at the start of a block.
+    int requiredDelayFrames (const ReverbParameters& p) const;
+    void swapInGrownDelayLine() noexcept;
+    void timerCallback() override;
+
+    // How long the wet signal takes to fall below silenceThreshold from full scale
+    // once the input stops, for the given engine.
+    double computeTailSeconds (const ReverbParameters& p, int engine) const;
+
+    Coefficients currentCoeffs, targetCoeffs;
+    int rampLengthSamples { 0 };
+    int rampSamplesRemaining { 0 };
+
+    // Jumps that a ramp can't smooth over fade over recallFadeLength instead. After an
+    // engine switch the old engine renders into fadingWet, holding the coefficients it
+    // had, and fades out under the new one. A recall on the legacy engine reads both the
+    // old taps and the new ones and fades between them.
+    int recallFadeLength { 1 };
+    int fadingEngine { legacyEngine };
+    int engineFadeRemaining { 0 };
+    Coefficients fadingCoeffs;
+    juce::AudioBuffer<float> fadingWet;
+    Coefficients tapFadeFrom;
+    int tapFadeRemaining { 0 };
+    void switchEngine (int engine) noexcept;
+    void startRecallFade() noexcept;
+    // skips the ramp for the legacy delay times, which would be heard as a pitch sweep
+    void jumpDelayTaps() noexcept;
+    void crossfadeEngines (const float* const* channels, int offset, int numSamples) noexcept;
+
+    // Every engine leaves its wet signal here, one chunk at a time, and the crossover
+    // EQ splits and weights it before it is mixed with the dry signal.
+    juce::AudioBuffer<float> wetBuffer;
+    CrossoverEQ crossover;
+
+    // Per-channel state as structure-of-arrays: lane n of each array is channel n, so
+    // the SIMD kernel loads all channels of a frame in one go.
+    using Vec = juce::dsp::SIMDRegister<float>;
+    static constexpr int maxLanes = 16;
+
+    struct Lanes
+    {
+        // each channel's share of delaySpread, so the channels' tails decorrelate
+        alignas (32) float delayOffset[maxLanes] {};
+        alignas (32) float lastDelayed[maxLanes] {};
+    };
+    Lanes lanes;
+
+    // One lane per channel, padded to a whole SIMD register per frame, drawn from
+    // the process-wide pool (which therefore has to outlive it).
+    juce::SharedResourcePointer<BufferPool> bufferPool;
+    DelayLine<float> delayLine;
+    float maxDelaySamples { 1.0f };
+    int delayLanes { 1 };
+    DelayStorage delayStorage { DelayStorage::native };
+
+    std::atomic<int> requestedDelayFrames { 0 };               // audio -> timer
+    int grantedDelayFrames { 0 };                              // timer only
+    std::atomic<DelayLine<float>*> grownDelayLine { nullptr };   // timer -> audio
+    std::atomic<DelayLine<float>*> retiredDelayLine { nullptr }; // audio -> timer
+    void deleteGrowthHandover() noexcept;
+
+    // recent input, written at the top of every block
+    CaptureBuffer capture;
+
+    // Previews go to the audio thread much like a grown delay line: the audio thread
+    // publishes which one it is reading, and the timer only lets go of retired ones it
+    // has moved off. A preview it picks up just as it is withdrawn is not played. Each
+    // one carries the number of the startAudition that sent it, which is how the audio
+    // thread tells a new preview from the last one: a freed preview's address may well
+    // come round again.
+    struct Audition
+    {
+        Preview preview;
+        juce::uint32 generation { 0 };
+    };
+    std::shared_ptr<const Audition> audition;                        // message thread
+    std::vector<std::shared_ptr<const Audition>> retiredAuditions;   // message thread
+    juce::uint32 auditionGeneration { 0 };                           // message thread
+    std::atomic<const Audition*> auditionRequest { nullptr };        // message -> audio
+    std::atomic<const Audition*> auditionInUse { nullptr };          // audio -> timer
+    juce::uint32 auditionPlaying { 0 };                              // its generation, 0 for none
+    int auditionPosition { 0 };
+    void playAudition (juce::AudioBuffer<float>& buffer) noexcept;
+
+    // delay modulation, one output per channel
+    LFO lfo;
+
+    bool useSIMD { false };
+    bool forceScalar { false };
+
+    // Idle bypass: once the input has been silent for a whole tail and the output
+    // has died away too, blocks are zero-filled without running the engine. Any input
+    // above the threshold wakes it up for that same block.
+    static constexpr float silenceThreshold = 3.1623e-5f;   // -90 dBFS
+    int tailSamples { 0 };
+    int silentInputSamples { 0 };
+    bool idle { false };
+
+    // The FDN and convolution engines are stereo, so a layout gets one of each per
+    // pair of output channels (a mono layout takes the mid of one pair). Each group is
+    // a different FDNReverb variant, so its tail decorrelates from the others' as
+    // `spread` goes up. Groups only read their own input channels and write their own
+    // rows of wetBuffer, which lets the worker pool run them side by side.
+    struct ChannelGroup
+    {
+        int firstChannel { 0 };
+        int numChannels { 2 };
+
+        // Two FDNs so a recalled preset can be crossfaded: the new settings go to a copy
+        // of the running one, which fades in while the old one plays on unchanged.
+        std::array<FDNReverb, 2> fdns;
+        int activeFdn { 0 };
+        int fdnFadeRemaining { 0 };
+
+        ConvolutionReverb convolution;
+
+        // the pair's wet output (which a mono group folds into one row of wetBuffer) and
+        // the outgoing FDN's during a crossfade, sized for the largest block we were prepared for
+        juce::AudioBuffer<float> wet, fadeWet;
+    };
+    std::vector<std::unique_ptr<ChannelGroup>> groups;
+    void processGroup (ChannelGroup& group, int engine, const float* const* channels, int offset, int numSamples,
+                       float* const* wet) noexcept;
+    void startFDNCrossfade (ChannelGroup& group) noexcept;
+    void crossfadeFDN (ChannelGroup& group, const float* inL, const float* inR, float* wetL, float* wetR, int numSamples) noexcept;
+
+    int numWorkerThreads { -1 };
+    std::unique_ptr<AudioWorkerPool> workerPool;
+
+    ChatHistory chatHistory;
+    Conversation conversation;
+
+   #if LLMEFFECTS_PERF_MONITOR
+    PerformanceMonitor performance;
+   #endif
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LLMEffectsAudioProcessor)
 };
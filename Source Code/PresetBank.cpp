@@ -0,0 +1,344 @@
+#include "PresetBank.h"
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+    const int bankFileMagic   = 0x504d4c4c; // "LLMP"
+    const int bankFileVersion = 1;
+
+    // magic, version, preset count, parameters per record, string blob size, padding
+    const int headerSize = 32;
+    // name offset and length, description offset and length, engine, then the parameters
+    const int recordHeaderSize = 20;
+
+    juce::File getDefaultBankFile()
+    {
+        return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+                   .getChildFile("LLMEffects")
+                   .getChildFile("presets.bin");
+    }
+
+    juce::uint32 readUInt (const char* data) noexcept
+    {
+        return juce::ByteOrder::littleEndianInt(data);
+    }
+
+    float readFloat (const char* data) noexcept
+    {
+        auto bits = readUInt(data);
+        float value;
+        std::memcpy(&value, &bits, sizeof (value));
+        return value;
+    }
+
+    // lower-case runs of letters and digits: "Big, dark hall" -> big dark hall
+    juce::StringArray splitWords (const juce::String& text)
+    {
+        juce::StringArray result;
+        juce::String word;
+        for (auto p = text.toLowerCase().getCharPointer(); ! p.isEmpty();)
+        {
+            auto c = p.getAndAdvance();
+            if (juce::CharacterFunctions::isLetterOrDigit(c))
+            {
+                word << juce::String::charToString(c);
+            }
+            else if (word.isNotEmpty())
+            {
+                result.add(word);
+                word.clear();
+            }
+        }
+        if (word.isNotEmpty())
+            result.add(word);
+        return result;
+    }
+
+    PresetBank::Preset makeFactoryPreset (const char* name, const char* description, int engine,
+                                          std::initializer_list<float> values)
+    {
+        PresetBank::Preset preset;
+        preset.name = name;
+        preset.description = description;
+        preset.engine = engine;
+        int i = 0;
+        for (auto value : values)
+            preset.parameters[i++] = value;
+        return preset;
+    }
+
+    std::vector<PresetBank::Preset> getFactoryPresets()
+    {
+        // decay, pre-delay, size, diffusion, density, damping, EQ low/mid/high, spread, modulation, mix
+        return {
+            makeFactoryPreset("Small Room", "tight natural room for drums and guitars", 1,
+                              { 0.4f, 0.005f, 0.6f, 0.7f, 0.8f, 0.4f, -2.0f, 0.0f, -1.0f, 0.4f, 0.2f, 0.25f }),
+            makeFactoryPreset("Vocal Plate", "bright smooth plate for vocals", 1,
+                              { 1.8f, 0.03f, 0.9f, 0.9f, 0.9f, 0.2f, -4.0f, 0.0f, 2.0f, 0.7f, 0.8f, 0.3f }),
+            makeFactoryPreset("Concert Hall", "warm wide hall for orchestral and piano", 1,
+                              { 2.6f, 0.04f, 1.6f, 0.7f, 0.7f, 0.55f, 1.0f, 0.0f, -2.0f, 0.8f, 0.4f, 0.35f }),
+            makeFactoryPreset("Cathedral", "huge dark stone space with a long tail", 1,
+                              { 4.8f, 0.08f, 2.0f, 0.6f, 0.8f, 0.7f, 2.0f, -1.0f, -4.0f, 0.9f, 0.3f, 0.45f }),
+            makeFactoryPreset("Ambient Wash", "lush modulated pad reverb", 1,
+                              { 4.0f, 0.12f, 1.8f, 0.95f, 1.0f, 0.45f, 0.0f, 0.0f, 0.0f, 1.0f, 2.5f, 0.6f }),
+            makeFactoryPreset("Slapback", "short single echo, dry and retro", 0,
+                              { 0.3f, 0.11f, 0.5f, 0.1f, 0.3f, 0.3f, -3.0f, 1.0f, -2.0f, 0.3f, 0.0f, 0.25f }),
+        };
+    }
+}
+
+PresetBank::PresetBank()
+    : file (getDefaultBankFile())
+{
+    if (! file.existsAsFile())
+        write(file, getFactoryPresets());
+    open();
+}
+
+PresetBank::PresetBank (const juce::File& bankFile)
+    : file (bankFile)
+{
+    open();
+}
+
+PresetBank::~PresetBank() {}
+
+int PresetBank::getNumPresets() const
+{
+    const juce::ScopedLock sl (lock);
+    return numPresets;
+}
+
+PresetBank::Preset PresetBank::getPreset (int index) const
+{
+    const juce::ScopedLock sl (lock);
+    Preset preset;
+    if (! juce::isPositiveAndBelow(index, numPresets))
+        return preset;
+
+    const char* record = getRecord(index);
+    preset.name = readString(readUInt(record), readUInt(record + 4));
+    preset.description = readString(readUInt(record + 8), readUInt(record + 12));
+    preset.engine = (int) readUInt(record + 16);
+
+    // a bank written with fewer parameters leaves the newer ones at their defaults
+    for (int i = 0; i < juce::jmin(numStoredParameters, (int) ReverbParameters::numParameters); ++i)
+        preset.parameters[i] = readFloat(record + recordHeaderSize + 4 * i);
+    preset.parameters = preset.parameters.clamped();
+    return preset;
+}
+
+int PresetBank::indexOf (const juce::String& name) const
+{
+    const juce::ScopedLock sl (lock);
+    auto key = name.trim().toLowerCase();
+
+    // records are sorted by lower-case name
+    int low = 0, high = numPresets;
+    while (low < high)
+    {
+        int mid = (low + high) / 2;
+        const char* record = getRecord(mid);
+        int order = readString(readUInt(record), readUInt(record + 4)).toLowerCase().compare(key);
+        if (order == 0)
+            return mid;
+        if (order < 0)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return -1;
+}
+
+std::vector<int> PresetBank::search (const juce::String& query, int maxResults) const
+{
+    const juce::ScopedLock sl (lock);
+    auto queryWords = splitWords(query);
+    // an empty query lists the bank without needing the index
+    if (! queryWords.isEmpty())
+        indexWords();
+
+    // matched[i] counts how many query words preset i has matched so far
+    std::vector<int> matched ((size_t) numPresets, 0);
+    for (int q = 0; q < queryWords.size(); ++q)
+    {
+        auto& prefix = queryWords[q];
+        auto it = std::lower_bound(words.begin(), words.end(), std::make_pair(prefix, -1));
+        for (; it != words.end() && it->first.startsWith(prefix); ++it)
+            if (matched[(size_t) it->second] == q)
+                matched[(size_t) it->second] = q + 1;
+    }
+
+    std::vector<int> results;
+    for (int i = 0; i < numPresets && (int) results.size() < maxResults; ++i)
+        if (matched[(size_t) i] == queryWords.size())
+            results.push_back(i);
+    return results;
+}
+
+bool PresetBank::store (const Preset& preset)
+{
+    const juce::ScopedLock sl (lock);
+    auto presets = readAll();
+    auto key = preset.name.trim().toLowerCase();
+    presets.erase(std::remove_if(presets.begin(), presets.end(),
+                                 [&key] (const Preset& p) { return p.name.toLowerCase() == key; }),
+                  presets.end());
+
+    auto added = preset;
+    added.name = preset.name.trim();
+    presets.push_back(added);
+    return rewrite(std::move(presets));
+}
+
+bool PresetBank::remove (const juce::String& name)
+{
+    const juce::ScopedLock sl (lock);
+    int index = indexOf(name);
+    if (index < 0)
+        return false;
+
+    auto presets = readAll();
+    presets.erase(presets.begin() + index);
+    return rewrite(std::move(presets));
+}
+
+bool PresetBank::write (const juce::File& bankFile, std::vector<Preset> presets)
+{
+    std::sort(presets.begin(), presets.end(),
+              [] (const Preset& a, const Preset& b) { return a.name.toLowerCase() < b.name.toLowerCase(); });
+
+    juce::MemoryOutputStream blob;
+    juce::MemoryOutputStream out;
+    out.writeInt(bankFileMagic);
+    out.writeInt(bankFileVersion);
+    out.writeInt((int) presets.size());
+    out.writeInt(ReverbParameters::numParameters);
+
+    std::vector<std::pair<juce::uint32, juce::uint32>> nameSpans, descriptionSpans;
+    for (auto& preset : presets)
+    {
+        auto addString = [&blob] (const juce::String& text)
+        {
+            auto offset = (juce::uint32) blob.getDataSize();
+            blob.write(text.toRawUTF8(), text.getNumBytesAsUTF8());
+            return std::make_pair(offset, (juce::uint32) (blob.getDataSize() - offset));
+        };
+        nameSpans.push_back(addString(preset.name));
+        descriptionSpans.push_back(addString(preset.description));
+    }
+
+    out.writeInt((int) blob.getDataSize());
+    while ((int) out.getDataSize() < headerSize)
+        out.writeByte(0);
+
+    for (size_t i = 0; i < presets.size(); ++i)
+    {
+        out.writeInt((int) nameSpans[i].first);
+        out.writeInt((int) nameSpans[i].second);
+        out.writeInt((int) descriptionSpans[i].first);
+        out.writeInt((int) descriptionSpans[i].second);
+        out.writeInt(presets[i].engine);
+        for (int p = 0; p < ReverbParameters::numParameters; ++p)
+            out.writeFloat(presets[i].parameters[p]);
+    }
+    out << blob;
+
+    // same temp-and-swap as the response cache, so a crash never leaves a torn bank
+    bankFile.getParentDirectory().createDirectory();
+    juce::TemporaryFile temp (bankFile);
+    return temp.getFile().replaceWithData(out.getData(), out.getDataSize())
+        && temp.overwriteTargetFileWithTemporary();
+}
+
+void PresetBank::open()
+{
+    close();
+    if (! file.existsAsFile())
+        return;
+
+    auto map = std::make_unique<juce::MemoryMappedFile>(file, juce::MemoryMappedFile::readOnly);
+    auto* data = static_cast<const char*>(map->getData());
+    auto size = map->getSize();
+    if (data == nullptr || size < (size_t) headerSize
+         || (int) readUInt(data) != bankFileMagic || (int) readUInt(data + 4) != bankFileVersion)
+        return;
+
+    int count = (int) readUInt(data + 8);
+    int storedParameters = (int) readUInt(data + 12);
+    auto blobBytes = readUInt(data + 16);
+    if (count < 0 || storedParameters < 0 || storedParameters > 1024)
+        return;
+
+    int bytesPerRecord = recordHeaderSize + 4 * storedParameters;
+    if ((juce::uint64) headerSize + (juce::uint64) count * (juce::uint64) bytesPerRecord + blobBytes > size)
+        return;
+
+    mapped = std::move(map);
+    records = data + headerSize;
+    strings = records + (size_t) count * (size_t) bytesPerRecord;
+    stringBytes = blobBytes;
+    numPresets = count;
+    numStoredParameters = storedParameters;
+    recordSize = bytesPerRecord;
+}
+
+void PresetBank::close()
+{
+    mapped.reset();
+    records = strings = nullptr;
+    stringBytes = 0;
+    numPresets = numStoredParameters = recordSize = 0;
+    words.clear();
+    wordsIndexed = false;
+}
+
+// the one pass that touches every record, so it waits until something searches
+void PresetBank::indexWords() const
+{
+    if (wordsIndexed)
+        return;
+
+    for (int i = 0; i < numPresets; ++i)
+    {
+        const char* record = getRecord(i);
+        auto text = readString(readUInt(record), readUInt(record + 4)) + " "
+                  + readString(readUInt(record + 8), readUInt(record + 12));
+        for (auto& word : splitWords(text))
+            words.emplace_back(word, i);
+    }
+    std::sort(words.begin(), words.end());
+    words.erase(std::unique(words.begin(), words.end()), words.end());
+    wordsIndexed = true;
+}
+
+bool PresetBank::rewrite (std::vector<Preset> presets)
+{
+    // the file can't be replaced while it is mapped on every platform
+    close();
+    bool written = write(file, std::move(presets));
+    open();
+    return written;
+}
+
+std::vector<PresetBank::Preset> PresetBank::readAll() const
+{
+    std::vector<Preset> presets;
+    presets.reserve((size_t) numPresets);
+    for (int i = 0; i < numPresets; ++i)
+        presets.push_back(getPreset(i));
+    return presets;
+}
+
+juce::String PresetBank::readString (juce::uint32 offset, juce::uint32 numBytes) const
+{
+    if ((juce::uint64) offset + numBytes > stringBytes)
+        return {};
+    return juce::String::fromUTF8(strings + offset, (int) numBytes);
+}
+
+const char* PresetBank::getRecord (int index) const
+{
+    return records + (size_t) index * (size_t) recordSize;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <memory>
+#include <utility>
+#include <vector>
+#include "ReverbParameters.h"
+
+// Named parameter sets kept in one binary file that is memory-mapped rather than read,
+// so opening a large bank costs a page fault per preset actually looked at. Records are
+// fixed-size and sorted by name; names and descriptions live in a string blob after
+// them. A word index over both is built by the first search(), which reads every
+// record once; after that a search is a couple of binary searches per query word. Shared by all plugin instances in the
+// process via juce::SharedResourcePointer; edits rewrite the file and remap it.
+class PresetBank
+{
+public:
+    struct Preset
+    {
+        juce::String name;
+        juce::String description;
+        ReverbParameters parameters;
+        int engine { 0 };
+    };
+
+    // The user's bank, written with a few factory presets the first time.
+    PresetBank();
+    explicit PresetBank (const juce::File& bankFile);
+    ~PresetBank();
+
+    int getNumPresets() const;
+    Preset getPreset (int index) const;
+    // Index of the preset with this name (case-insensitive), or -1.
+    int indexOf (const juce::String& name) const;
+
+    // Presets where every word of the query starts a word of the name or description,
+    // in name order. An empty query matches everything.
+    std::vector<int> search (const juce::String& query, int maxResults = 100) const;
+
+    // Adds the preset, replacing any with the same name. Returns false if the bank
+    // couldn't be written.
+    bool store (const Preset& preset);
+    bool remove (const juce::String& name);
+
+    static bool write (const juce::File& bankFile, std::vector<Preset> presets);
+
+private:
+    void open();
+    void close();
+    bool rewrite (std::vector<Preset> presets);
+    std::vector<Preset> readAll() const;
+    juce::String readString (juce::uint32 offset, juce::uint32 numBytes) const;
+    const char* getRecord (int index) const;
+    void indexWords() const;
+
+    const juce::File file;
+
+    juce::CriticalSection lock;
+    std::unique_ptr<juce::MemoryMappedFile> mapped;
+    const char* records { nullptr };
+    const char* strings { nullptr };
+    juce::uint32 stringBytes { 0 };
+    int numPresets { 0 };
+    int numStoredParameters { 0 };
+    int recordSize { 0 };
+
+    // (lower-case word, preset index), sorted, so a prefix is an equal_range away;
+    // built on the first search after the bank is (re)opened
+    mutable std::vector<std::pair<juce::String, int>> words;
+    mutable bool wordsIndexed { false };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PresetBank)
+};
@@ -0,0 +1,125 @@
+#include "PreviewRenderer.h"
+
+namespace
+{
+    const int previewBlockSize = 512;
+}
+
+PreviewRenderer::PreviewRenderer()
+    : pool (juce::ThreadPoolOptions()
+                .withThreadName("LLMEffects preview")
+                .withNumberOfThreads(juce::jlimit(1, maxCandidates, juce::SystemStats::getNumCpus() - 1))
+                .withDesiredThreadPriority(juce::Thread::Priority::low))
+{
+}
+
+PreviewRenderer::~PreviewRenderer()
+{
+    ++generation;
+    pool.removeAllJobs(true, -1);
+    cancelPendingUpdate();
+}
+
+void PreviewRenderer::render (std::shared_ptr<const juce::AudioBuffer<float>> snippet, double sampleRate,
+                              const juce::AudioProcessor::BusesLayout& layout, int engine,
+                              const std::vector<ReverbParameters>& candidates)
+{
+    cancel();
+    if (snippet == nullptr || snippet->getNumSamples() == 0)
+        return;
+
+    int current = generation.load();
+    int count = juce::jmin((int) candidates.size(), maxCandidates);
+    for (int i = 0; i < count; ++i)
+    {
+        auto& processor = processors[(size_t) i];
+        if (processor == nullptr)
+            processor = std::make_unique<LLMEffectsAudioProcessor>();
+
+        Job job;
+        job.snippet = snippet;
+        job.sampleRate = sampleRate;
+        job.layout = layout;
+        job.engine = engine;
+        job.parameters = candidates[(size_t) i];
+        job.index = i;
+        job.generation = current;
+        pool.addJob([this, job] { renderJob(job); });
+    }
+}
+
+void PreviewRenderer::cancel()
+{
+    // a stale job notices within a block and gives up, so this doesn't wait long
+    ++generation;
+    pool.removeAllJobs(true, -1);
+
+    const juce::ScopedLock sl (lock);
+    for (auto& preview : previews)
+        preview.reset();
+}
+
+PreviewRenderer::Preview PreviewRenderer::getPreview (int index) const
+{
+    const juce::ScopedLock sl (lock);
+    return juce::isPositiveAndBelow(index, maxCandidates) ? previews[(size_t) index] : nullptr;
+}
+
+void PreviewRenderer::renderJob (const Job& job)
+{
+    auto& processor = *processors[(size_t) job.index];
+    auto& snippet = *job.snippet;
+    int numChannels = snippet.getNumChannels();
+    int length = snippet.getNumSamples();
+
+    if (numChannels != job.layout.getMainInputChannels() || ! processor.setBusesLayout(job.layout))
+        return;
+
+    // parameters before prepareToPlay, which sizes the delay memory for them
+    processor.setNonRealtime(true);
+    processor.setEngine(job.engine);
+    processor.applyParameters(job.parameters);
+    processor.setRateAndBufferSizeDetails(job.sampleRate, previewBlockSize);
+    processor.prepareToPlay(job.sampleRate, previewBlockSize);
+
+    for (int waited = 0; ! processor.isEngineReady() && waited < 10000 && ! isStale(job); waited += 10)
+        juce::Thread::sleep(10);
+
+    auto preview = std::make_shared<juce::AudioBuffer<float>>(numChannels, length);
+    juce::MidiBuffer midi;
+
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        for (int position = 0; position < length; position += previewBlockSize)
+        {
+            if (isStale(job))
+            {
+                processor.releaseResources();
+                return;
+            }
+
+            // processed in place, straight into the preview
+            int numSamples = juce::jmin(previewBlockSize, length - position);
+            juce::AudioBuffer<float> chunk (preview->getArrayOfWritePointers(), numChannels, position, numSamples);
+            for (int channel = 0; channel < numChannels; ++channel)
+                chunk.copyFrom(channel, 0, snippet, channel, position, numSamples);
+            processor.processBlock(chunk, midi);
+        }
+    }
+
+    processor.releaseResources();
+
+    {
+        const juce::ScopedLock sl (lock);
+        if (isStale(job))
+            return;
+        previews[(size_t) job.index] = std::move(preview);
+    }
+    triggerAsyncUpdate();
+}
+
+void PreviewRenderer::handleAsyncUpdate()
+{
+    if (onPreviewsChanged != nullptr)
+        onPreviewsChanged();
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include "PluginProcessor.h"
+#include "ReverbParameters.h"
+
+// Renders each of a set of candidate parameter sets over the same snippet of input, on
+// low-priority background threads, so they can be auditioned side by side. Every
+// candidate gets its own offline instance of the processor. The snippet goes through
+// twice and only the second pass is kept, so a preview played in a loop carries its
+// own tail over from its end back into its start.
+//
+// Everything here is called on the message thread, and so is onPreviewsChanged.
+class PreviewRenderer  : private juce::AsyncUpdater
+{
+public:
+    static constexpr int maxCandidates = 4;
+
+    using Preview = LLMEffectsAudioProcessor::Preview;
+
+    PreviewRenderer();
+    ~PreviewRenderer() override;
+
+    // Drops whatever is still rendering and starts on the new candidates.
+    void render (std::shared_ptr<const juce::AudioBuffer<float>> snippet, double sampleRate,
+                 const juce::AudioProcessor::BusesLayout& layout, int engine,
+                 const std::vector<ReverbParameters>& candidates);
+    void cancel();
+
+    // Null until that candidate has finished rendering.
+    Preview getPreview (int index) const;
+
+    std::function<void()> onPreviewsChanged;
+
+private:
+    struct Job
+    {
+        std::shared_ptr<const juce::AudioBuffer<float>> snippet;
+        double sampleRate { 44100.0 };
+        juce::AudioProcessor::BusesLayout layout;
+        int engine { 0 };
+        ReverbParameters parameters;
+        int index { 0 };
+        int generation { 0 };
+    };
+
+    void renderJob (const Job& job);
+    bool isStale (const Job& job) const { return job.generation != generation.load(); }
+    void handleAsyncUpdate() override;
+
+    // made on the message thread like a host would, and kept for the next round
+    std::array<std::unique_ptr<LLMEffectsAudioProcessor>, maxCandidates> processors;
+
+    std::atomic<int> generation { 0 };
+    mutable juce::CriticalSection lock;
+    std::array<Preview, maxCandidates> previews;
+
+    juce::ThreadPool pool;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PreviewRenderer)
+};
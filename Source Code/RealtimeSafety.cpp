@@ -0,0 +1,122 @@
+#include "RealtimeSafety.h"
+#include <cstdlib>
+
+#if JUCE_LINUX || JUCE_MAC || JUCE_BSD
+ #include <execinfo.h>
+ #define LLMEFFECTS_HAS_BACKTRACE 1
+#else
+ #define LLMEFFECTS_HAS_BACKTRACE 0
+#endif
+
+namespace
+{
+    constexpr int capacity = 256;
+
+    std::atomic<bool> enabled { false };
+    RealtimeSafety::Violation violations[capacity];
+    std::atomic<int> numClaimed { 0 };   // slots handed out, may run past capacity
+    std::atomic<int> numWritten { 0 };   // slots completely filled in
+
+    // callback depth, and > 0 while an allowed call or a recording is in progress
+    thread_local int audioDepth = 0;
+    thread_local int suppressDepth = 0;
+}
+
+RealtimeSafety::ScopedAudioThread::ScopedAudioThread() noexcept  { ++audioDepth; }
+RealtimeSafety::ScopedAudioThread::~ScopedAudioThread() noexcept { --audioDepth; }
+
+RealtimeSafety::ScopedAllow::ScopedAllow() noexcept  { ++suppressDepth; }
+RealtimeSafety::ScopedAllow::~ScopedAllow() noexcept { --suppressDepth; }
+
+void RealtimeSafety::setEnabled (bool shouldBeEnabled) noexcept
+{
+   #if LLMEFFECTS_HAS_BACKTRACE
+    // the first backtrace() loads the unwinder, which allocates; get that over with
+    if (shouldBeEnabled)
+    {
+        void* frames[2];
+        backtrace(frames, 2);
+    }
+   #endif
+    enabled.store(shouldBeEnabled);
+}
+
+bool RealtimeSafety::isEnabled() noexcept
+{
+    return enabled.load(std::memory_order_relaxed);
+}
+
+void RealtimeSafety::check (Kind kind, const char* function) noexcept
+{
+    if (audioDepth == 0 || suppressDepth > 0 || ! enabled.load(std::memory_order_relaxed))
+        return;
+
+    ++suppressDepth;
+    int slot = numClaimed.fetch_add(1, std::memory_order_relaxed);
+    if (slot < capacity)
+    {
+        auto& v = violations[slot];
+        v.kind = kind;
+        v.function = function;
+       #if LLMEFFECTS_HAS_BACKTRACE
+        v.numFrames = backtrace(v.frames, maxFrames);
+       #else
+        v.numFrames = 0;
+       #endif
+        numWritten.fetch_add(1, std::memory_order_release);
+    }
+    --suppressDepth;
+}
+
+std::vector<RealtimeSafety::Violation> RealtimeSafety::takeViolations()
+{
+    int claimed = juce::jmin(capacity, numClaimed.load(std::memory_order_acquire));
+
+    // a hook may still be filling in its slot
+    while (numWritten.load(std::memory_order_acquire) < claimed)
+        juce::Thread::yield();
+
+    std::vector<Violation> result (violations, violations + claimed);
+    numWritten.store(0);
+    numClaimed.store(0);
+    return result;
+}
+
+int RealtimeSafety::getNumDropped() noexcept
+{
+    return juce::jmax(0, numClaimed.load() - capacity);
+}
+
+const char* RealtimeSafety::getKindName (Kind kind) noexcept
+{
+    switch (kind)
+    {
+        case Kind::allocation:   return "allocation";
+        case Kind::deallocation: return "deallocation";
+        case Kind::lock:         return "lock";
+        case Kind::fileAccess:   return "file access";
+        case Kind::network:      return "network";
+        case Kind::sleep:        return "sleep";
+    }
+    return "unknown";
+}
+
+juce::String RealtimeSafety::describe (const Violation& violation)
+{
+    juce::String text;
+    text << getKindName(violation.kind) << " in the audio callback: " << violation.function << "\n";
+
+   #if LLMEFFECTS_HAS_BACKTRACE
+    // skip check() itself and the hook that called it
+    const int firstFrame = 2;
+    if (char** symbols = backtrace_symbols(violation.frames, violation.numFrames))
+    {
+        for (int i = firstFrame; i < violation.numFrames; ++i)
+            text << "    " << symbols[i] << "\n";
+        std::free(symbols);
+    }
+   #else
+    text << "    (no stack trace on this platform)\n";
+   #endif
+    return text;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+#include <vector>
+
+// Audio-thread checks are a test build option: LLMEFFECTS_REALTIME_CHECKS=1 makes
+// processBlock mark its thread so that hooks on allocation, locking and I/O (see
+// Tools/Benchmark/RealtimeHooks.cpp) can report anything the callback shouldn't do.
+#ifndef LLMEFFECTS_REALTIME_CHECKS
+ #define LLMEFFECTS_REALTIME_CHECKS 0
+#endif
+
+// Records calls that can block made from inside the audio callback, with the stack
+// they came from. The hooks only call check(); the recording path doesn't allocate or
+// lock, and ignores anything the recording itself triggers.
+class RealtimeSafety
+{
+public:
+    enum class Kind
+    {
+        allocation,
+        deallocation,
+        lock,
+        fileAccess,
+        network,
+        sleep
+    };
+
+    static constexpr int maxFrames = 32;
+
+    struct Violation
+    {
+        Kind kind;
+        const char* function;
+        void* frames[maxFrames];
+        int numFrames;
+    };
+
+    // Marks the calling thread as running the audio callback for the scope's lifetime.
+    struct ScopedAudioThread
+    {
+        ScopedAudioThread() noexcept;
+        ~ScopedAudioThread() noexcept;
+    };
+
+    // A deliberate exception inside the callback, e.g. waking a worker thread.
+    struct ScopedAllow
+    {
+        ScopedAllow() noexcept;
+        ~ScopedAllow() noexcept;
+    };
+
+    static void setEnabled (bool shouldBeEnabled) noexcept;
+    static bool isEnabled() noexcept;
+
+    // Called by the hooks: records a violation if this thread is in the callback.
+    static void check (Kind kind, const char* function) noexcept;
+
+    // Returns and clears what has been recorded. Not for the audio thread.
+    static std::vector<Violation> takeViolations();
+    static int getNumDropped() noexcept;
+
+    static const char* getKindName (Kind kind) noexcept;
+    // One line for the call, then the symbolised stack, one frame per line.
+    static juce::String describe (const Violation& violation);
+};
+
+#if LLMEFFECTS_REALTIME_CHECKS
+ #define LLMEFFECTS_AUDIO_THREAD_SCOPE const RealtimeSafety::ScopedAudioThread audioThreadScope_
+ #define LLMEFFECTS_ALLOW_BLOCKING const RealtimeSafety::ScopedAllow allowBlocking_
+#else
+ #define LLMEFFECTS_AUDIO_THREAD_SCOPE
+ #define LLMEFFECTS_ALLOW_BLOCKING
+#endif
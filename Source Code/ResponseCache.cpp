@@ -0,0 +1,177 @@
+#include "ResponseCache.h"
+
+namespace
+{
+    const int cacheFileMagic   = 0x434d4c4c; // "LLMC"
+    const int cacheFileVersion = 1;
+
+    juce::File getDefaultCacheFile()
+    {
+        return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+                   .getChildFile("LLMEffects")
+                   .getChildFile("response-cache.bin");
+    }
+
+    // "More  air!" and "more air" should hit the same entry
+    juce::String normalisePrompt (const juce::String& prompt)
+    {
+        juce::String result;
+        bool pendingSpace = false;
+        for (auto p = prompt.toLowerCase().getCharPointer(); ! p.isEmpty();)
+        {
+            auto c = p.getAndAdvance();
+            if (juce::CharacterFunctions::isLetterOrDigit(c))
+            {
+                if (pendingSpace && result.isNotEmpty())
+                    result << " ";
+                result << juce::String::charToString(c);
+                pendingSpace = false;
+            }
+            else
+            {
+                pendingSpace = true;
+            }
+        }
+        return result;
+    }
+}
+
+ResponseCache::ResponseCache()
+    : ResponseCache (getDefaultCacheFile())
+{
+}
+
+ResponseCache::ResponseCache (const juce::File& storeFile, int maxEntriesToKeep)
+    : file (storeFile), maxEntries (juce::jmax(1, maxEntriesToKeep))
+{
+    load();
+}
+
+ResponseCache::~ResponseCache() {}
+
+juce::String ResponseCache::makeKey (const juce::String& prompt, const ReverbParameters& parameters,
+                                     const juce::String& model, const juce::String& context)
+{
+    juce::String key;
+    key << model << "\n" << normalisePrompt(prompt) << "\n";
+    for (int i = 0; i < ReverbParameters::numParameters; ++i)
+    {
+        auto& info = ReverbParameters::getInfo(i);
+        int step = juce::roundToInt((parameters[i] - info.minValue) / (info.maxValue - info.minValue) * 100.0f);
+        key << step << (i + 1 < ReverbParameters::numParameters ? "," : "");
+    }
+    if (context.isNotEmpty())
+        key << "\n" << juce::String::toHexString(context.hashCode64());
+    return key;
+}
+
+bool ResponseCache::lookup (const juce::String& key, juce::String& response)
+{
+    const juce::ScopedLock sl (lock);
+    auto found = index.find(key.hashCode64());
+    if (found == index.end() || found->second->key != key)
+    {
+        ++misses;
+        return false;
+    }
+
+    entries.splice(entries.begin(), entries, found->second);
+    response = found->second->response;
+    ++hits;
+    return true;
+}
+
+void ResponseCache::store (const juce::String& key, const juce::String& response)
+{
+    {
+        const juce::ScopedLock sl (lock);
+        auto hash = key.hashCode64();
+        auto found = index.find(hash);
+        if (found != index.end())
+            entries.erase(found->second);
+
+        entries.push_front({ key, response });
+        index[hash] = entries.begin();
+        evictToCapacity();
+    }
+    save();
+}
+
+void ResponseCache::clear()
+{
+    {
+        const juce::ScopedLock sl (lock);
+        entries.clear();
+        index.clear();
+    }
+    save();
+}
+
+ResponseCache::Stats ResponseCache::getStats() const
+{
+    const juce::ScopedLock sl (lock);
+    Stats stats;
+    stats.hits = hits;
+    stats.misses = misses;
+    stats.entries = static_cast<int>(entries.size());
+    return stats;
+}
+
+void ResponseCache::evictToCapacity()
+{
+    while (static_cast<int>(entries.size()) > maxEntries)
+    {
+        index.erase(entries.back().key.hashCode64());
+        entries.pop_back();
+    }
+}
+
+void ResponseCache::load()
+{
+    juce::MemoryBlock data;
+    if (! file.existsAsFile() || ! file.loadFileAsData(data))
+        return;
+
+    juce::MemoryInputStream in (data, false);
+    if (in.readInt() != cacheFileMagic || in.readInt() != cacheFileVersion)
+        return;
+
+    int count = in.readInt();
+    const juce::ScopedLock sl (lock);
+    for (int i = 0; i < count && ! in.isExhausted(); ++i)
+    {
+        Entry entry;
+        entry.key = in.readString();
+        entry.response = in.readString();
+
+        auto hash = entry.key.hashCode64();
+        if (index.find(hash) != index.end())
+            continue;
+
+        entries.push_back(entry);
+        index[hash] = std::prev(entries.end());
+    }
+    evictToCapacity();
+}
+
+void ResponseCache::save() const
+{
+    juce::MemoryOutputStream out;
+    {
+        const juce::ScopedLock sl (lock);
+        out.writeInt(cacheFileMagic);
+        out.writeInt(cacheFileVersion);
+        out.writeInt(static_cast<int>(entries.size()));
+        for (auto& entry : entries)
+        {
+            out.writeString(entry.key);
+            out.writeString(entry.response);
+        }
+    }
+
+    // write to a temp file and swap it in, so a crash never leaves a torn cache behind
+    file.getParentDirectory().createDirectory();
+    juce::TemporaryFile temp (file);
+    if (temp.getFile().replaceWithData(out.getData(), out.getDataSize()))
+        temp.overwriteTargetFileWithTemporary();
+}
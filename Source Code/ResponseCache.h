@@ -0,0 +1,59 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <list>
+#include <unordered_map>
+#include "ReverbParameters.h"
+
+// Prompt -> LLM answer cache, so repeating a prompt against the same settings skips
+// the network entirely. Entries are keyed on the normalised prompt, the parameters
+// quantised to 1% of their range and the model name. It is an in-memory LRU capped
+// at maxEntries, mirrored to a small binary file that is read once at startup.
+// Shared by all plugin instances in the process via juce::SharedResourcePointer.
+class ResponseCache
+{
+public:
+    struct Stats
+    {
+        int hits { 0 };
+        int misses { 0 };
+        int entries { 0 };
+    };
+
+    ResponseCache();
+    explicit ResponseCache (const juce::File& storeFile, int maxEntries = 512);
+    ~ResponseCache();
+
+    // `context` stands for whatever else the answer depends on, e.g. the turn before,
+    // so a follow-up like "a bit less" only hits after the same answer.
+    static juce::String makeKey (const juce::String& prompt, const ReverbParameters& parameters,
+                                 const juce::String& model, const juce::String& context = {});
+
+    // Returns true and fills `response` on a hit.
+    bool lookup (const juce::String& key, juce::String& response);
+    void store (const juce::String& key, const juce::String& response);
+    void clear();
+
+    Stats getStats() const;
+
+private:
+    struct Entry
+    {
+        juce::String key;
+        juce::String response;
+    };
+
+    void load();
+    void save() const;
+    void evictToCapacity();
+
+    const juce::File file;
+    const int maxEntries;
+
+    juce::CriticalSection lock;
+    std::list<Entry> entries;    // most recently used first
+    std::unordered_map<juce::int64, std::list<Entry>::iterator> index;
+    int hits { 0 }, misses { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ResponseCache)
+};
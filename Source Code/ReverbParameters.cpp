@@ -0,0 +1,87 @@
+#include "ReverbParameters.h"
+
+namespace
+{
+    const ReverbParameters::Info infos[ReverbParameters::numParameters] = {
+        { "decayTime",  "Decay Time (s)", 0.1f,   5.0f, 0.01f,  1.0f,  &ReverbParameters::decayTime },
+        { "preDelay",   "Pre-Delay (s)",  0.0f,   0.5f, 0.001f, 0.05f, &ReverbParameters::preDelay },
+        { "size",       "Size",           0.5f,   2.0f, 0.01f,  1.0f,  &ReverbParameters::size },
+        { "diffusion",  "Diffusion",      0.0f,   1.0f, 0.01f,  0.5f,  &ReverbParameters::diffusion },
+        { "density",    "Density",        0.0f,   1.0f, 0.01f,  0.5f,  &ReverbParameters::density },
+        { "damping",    "Damping",        0.0f,   1.0f, 0.01f,  0.5f,  &ReverbParameters::damping },
+        { "eqLow",      "EQ Low (dB)",   -12.0f, 12.0f, 0.1f,   0.0f,  &ReverbParameters::eqLow },
+        { "eqMid",      "EQ Mid (dB)",   -12.0f, 12.0f, 0.1f,   0.0f,  &ReverbParameters::eqMid },
+        { "eqHigh",     "EQ High (dB)",  -12.0f, 12.0f, 0.1f,   0.0f,  &ReverbParameters::eqHigh },
+        { "spread",     "Spread",         0.0f,   1.0f, 0.01f,  0.5f,  &ReverbParameters::spread },
+        { "modulation", "Modulation",     0.0f,  10.0f, 0.1f,   0.0f,  &ReverbParameters::modulation },
+        { "wetDryMix",  "Wet/Dry Mix",    0.0f,   1.0f, 0.01f,  0.5f,  &ReverbParameters::wetDryMix },
+        { "eqLowFreq",  "EQ Low/Mid (Hz)",  50.0f, 1000.0f,  1.0f,  200.0f, &ReverbParameters::eqLowFrequency },
+        { "eqHighFreq", "EQ Mid/High (Hz)", 1000.0f, 12000.0f, 10.0f, 3000.0f, &ReverbParameters::eqHighFrequency },
+    };
+}
+
+const ReverbParameters::Info& ReverbParameters::getInfo (int index)
+{
+    jassert (index >= 0 && index < numParameters);
+    return infos[index];
+}
+
+int ReverbParameters::indexOf (const juce::String& id)
+{
+    for (int i = 0; i < numParameters; ++i)
+        if (id == infos[i].id)
+            return i;
+    return -1;
+}
+
+juce::AudioProcessorValueTreeState::ParameterLayout ReverbParameters::createParameterLayout()
+{
+    juce::AudioProcessorValueTreeState::ParameterLayout layout;
+    for (auto& info : infos)
+    {
+        layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID { info.id, 1 },
+                                                               info.name,
+                                                               juce::NormalisableRange<float> (info.minValue, info.maxValue, info.interval),
+                                                               info.defaultValue));
+    }
+    return layout;
+}
+
+bool ReverbParameters::operator== (const ReverbParameters& other) const
+{
+    for (int i = 0; i < numParameters; ++i)
+        if ((*this)[i] != other[i])
+            return false;
+    return true;
+}
+
+ReverbParameters ReverbParameters::clamped() const
+{
+    ReverbParameters result;
+    for (int i = 0; i < numParameters; ++i)
+        result[i] = juce::jlimit(infos[i].minValue, infos[i].maxValue, (*this)[i]);
+    return result;
+}
+
+juce::var ReverbParameters::toVar() const
+{
+    juce::DynamicObject::Ptr obj = new juce::DynamicObject();
+    for (int i = 0; i < numParameters; ++i)
+        obj->setProperty(infos[i].id, (*this)[i]);
+    return juce::var(obj.get());
+}
+
+ReverbParameters ReverbParameters::fromVar (const juce::var& object, const ReverbParameters& base)
+{
+    ReverbParameters result = base;
+    if (auto* obj = object.getDynamicObject())
+    {
+        for (int i = 0; i < numParameters; ++i)
+        {
+            juce::Identifier id (infos[i].id);
+            if (obj->hasProperty(id))
+                result[i] = (float) static_cast<double>(obj->getProperty(id));
+        }
+    }
+    return result.clamped();
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+// The reverb parameters as a plain value type, so a complete set can be
+// handed around (LLM responses, presets) and published to the audio thread in one go.
+struct ReverbParameters
+{
+    enum Index
+    {
+        decayTimeIndex,
+        preDelayIndex,
+        sizeIndex,
+        diffusionIndex,
+        densityIndex,
+        dampingIndex,
+        eqLowIndex,
+        eqMidIndex,
+        eqHighIndex,
+        spreadIndex,
+        modulationIndex,
+        wetDryMixIndex,
+        // appended, so preset banks written before these existed still line up
+        eqLowFrequencyIndex,
+        eqHighFrequencyIndex,
+        numParameters
+    };
+
+    struct Info
+    {
+        const char* id;
+        const char* name;
+        float minValue, maxValue, interval, defaultValue;
+        float ReverbParameters::* member;
+    };
+
+    static const Info& getInfo (int index);
+    // Index of the parameter with this id ("decayTime", ...), or -1.
+    static int indexOf (const juce::String& id);
+    static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
+
+    float decayTime   { 1.0f };
+    float preDelay    { 0.05f };
+    float size        { 1.0f };
+    float diffusion   { 0.5f };
+    float density     { 0.5f };
+    float damping     { 0.5f };
+    float eqLow       { 0.0f };
+    float eqMid       { 0.0f };
+    float eqHigh      { 0.0f };
+    float spread      { 0.5f };
+    float modulation  { 0.0f };
+    float wetDryMix   { 0.5f };
+    float eqLowFrequency  { 200.0f };    // crossovers between the EQ bands, in Hz
+    float eqHighFrequency { 3000.0f };
+
+    float& operator[] (int index)       { return this->*(getInfo(index).member); }
+    float operator[] (int index) const  { return this->*(getInfo(index).member); }
+
+    bool operator== (const ReverbParameters& other) const;
+    bool operator!= (const ReverbParameters& other) const { return ! operator== (other); }
+
+    // Clamps every value into its legal range.
+    ReverbParameters clamped() const;
+
+    // JSON shape used by the LLM: { "decayTime": 1.0, "preDelay": 0.05, ... }
+    juce::var toVar() const;
+    // Keys missing from the object keep the value they have in `base`.
+    static ReverbParameters fromVar (const juce::var& object, const ReverbParameters& base);
+};
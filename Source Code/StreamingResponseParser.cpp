@@ -0,0 +1,216 @@
+#include "StreamingResponseParser.h"
+#include "ReverbParameters.h"
+
+void StreamingResponseParser::reset()
+{
+    state = State::beforeRoot;
+    stack.clear();
+    text.clear();
+    token.clear();
+    pendingExplanation.clear();
+    stringIsKey = false;
+    explanationStreamed = false;
+    numParametersApplied = 0;
+}
+
+void StreamingResponseParser::feed (const juce::String& fragment)
+{
+    text += fragment;
+
+    for (auto p = fragment.getCharPointer(); ! p.isEmpty();)
+        process(p.getAndAdvance());
+
+    // hand the explanation on once per fragment rather than once per character
+    if (pendingExplanation.isNotEmpty())
+    {
+        explanationStreamed = true;
+        auto chunk = pendingExplanation;
+        pendingExplanation.clear();
+        if (onExplanationText != nullptr)
+            onExplanationText(chunk);
+    }
+}
+
+void StreamingResponseParser::process (juce::juce_wchar c)
+{
+    switch (state)
+    {
+        case State::beforeRoot:
+            if (c == '{')
+            {
+                stack.push_back({});
+                state = State::value;
+            }
+            return;
+
+        case State::done:
+            return;
+
+        case State::string:
+            if (c == '\\')
+                state = State::escape;
+            else if (c == '"')
+                finishString();
+            else
+                appendStringChar(c);
+            return;
+
+        case State::escape:
+            state = State::string;
+            switch (c)
+            {
+                case 'n': appendStringChar('\n'); break;
+                case 't': appendStringChar('\t'); break;
+                case 'r': appendStringChar('\r'); break;
+                case 'b': appendStringChar('\b'); break;
+                case 'f': appendStringChar('\f'); break;
+                case 'u': state = State::unicode; unicodeDigits = 0; unicodeValue = 0; break;
+                default:  appendStringChar(c); break;
+            }
+            return;
+
+        case State::unicode:
+            unicodeValue = (unicodeValue << 4) | (juce::uint32) juce::CharacterFunctions::getHexDigitValue(c);
+            if (++unicodeDigits == 4)
+            {
+                state = State::string;
+                appendStringChar((juce::juce_wchar) unicodeValue);
+            }
+            return;
+
+        case State::number:
+            if (juce::CharacterFunctions::isDigit(c) || c == '.' || c == '-' || c == '+' || c == 'e' || c == 'E')
+            {
+                token += juce::String::charToString(c);
+                return;
+            }
+            // the character that ends a number is structural, so handle it below
+            finishNumber();
+            break;
+
+        case State::literal:
+            if (juce::CharacterFunctions::isLetter(c))
+                return;
+            state = State::value;
+            break;
+
+        case State::value:
+            break;
+    }
+
+    processStructural(c);
+}
+
+void StreamingResponseParser::processStructural (juce::juce_wchar c)
+{
+    if (juce::CharacterFunctions::isWhitespace(c) || stack.empty())
+        return;
+
+    switch (c)
+    {
+        case '{':
+            stack.push_back({});
+            return;
+
+        case '[':
+        {
+            Frame frame;
+            frame.isObject = false;
+            frame.expectingKey = false;
+            stack.push_back(frame);
+            return;
+        }
+
+        case '}':
+        case ']':
+            stack.pop_back();
+            if (stack.empty())
+                state = State::done;
+            return;
+
+        case ':':
+            stack.back().expectingKey = false;
+            return;
+
+        case ',':
+            if (stack.back().isObject)
+            {
+                stack.back().expectingKey = true;
+                stack.back().key.clear();
+            }
+            else
+            {
+                ++stack.back().index;
+            }
+            return;
+
+        case '"':
+            stringIsKey = stack.back().isObject && stack.back().expectingKey;
+            token.clear();
+            state = State::string;
+            return;
+
+        default:
+            if (juce::CharacterFunctions::isDigit(c) || c == '-')
+            {
+                token = juce::String::charToString(c);
+                state = State::number;
+            }
+            else if (juce::CharacterFunctions::isLetter(c))
+            {
+                state = State::literal;
+            }
+            return;
+    }
+}
+
+void StreamingResponseParser::appendStringChar (juce::juce_wchar c)
+{
+    if (isExplanationValue())
+        pendingExplanation += juce::String::charToString(c);
+    else
+        token += juce::String::charToString(c);
+}
+
+void StreamingResponseParser::finishString()
+{
+    state = State::value;
+    if (stringIsKey)
+        stack.back().key = token;
+    token.clear();
+}
+
+void StreamingResponseParser::finishNumber()
+{
+    state = State::value;
+    if (isInsideParameters())
+    {
+        int index = ReverbParameters::indexOf(stack.back().key);
+        if (index >= 0)
+        {
+            ++numParametersApplied;
+            if (onParameter != nullptr)
+                onParameter(index, token.getFloatValue());
+        }
+    }
+    token.clear();
+}
+
+size_t StreamingResponseParser::answerDepth() const
+{
+    if (stack.size() >= 3 && stack[0].key == "candidates" && ! stack[1].isObject && stack[1].index == 0)
+        return 2;
+    return 0;
+}
+
+bool StreamingResponseParser::isInsideParameters() const
+{
+    auto depth = answerDepth();
+    return stack.size() == depth + 2 && stack[depth].key == "parameters" && stack[depth + 1].isObject;
+}
+
+bool StreamingResponseParser::isExplanationValue() const
+{
+    auto depth = answerDepth();
+    return ! stringIsKey && stack.size() == depth + 1 && stack[depth].key == "explanation";
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <functional>
+#include <vector>
+
+// Incremental parser for the LLM's { "parameters": {...}, "explanation": "..." }
+// answer while it is still arriving token by token. Each numeric entry of
+// "parameters" is reported as soon as its value is complete, and the explanation
+// text is passed on as it comes in. In a { "candidates": [...] } answer the same
+// goes for the first candidate; the others are only read once the reply is whole.
+// Anything before the first '{' (e.g. a stray markdown fence) is ignored.
+class StreamingResponseParser
+{
+public:
+    StreamingResponseParser() = default;
+
+    std::function<void (int parameterIndex, float value)> onParameter;
+    std::function<void (const juce::String& text)> onExplanationText;
+
+    void feed (const juce::String& fragment);
+    void reset();
+
+    // Everything fed so far, for a full parse once the stream has finished.
+    const juce::String& getText() const noexcept        { return text; }
+    bool hasStreamedExplanation() const noexcept        { return explanationStreamed; }
+    int getNumParametersApplied() const noexcept        { return numParametersApplied; }
+
+private:
+    enum class State { beforeRoot, value, string, escape, unicode, number, literal, done };
+
+    struct Frame
+    {
+        bool isObject { true };
+        bool expectingKey { true };
+        juce::String key;
+        int index { 0 };   // of the current element, in an array
+    };
+
+    void process (juce::juce_wchar c);
+    void processStructural (juce::juce_wchar c);
+    void appendStringChar (juce::juce_wchar c);
+    void finishString();
+    void finishNumber();
+    bool isInsideParameters() const;
+    bool isExplanationValue() const;
+    // how deep the streamed answer object sits: the root, or the first candidate
+    size_t answerDepth() const;
+
+    State state { State::beforeRoot };
+    std::vector<Frame> stack;
+    juce::String text, token, pendingExplanation;
+    bool stringIsKey { false };
+    int unicodeDigits { 0 };
+    juce::uint32 unicodeValue { 0 };
+    bool explanationStreamed { false };
+    int numParametersApplied { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (StreamingResponseParser)
+};
@@ -0,0 +1,335 @@
+#include <JuceHeader.h>
+#include "LocalResolver.h"
+#include "PluginProcessor.h"
+#include "PresetBank.h"
+
+#include <atomic>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+// Batch renderer: prints the reverb onto every WAV/AIFF file in a folder. Files are
+// streamed through LLMEffectsAudioProcessor::processBlock a block at a time, never
+// loaded whole, and the reverb tail is rendered past the end of each one. Files are
+// shared out between worker threads, each with its own processor instance.
+
+namespace
+{
+    // indexed by LLMEffectsAudioProcessor::Engine
+    const juce::StringArray engineNames { "legacy", "fdn", "convolution" };
+
+    // Same layout in and out, picked by the file's channel count; other counts aren't
+    // supported by the plugin.
+    juce::AudioChannelSet getLayoutForChannels (int numChannels)
+    {
+        switch (numChannels)
+        {
+            case 1:  return juce::AudioChannelSet::mono();
+            case 2:  return juce::AudioChannelSet::stereo();
+            case 6:  return juce::AudioChannelSet::create5point1();
+            case 8:  return juce::AudioChannelSet::create7point1();
+            case 12: return juce::AudioChannelSet::create7point1point4();
+            default: return juce::AudioChannelSet::disabled();
+        }
+    }
+
+    struct Settings
+    {
+        ReverbParameters parameters;
+        int engine { LLMEffectsAudioProcessor::legacyEngine };
+        int blockSize { 512 };
+        double maxTailSeconds { 30.0 };
+        juce::File inputFolder, outputFolder;
+        juce::String suffix;
+    };
+
+    struct FileResult
+    {
+        juce::File input, output;
+        juce::String error;
+        double audioSeconds { 0.0 };
+        double renderSeconds { 0.0 };
+    };
+
+    // Parameters from a JSON file: either a bare parameter object, or an object with a
+    // "parameters" key, as the LLM answers and LLMEffectsFit writes.
+    bool loadParameterFile (const juce::File& file, ReverbParameters& parameters)
+    {
+        auto json = juce::JSON::parse(file);
+        auto object = json.hasProperty("parameters") ? json.getProperty("parameters", {}) : json;
+        if (! object.isObject())
+            return false;
+        parameters = ReverbParameters::fromVar(object, parameters);
+        return true;
+    }
+
+    // Streams one file through the processor into the output file.
+    FileResult renderFile (LLMEffectsAudioProcessor& processor, juce::AudioFormatManager& formats,
+                           const juce::File& input, const Settings& settings)
+    {
+        FileResult result;
+        result.input = input;
+        auto relative = input.getRelativePathFrom(settings.inputFolder);
+        result.output = settings.outputFolder.getChildFile(relative).getSiblingFile(input.getFileNameWithoutExtension() + settings.suffix + input.getFileExtension());
+
+        std::unique_ptr<juce::AudioFormatReader> reader (formats.createReaderFor(input));
+        if (reader == nullptr)
+        {
+            result.error = "not a readable audio file";
+            return result;
+        }
+
+        int numChannels = (int) reader->numChannels;
+        auto layout = getLayoutForChannels(numChannels);
+        if (layout.isDisabled())
+        {
+            result.error = juce::String(numChannels) + " channels isn't a supported layout";
+            return result;
+        }
+
+        juce::AudioProcessor::BusesLayout buses;
+        buses.inputBuses.add(layout);
+        buses.outputBuses.add(layout);
+        if (! processor.setBusesLayout(buses))
+        {
+            result.error = "the processor rejected the layout";
+            return result;
+        }
+
+        // the parameters go in before prepareToPlay, which sizes the delay memory for
+        // them; nothing runs the processor's timer here to grow it later
+        double sampleRate = reader->sampleRate;
+        processor.setNonRealtime(true);
+        processor.setEngine(settings.engine);
+        processor.applyParameters(settings.parameters);
+        processor.setRateAndBufferSizeDetails(sampleRate, settings.blockSize);
+        processor.prepareToPlay(sampleRate, settings.blockSize);
+
+        for (int waited = 0; ! processor.isEngineReady() && waited < 10000; waited += 10)
+            juce::Thread::sleep(10);
+
+        auto* format = formats.findFormatForFileExtension(input.getFileExtension());
+        int bitsPerSample = format->getPossibleBitDepths().contains((int) reader->bitsPerSample) ? (int) reader->bitsPerSample : 24;
+
+        result.output.getParentDirectory().createDirectory();
+        result.output.deleteFile();
+        auto stream = std::make_unique<juce::FileOutputStream>(result.output);
+        std::unique_ptr<juce::AudioFormatWriter> writer;
+        if (stream->openedOk())
+            writer.reset(format->createWriterFor(stream.get(), sampleRate, (unsigned int) numChannels, bitsPerSample, reader->metadataValues, 0));
+        if (writer == nullptr)
+        {
+            result.error = "couldn't write " + result.output.getFullPathName();
+            processor.releaseResources();
+            return result;
+        }
+        stream.release();
+
+        auto inputLength = reader->lengthInSamples;
+        auto tailLength = (juce::int64) (juce::jmin(settings.maxTailSeconds, processor.getTailLengthSeconds()) * sampleRate);
+        auto totalLength = inputLength + tailLength;
+
+        juce::AudioBuffer<float> block (numChannels, settings.blockSize);
+        juce::MidiBuffer midi;
+        auto start = juce::Time::getMillisecondCounterHiRes();
+
+        for (juce::int64 position = 0; position < totalLength; position += settings.blockSize)
+        {
+            int numSamples = (int) juce::jmin<juce::int64>(settings.blockSize, totalLength - position);
+            int numToRead = (int) juce::jlimit<juce::int64>(0, numSamples, inputLength - position);
+
+            // a view of the first numSamples, so the last block is short without reallocating
+            juce::AudioBuffer<float> chunk (block.getArrayOfWritePointers(), numChannels, numSamples);
+            chunk.clear();
+            if (numToRead > 0)
+                reader->read(&chunk, 0, numToRead, position, true, true);
+
+            processor.processBlock(chunk, midi);
+            writer->writeFromAudioSampleBuffer(chunk, 0, numSamples);
+        }
+
+        result.renderSeconds = (juce::Time::getMillisecondCounterHiRes() - start) / 1000.0;
+        result.audioSeconds = (double) totalLength / sampleRate;
+        processor.releaseResources();
+        return result;
+    }
+
+    // Takes the next file off the shared list until there are none left.
+    class RenderWorker  : public juce::Thread
+    {
+    public:
+        RenderWorker (const Settings& s, const juce::Array<juce::File>& f, std::vector<FileResult>& r, std::atomic<int>& next)
+            : juce::Thread ("LLMEffects render"), settings (s), files (f), results (r), nextFile (next)
+        {
+            formats.registerBasicFormats();
+        }
+
+        ~RenderWorker() override { stopThread(-1); }
+
+        void run() override
+        {
+            for (int index = nextFile++; index < files.size() && ! threadShouldExit(); index = nextFile++)
+                results[(size_t) index] = renderFile(processor, formats, files[index], settings);
+        }
+
+    private:
+        const Settings& settings;
+        const juce::Array<juce::File>& files;
+        std::vector<FileResult>& results;
+        std::atomic<int>& nextFile;
+
+        // made here, on the main thread, like a host would
+        LLMEffectsAudioProcessor processor;
+        juce::AudioFormatManager formats;
+    };
+
+    void printUsage()
+    {
+        std::cout << "LLMEffectsBatchRender --input=FOLDER --output=FOLDER [options]\n"
+                     "  --input=FOLDER           WAV/AIFF files to process\n"
+                     "  --output=FOLDER          where the rendered files go, same names and formats\n"
+                     "  --recursive              include subfolders (mirrored under --output)\n"
+                     "  --suffix=TEXT            added to each output file name, e.g. _verb\n"
+                     "  --preset=NAME            a preset from the plugin's preset bank\n"
+                     "  --parameters=FILE.json   parameters as JSON, bare or under \"parameters\"\n"
+                     "  --prompt=TEXT            describe the sound; resolved offline, no API key needed\n"
+                     "  --engine=NAME            legacy, fdn or convolution (default: the preset's, or legacy)\n"
+                     "  --block=N                block size (default 512)\n"
+                     "  --max-tail=SECONDS       longest tail rendered past the end of a file (default 30)\n"
+                     "  --threads=N              worker threads (default: one per core)\n";
+    }
+}
+
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInit;
+    juce::ArgumentList args (argc, argv);
+
+    if (args.containsOption("--help|-h") || ! args.containsOption("--input") || ! args.containsOption("--output"))
+    {
+        printUsage();
+        return args.containsOption("--help|-h") ? 0 : 1;
+    }
+
+    Settings settings;
+    settings.inputFolder = args.getFileForOption("--input");
+    settings.outputFolder = args.getFileForOption("--output");
+    settings.suffix = args.getValueForOption("--suffix");
+    settings.blockSize = args.containsOption("--block") ? args.getValueForOption("--block").getIntValue() : 512;
+    settings.maxTailSeconds = args.containsOption("--max-tail") ? args.getValueForOption("--max-tail").getDoubleValue() : 30.0;
+
+    if (settings.blockSize <= 0 || settings.maxTailSeconds < 0.0)
+    {
+        printUsage();
+        return 1;
+    }
+    if (! settings.inputFolder.isDirectory())
+    {
+        std::cerr << "No such folder: " << settings.inputFolder.getFullPathName() << "\n";
+        return 1;
+    }
+    if (settings.outputFolder == settings.inputFolder && settings.suffix.isEmpty())
+    {
+        std::cerr << "Writing into the input folder needs a --suffix\n";
+        return 1;
+    }
+
+    // parameters: a preset, a JSON file or a prompt, in that order; later ones refine
+    // earlier ones, so a prompt such as "darker" can adjust a preset
+    if (args.containsOption("--preset"))
+    {
+        PresetBank bank;
+        int index = bank.indexOf(args.getValueForOption("--preset"));
+        if (index < 0)
+        {
+            std::cerr << "No preset called " << args.getValueForOption("--preset") << "\n";
+            return 1;
+        }
+        auto preset = bank.getPreset(index);
+        settings.parameters = preset.parameters;
+        settings.engine = preset.engine;
+    }
+
+    if (args.containsOption("--parameters") && ! loadParameterFile(args.getFileForOption("--parameters"), settings.parameters))
+    {
+        std::cerr << "Could not read parameters from " << args.getValueForOption("--parameters") << "\n";
+        return 1;
+    }
+
+    if (args.containsOption("--prompt"))
+    {
+        LocalResolver resolver;
+        auto resolved = resolver.resolve(args.getValueForOption("--prompt"), settings.parameters);
+        if (! resolved.matched)
+        {
+            std::cerr << "Nothing in the offline presets matches that prompt\n";
+            return 1;
+        }
+        settings.parameters = resolved.parameters;
+        std::cout << resolved.explanation << "\n";
+    }
+
+    if (args.containsOption("--engine"))
+    {
+        settings.engine = engineNames.indexOf(args.getValueForOption("--engine"));
+        if (settings.engine < 0)
+        {
+            std::cerr << "Unknown engine: " << args.getValueForOption("--engine") << "\n";
+            return 1;
+        }
+    }
+
+    auto files = settings.inputFolder.findChildFiles(juce::File::findFiles, args.containsOption("--recursive"), "*.wav;*.aif;*.aiff");
+    files.sort();
+    if (files.isEmpty())
+    {
+        std::cerr << "No WAV or AIFF files in " << settings.inputFolder.getFullPathName() << "\n";
+        return 1;
+    }
+
+    int numThreads = args.containsOption("--threads") ? args.getValueForOption("--threads").getIntValue()
+                                                      : juce::SystemStats::getNumCpus();
+    numThreads = juce::jlimit(1, files.size(), numThreads);
+
+    std::cout << files.size() << " files, " << numThreads << " threads, engine " << engineNames[settings.engine] << "\n"
+              << juce::JSON::toString(settings.parameters.toVar(), true) << "\n";
+
+    std::vector<FileResult> results ((size_t) files.size());
+    std::atomic<int> nextFile { 0 };
+    std::vector<std::unique_ptr<RenderWorker>> workers;
+    for (int i = 0; i < numThreads; ++i)
+        workers.push_back(std::make_unique<RenderWorker>(settings, files, results, nextFile));
+
+    auto start = juce::Time::getMillisecondCounterHiRes();
+    for (auto& worker : workers)
+        worker->startThread();
+    for (auto& worker : workers)
+        worker->waitForThreadToExit(-1);
+    double wallSeconds = (juce::Time::getMillisecondCounterHiRes() - start) / 1000.0;
+
+    double audioSeconds = 0.0, busySeconds = 0.0;
+    int failed = 0;
+    for (auto& r : results)
+    {
+        if (r.error.isNotEmpty())
+        {
+            std::cerr << r.input.getFullPathName() << ": " << r.error << "\n";
+            ++failed;
+            continue;
+        }
+
+        audioSeconds += r.audioSeconds;
+        busySeconds += r.renderSeconds;
+        std::cout << r.output.getFileName().paddedRight(' ', 40) << " "
+                  << juce::String(r.audioSeconds, 1).paddedLeft(' ', 8) << " s "
+                  << juce::String(r.renderSeconds > 0.0 ? r.audioSeconds / r.renderSeconds : 0.0, 1).paddedLeft(' ', 8) << " x realtime\n";
+    }
+
+    // per core: audio rendered for each second a worker spent rendering
+    std::cout << (files.size() - failed) << " rendered, " << failed << " failed: "
+              << juce::String(audioSeconds, 1) << " s of audio in " << juce::String(wallSeconds, 1) << " s, "
+              << juce::String(wallSeconds > 0.0 ? audioSeconds / wallSeconds : 0.0, 1) << " x realtime overall, "
+              << juce::String(busySeconds > 0.0 ? audioSeconds / busySeconds : 0.0, 1) << " x realtime per core\n";
+
+    return failed > 0 ? 2 : 0;
+}
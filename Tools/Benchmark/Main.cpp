@@ -0,0 +1,618 @@
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+
+#include <algorithm>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <vector>
+
+// Headless benchmark / render harness for LLMEffectsAudioProcessor.
+// Runs prepareToPlay/processBlock over a matrix of sample rates, block sizes and
+// presets and reports ns/sample, realtime factor and per-block timing percentiles.
+
+namespace
+{
+    struct Preset
+    {
+        const char* name;
+        float decayTime, preDelay, size, diffusion, density, damping;
+        float eqLow, eqMid, eqHigh, spread, modulation, wetDryMix;
+    };
+
+    const Preset presets[] = {
+        { "default",   1.0f, 0.05f, 1.0f, 0.5f, 0.5f, 0.5f,  0.0f, 0.0f,  0.0f, 0.5f, 0.0f, 0.5f },
+        { "room",      0.4f, 0.01f, 0.5f, 0.3f, 0.4f, 0.7f, -2.0f, 1.0f,  2.0f, 0.3f, 0.0f, 0.3f },
+        { "hall",      4.5f, 0.08f, 2.0f, 0.8f, 0.9f, 0.3f,  2.0f, 0.0f, -3.0f, 0.8f, 0.5f, 0.6f },
+        { "modulated", 2.0f, 0.03f, 1.5f, 0.6f, 0.7f, 0.5f,  0.0f, 0.0f,  0.0f, 1.0f, 5.0f, 0.5f },
+    };
+
+    const double defaultRates[]  = { 44100.0, 48000.0, 88200.0, 96000.0, 176400.0, 192000.0 };
+    const int    defaultBlocks[] = { 16, 32, 64, 128, 256, 512, 1024, 2048, 4096 };
+
+    // the kernels do the same operations in the same order, but the compiler may fuse
+    // multiply-adds differently, and the feedback loop lets those last bits grow
+    const float simdTolerance = 1.0e-4f;
+
+    // indexed by LLMEffectsAudioProcessor::Engine
+    const juce::StringArray engineNames { "legacy", "fdn", "convolution" };
+    // indexed by LLMEffectsAudioProcessor::DelayStorage
+    const juce::StringArray storageNames { "float", "half", "int16" };
+    using DelayStorage = LLMEffectsAudioProcessor::DelayStorage;
+
+    // the bus layouts the plugin accepts; the same set goes in and out
+    const juce::StringArray layoutNames { "mono", "stereo", "5.1", "7.1", "7.1.4" };
+
+    juce::AudioChannelSet getLayout (int index)
+    {
+        switch (index)
+        {
+            case 0:  return juce::AudioChannelSet::mono();
+            case 2:  return juce::AudioChannelSet::create5point1();
+            case 3:  return juce::AudioChannelSet::create7point1();
+            case 4:  return juce::AudioChannelSet::create7point1point4();
+            default: return juce::AudioChannelSet::stereo();
+        }
+    }
+
+    // Channel layout and worker threads (-1 leaves it to the processor), shared by
+    // every case of a run.
+    struct ChannelSetup
+    {
+        int layout;
+        int workerThreads;
+
+        int getNumChannels() const { return getLayout(layout).size(); }
+    };
+
+    void applyPreset (LLMEffectsAudioProcessor& p, const Preset& preset)
+    {
+        p.setDecayTime  (preset.decayTime);
+        p.setPreDelay   (preset.preDelay);
+        p.setSize       (preset.size);
+        p.setDiffusion  (preset.diffusion);
+        p.setDensity    (preset.density);
+        p.setDamping    (preset.damping);
+        p.setEQLow      (preset.eqLow);
+        p.setEQMid      (preset.eqMid);
+        p.setEQHigh     (preset.eqHigh);
+        p.setSpread     (preset.spread);
+        p.setModulation (preset.modulation);
+        p.setWetDryMix  (preset.wetDryMix);
+    }
+
+    ReverbParameters toParameters (const Preset& preset)
+    {
+        ReverbParameters p;
+        p.decayTime  = preset.decayTime;
+        p.preDelay   = preset.preDelay;
+        p.size       = preset.size;
+        p.diffusion  = preset.diffusion;
+        p.density    = preset.density;
+        p.damping    = preset.damping;
+        p.eqLow      = preset.eqLow;
+        p.eqMid      = preset.eqMid;
+        p.eqHigh     = preset.eqHigh;
+        p.spread     = preset.spread;
+        p.modulation = preset.modulation;
+        p.wetDryMix  = preset.wetDryMix;
+        return p;
+    }
+
+    const Preset* findPreset (const juce::String& name)
+    {
+        for (auto& preset : presets)
+            if (name == preset.name)
+                return &preset;
+        return nullptr;
+    }
+
+    // Synthetic signals are deterministic so runs are comparable across commits.
+    // "bursts" alternates 0.5 s of noise with 0.5 s of silence so the tail gets exercised.
+    juce::AudioBuffer<float> makeSyntheticInput (const juce::String& signal, double sampleRate, int numChannels, int numSamples)
+    {
+        juce::AudioBuffer<float> input (numChannels, numSamples);
+        input.clear();
+
+        if (signal == "silence")
+            return input;
+
+        juce::Random random (307);
+        int period = static_cast<int>(sampleRate);
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            auto* data = input.getWritePointer(ch);
+            for (int i = 0; i < numSamples; ++i)
+            {
+                if (signal == "impulse")
+                    data[i] = (i % period == 0) ? 1.0f : 0.0f;
+                else if (signal == "bursts" && (i % period) >= period / 2)
+                    data[i] = 0.0f;
+                else
+                    data[i] = 0.25f * (random.nextFloat() * 2.0f - 1.0f);
+            }
+        }
+        return input;
+    }
+
+    // WAV input is looped/truncated to the requested length; it is not resampled.
+    bool loadInputFile (const juce::File& file, int numChannels, int numSamples, juce::AudioBuffer<float>& input)
+    {
+        juce::AudioFormatManager formatManager;
+        formatManager.registerBasicFormats();
+        std::unique_ptr<juce::AudioFormatReader> reader (formatManager.createReaderFor(file));
+        if (reader == nullptr || reader->lengthInSamples <= 0)
+            return false;
+
+        int fileLength = static_cast<int>(juce::jmin<juce::int64>(reader->lengthInSamples, numSamples));
+        juce::AudioBuffer<float> fileData (static_cast<int>(reader->numChannels), fileLength);
+        reader->read(&fileData, 0, fileLength, 0, true, true);
+
+        input.setSize(numChannels, numSamples);
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            int srcCh = ch % fileData.getNumChannels();
+            for (int pos = 0; pos < numSamples; pos += fileLength)
+                input.copyFrom(ch, pos, fileData, srcCh, 0, juce::jmin(fileLength, numSamples - pos));
+        }
+        return true;
+    }
+
+    struct CaseResult
+    {
+        double sampleRate;
+        int blockSize;
+        juce::String preset;
+        juce::String engine;
+        juce::String delayStorage;
+        juce::String layout;
+        int workers;
+        bool simd;
+        double nsPerSample, realtimeFactor;
+        double p50, p99, maxNs;
+        // compact delay storage against a float run of the same case
+        bool hasStorageComparison { false };
+        double floatNsPerSample { 0.0 };
+        double storageErrorDb { 0.0 };
+        float storageMaxDifference { 0.0f };
+    };
+
+    double percentile (const std::vector<double>& sorted, double q)
+    {
+        if (sorted.empty())
+            return 0.0;
+        auto index = static_cast<size_t>(std::ceil(q * (double) sorted.size())) - 1;
+        return sorted[juce::jlimit<size_t>(0, sorted.size() - 1, index)];
+    }
+
+    // recallAt, if given, is recalled halfway through, as a preset or LLM answer would be
+    CaseResult runCase (const Preset& preset, int engine, bool forceScalar, DelayStorage storage, const ChannelSetup& channels,
+                        double sampleRate, int blockSize, const juce::AudioBuffer<float>& input,
+                        juce::AudioBuffer<float>* renderOutput, const Preset* recallAt = nullptr)
+    {
+        LLMEffectsAudioProcessor processor;
+        processor.setForceScalarProcessing(forceScalar);
+        processor.setDelayStorage(storage);
+        processor.setNumWorkerThreads(channels.workerThreads);
+
+        juce::AudioProcessor::BusesLayout buses;
+        buses.inputBuses.add(getLayout(channels.layout));
+        buses.outputBuses.add(getLayout(channels.layout));
+        processor.setBusesLayout(buses);
+        // rendered output has to be complete, so let late convolution tail blocks hold
+        // up the audio thread rather than drop out
+        processor.setNonRealtime(renderOutput != nullptr);
+        auto* engineParameter = processor.getValueTreeState().getParameter(LLMEffectsAudioProcessor::engineParameterID);
+        engineParameter->setValueNotifyingHost(engineParameter->convertTo0to1((float) engine));
+        int numChannels = processor.getTotalNumOutputChannels();
+        processor.setRateAndBufferSizeDetails(sampleRate, blockSize);
+        processor.prepareToPlay(sampleRate, blockSize);
+        applyPreset(processor, preset);
+
+        juce::AudioBuffer<float> block (numChannels, blockSize);
+        juce::MidiBuffer midi;
+        int numSamples = input.getNumSamples();
+        int numBlocks = numSamples / blockSize;
+
+        auto fillBlock = [&](int blockIndex)
+        {
+            for (int ch = 0; ch < numChannels; ++ch)
+                block.copyFrom(ch, 0, input, ch % input.getNumChannels(), blockIndex * blockSize, blockSize);
+        };
+
+        // warm up caches and branch predictors, then start from a clean state
+        for (int b = 0; b < juce::jmin(numBlocks, 32); ++b)
+        {
+            fillBlock(b);
+            processor.processBlock(block, midi);
+        }
+        processor.prepareToPlay(sampleRate, blockSize);
+
+        // the convolution engine builds its IR in the background; time the steady
+        // state, not the seconds of dry output before the first IR arrives
+        for (int waited = 0; ! processor.isEngineReady() && waited < 10000; waited += 10)
+            juce::Thread::sleep(10);
+
+        std::vector<double> blockNs;
+        blockNs.reserve(static_cast<size_t>(numBlocks));
+        double ticksToNs = 1.0e9 / (double) juce::Time::getHighResolutionTicksPerSecond();
+        double totalNs = 0.0;
+
+        for (int b = 0; b < numBlocks; ++b)
+        {
+            if (recallAt != nullptr && b == numBlocks / 2)
+                processor.recallPreset(toParameters(*recallAt), engine);
+            fillBlock(b);
+
+            auto start = juce::Time::getHighResolutionTicks();
+            processor.processBlock(block, midi);
+            auto end = juce::Time::getHighResolutionTicks();
+
+            double ns = (double) (end - start) * ticksToNs;
+            blockNs.push_back(ns);
+            totalNs += ns;
+
+            // A bigger delay line comes from the processor's timer, and there is no message
+            // loop here to run it. Give it its turn, untimed, for a few blocks after the
+            // recall: one to allocate the line the audio thread asked for, which the next
+            // block swaps in, and one to free the old line.
+            if (recallAt != nullptr && b >= numBlocks / 2 && b < numBlocks / 2 + 3)
+            {
+                juce::Thread::sleep(60);
+                juce::Timer::callPendingTimersSynchronously();
+            }
+
+            if (renderOutput != nullptr)
+                for (int ch = 0; ch < numChannels; ++ch)
+                    renderOutput->copyFrom(ch, b * blockSize, block, ch, 0, blockSize);
+        }
+
+        int workers = processor.getNumActiveWorkers();
+        processor.releaseResources();
+
+        std::sort(blockNs.begin(), blockNs.end());
+        double renderedSamples = (double) numBlocks * blockSize;
+        double audioNs = renderedSamples / sampleRate * 1.0e9;
+
+        CaseResult result;
+        result.sampleRate = sampleRate;
+        result.blockSize = blockSize;
+        result.preset = preset.name;
+        result.engine = engineNames[engine];
+        result.delayStorage = storageNames[(int) storage];
+        result.layout = layoutNames[channels.layout];
+        result.workers = workers;
+        result.simd = processor.isUsingSIMD();
+        result.nsPerSample = renderedSamples > 0.0 ? totalNs / renderedSamples : 0.0;
+        result.realtimeFactor = totalNs > 0.0 ? audioNs / totalNs : 0.0;
+        result.p50 = percentile(blockNs, 0.50);
+        result.p99 = percentile(blockNs, 0.99);
+        result.maxNs = blockNs.empty() ? 0.0 : blockNs.back();
+        return result;
+    }
+
+    template <typename T>
+    std::vector<T> parseList (const juce::String& text)
+    {
+        std::vector<T> values;
+        for (auto& token : juce::StringArray::fromTokens(text, ",", {}))
+            if (token.trim().isNotEmpty())
+                values.push_back(static_cast<T>(token.trim().getDoubleValue()));
+        return values;
+    }
+
+    juce::var resultToVar (const CaseResult& r)
+    {
+        juce::DynamicObject::Ptr obj = new juce::DynamicObject();
+        obj->setProperty("sampleRate",     r.sampleRate);
+        obj->setProperty("blockSize",      r.blockSize);
+        obj->setProperty("preset",         r.preset);
+        obj->setProperty("engine",         r.engine);
+        obj->setProperty("simd",           r.simd);
+        obj->setProperty("delayStorage",   r.delayStorage);
+        obj->setProperty("layout",         r.layout);
+        obj->setProperty("workers",        r.workers);
+        obj->setProperty("nsPerSample",    r.nsPerSample);
+        obj->setProperty("realtimeFactor", r.realtimeFactor);
+        obj->setProperty("blockNsP50",     r.p50);
+        obj->setProperty("blockNsP99",     r.p99);
+        obj->setProperty("blockNsMax",     r.maxNs);
+        if (r.hasStorageComparison)
+        {
+            obj->setProperty("floatNsPerSample",     r.floatNsPerSample);
+            obj->setProperty("storageErrorDb",       r.storageErrorDb);
+            obj->setProperty("storageMaxDifference", r.storageMaxDifference);
+        }
+        return juce::var(obj.get());
+    }
+
+    // Renders the case through the SIMD kernel and the scalar reference and returns the
+    // largest sample difference between the two.
+    float compareWithScalar (const Preset& preset, int engine, DelayStorage storage, const ChannelSetup& channels,
+                             double sampleRate, int blockSize, const juce::AudioBuffer<float>& input)
+    {
+        int length = (input.getNumSamples() / blockSize) * blockSize;
+        int numChannels = channels.getNumChannels();
+        juce::AudioBuffer<float> vectorOutput (numChannels, length), scalarOutput (numChannels, length);
+        runCase(preset, engine, false, storage, channels, sampleRate, blockSize, input, &vectorOutput);
+        runCase(preset, engine, true, storage, channels, sampleRate, blockSize, input, &scalarOutput);
+
+        float maxDifference = 0.0f;
+        for (int ch = 0; ch < numChannels; ++ch)
+            for (int i = 0; i < length; ++i)
+                maxDifference = juce::jmax(maxDifference, std::abs(vectorOutput.getSample(ch, i) - scalarOutput.getSample(ch, i)));
+        return maxDifference;
+    }
+
+    // Renders the case again with float delay storage and records its speed, plus the
+    // error of the compact output relative to it (RMS error over RMS signal, in dB).
+    void compareWithFloatStorage (CaseResult& result, const Preset& preset, int engine, bool forceScalar, const ChannelSetup& channels,
+                                  double sampleRate, int blockSize, const juce::AudioBuffer<float>& input)
+    {
+        int length = (input.getNumSamples() / blockSize) * blockSize;
+        int numChannels = channels.getNumChannels();
+        juce::AudioBuffer<float> compactOutput (numChannels, length), floatOutput (numChannels, length);
+        runCase(preset, engine, forceScalar, static_cast<DelayStorage>(storageNames.indexOf(result.delayStorage)),
+                channels, sampleRate, blockSize, input, &compactOutput);
+        auto reference = runCase(preset, engine, forceScalar, DelayStorage::native, channels, sampleRate, blockSize, input, &floatOutput);
+
+        double errorEnergy = 0.0, signalEnergy = 0.0;
+        float maxDifference = 0.0f;
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            for (int i = 0; i < length; ++i)
+            {
+                float difference = compactOutput.getSample(ch, i) - floatOutput.getSample(ch, i);
+                errorEnergy += (double) difference * difference;
+                signalEnergy += (double) floatOutput.getSample(ch, i) * floatOutput.getSample(ch, i);
+                maxDifference = juce::jmax(maxDifference, std::abs(difference));
+            }
+        }
+
+        result.hasStorageComparison = true;
+        result.floatNsPerSample = reference.nsPerSample;
+        result.storageErrorDb = 10.0 * std::log10(juce::jmax(1.0e-30, errorEnergy) / juce::jmax(1.0e-30, signalEnergy));
+        result.storageMaxDifference = maxDifference;
+    }
+
+    // Prints what the audio thread did that it shouldn't have since the last call, one
+    // entry per distinct call site, and returns whether there was anything.
+    bool reportRealtimeViolations()
+    {
+        std::map<juce::String, int> sites;
+        for (auto& violation : RealtimeSafety::takeViolations())
+            ++sites[RealtimeSafety::describe(violation)];
+
+        for (auto& site : sites)
+            std::cout << "  REALTIME VIOLATION (x" << site.second << ") " << site.first;
+        if (RealtimeSafety::getNumDropped() > 0)
+            std::cout << "  (" << RealtimeSafety::getNumDropped() << " more not recorded)\n";
+        return ! sites.empty();
+    }
+
+    void printUsage()
+    {
+        std::cout << "LLMEffectsBenchmark [options]\n"
+                     "  --input=file.wav         use a WAV/AIFF file instead of a synthetic signal\n"
+                     "  --signal=bursts|noise|impulse|silence   synthetic signal (default bursts)\n"
+                     "  --seconds=N              seconds of audio per case (default 5)\n"
+                     "  --rates=44100,48000,...  sample rates to test\n"
+                     "  --blocks=16,64,...       block sizes to test\n"
+                     "  --presets=default,hall   presets to test (default, room, hall, modulated)\n"
+                     "  --engine=NAME            legacy, fdn or convolution (default legacy)\n"
+                     "  --layout=NAME            mono, stereo, 5.1, 7.1 or 7.1.4 (default stereo)\n"
+                     "  --workers=N              worker threads for the channel groups; 0 for none\n"
+                     "                           (default: decided by the layout)\n"
+                     "  --scalar                 force the scalar reference path instead of SIMD\n"
+                     "  --verify-simd            check SIMD output against the scalar reference\n"
+                     "  --check-realtime         report allocations, locks, I/O and sleeps inside processBlock\n"
+                     "                           (needs a build with LLMEFFECTS_REALTIME_CHECKS=1)\n"
+                     "  --delay-storage=float|half|int16   legacy delay line storage (default float);\n"
+                     "                           compact modes are also run in float for comparison\n"
+                     "  --label=TEXT             tag stored in the JSON output (e.g. a commit hash)\n"
+                     "  --json=out.json          write machine-readable results\n"
+                     "  --render=out.wav         render the first case to a 24-bit WAV file\n";
+    }
+}
+
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInit;
+    juce::ArgumentList args (argc, argv);
+
+    if (args.containsOption("--help|-h"))
+    {
+        printUsage();
+        return 0;
+    }
+
+    auto rates  = args.containsOption("--rates")  ? parseList<double>(args.getValueForOption("--rates"))
+                                                  : std::vector<double>(std::begin(defaultRates), std::end(defaultRates));
+    auto blocks = args.containsOption("--blocks") ? parseList<int>(args.getValueForOption("--blocks"))
+                                                  : std::vector<int>(std::begin(defaultBlocks), std::end(defaultBlocks));
+
+    std::vector<const Preset*> selectedPresets;
+    if (args.containsOption("--presets"))
+    {
+        for (auto& name : juce::StringArray::fromTokens(args.getValueForOption("--presets"), ",", {}))
+        {
+            if (auto* preset = findPreset(name.trim()))
+                selectedPresets.push_back(preset);
+            else
+                std::cerr << "Unknown preset: " << name << "\n";
+        }
+    }
+    else
+    {
+        for (auto& preset : presets)
+            selectedPresets.push_back(&preset);
+    }
+
+    juce::String engineName = args.containsOption("--engine") ? args.getValueForOption("--engine") : juce::String("legacy");
+    int engine = engineNames.indexOf(engineName);
+    if (engine < 0)
+    {
+        std::cerr << "Unknown engine: " << engineName << "\n";
+        return 1;
+    }
+
+    juce::String storageName = args.containsOption("--delay-storage") ? args.getValueForOption("--delay-storage") : juce::String("float");
+    int storageIndex = storageNames.indexOf(storageName);
+    if (storageIndex < 0)
+    {
+        std::cerr << "Unknown delay storage: " << storageName << "\n";
+        return 1;
+    }
+    auto storage = static_cast<DelayStorage>(storageIndex);
+
+    juce::String layoutName = args.containsOption("--layout") ? args.getValueForOption("--layout") : juce::String("stereo");
+    ChannelSetup channels { layoutNames.indexOf(layoutName),
+                            args.containsOption("--workers") ? args.getValueForOption("--workers").getIntValue() : -1 };
+    if (channels.layout < 0)
+    {
+        std::cerr << "Unknown layout: " << layoutName << "\n";
+        return 1;
+    }
+    int numChannels = channels.getNumChannels();
+
+    bool forceScalar = args.containsOption("--scalar");
+    bool verifySIMD = args.containsOption("--verify-simd");
+    bool checkRealtime = args.containsOption("--check-realtime");
+
+   #if LLMEFFECTS_REALTIME_CHECKS
+    RealtimeSafety::setEnabled(checkRealtime);
+   #else
+    if (checkRealtime)
+    {
+        std::cerr << "--check-realtime needs a build with LLMEFFECTS_REALTIME_CHECKS=1\n";
+        return 1;
+    }
+   #endif
+
+    double seconds = args.containsOption("--seconds") ? args.getValueForOption("--seconds").getDoubleValue() : 5.0;
+    juce::String signal = args.containsOption("--signal") ? args.getValueForOption("--signal") : juce::String("bursts");
+    juce::File inputFile = args.containsOption("--input") ? args.getFileForOption("--input") : juce::File();
+    juce::File renderFile = args.containsOption("--render") ? args.getFileForOption("--render") : juce::File();
+
+    if (rates.empty() || blocks.empty() || selectedPresets.empty() || seconds <= 0.0)
+    {
+        printUsage();
+        return 1;
+    }
+
+    juce::Array<juce::var> results;
+    bool rendered = false;
+    bool simdMismatch = false;
+    bool realtimeViolation = false;
+
+    std::cout << "layout " << layoutName << ", " << numChannels << " channels\n";
+    std::cout << "preset      rate    block   ns/sample   x realtime   p50 us   p99 us   max us\n";
+
+    for (auto* preset : selectedPresets)
+    {
+        for (auto sampleRate : rates)
+        {
+            int numSamples = static_cast<int>(seconds * sampleRate);
+            juce::AudioBuffer<float> input;
+            if (inputFile != juce::File())
+            {
+                if (! loadInputFile(inputFile, 2, numSamples, input))
+                {
+                    std::cerr << "Could not read " << inputFile.getFullPathName() << "\n";
+                    return 1;
+                }
+            }
+            else
+            {
+                input = makeSyntheticInput(signal, sampleRate, 2, numSamples);
+            }
+
+            for (auto blockSize : blocks)
+            {
+                if (blockSize <= 0)
+                    continue;
+
+                std::unique_ptr<juce::AudioBuffer<float>> renderOutput;
+                if (renderFile != juce::File() && ! rendered)
+                    renderOutput = std::make_unique<juce::AudioBuffer<float>>(numChannels, (numSamples / blockSize) * blockSize);
+
+                // checked runs also recall the next preset halfway, so the parameter change
+                // paths (delay growth, crossfades, IR rebuilds) are covered too
+                const Preset* recallAt = checkRealtime ? &presets[((preset - presets) + 1) % (int) std::size(presets)] : nullptr;
+                auto r = runCase(*preset, engine, forceScalar, storage, channels, sampleRate, blockSize, input, renderOutput.get(), recallAt);
+                if (storage != DelayStorage::native)
+                    compareWithFloatStorage(r, *preset, engine, forceScalar, channels, sampleRate, blockSize, input);
+                results.add(resultToVar(r));
+
+                std::cout << juce::String(r.preset).paddedRight(' ', 10) << " "
+                          << juce::String(r.sampleRate, 0).paddedLeft(' ', 6) << " "
+                          << juce::String(r.blockSize).paddedLeft(' ', 8) << " "
+                          << juce::String(r.nsPerSample, 2).paddedLeft(' ', 11) << " "
+                          << juce::String(r.realtimeFactor, 1).paddedLeft(' ', 12) << " "
+                          << juce::String(r.p50 / 1000.0, 2).paddedLeft(' ', 8) << " "
+                          << juce::String(r.p99 / 1000.0, 2).paddedLeft(' ', 8) << " "
+                          << juce::String(r.maxNs / 1000.0, 2).paddedLeft(' ', 8) << "\n";
+
+                if (r.hasStorageComparison)
+                {
+                    std::cout << "  " << storageName << " vs float: " << juce::String(r.floatNsPerSample, 2) << " ns/sample in float, error "
+                              << juce::String(r.storageErrorDb, 1) << " dB, max difference " << r.storageMaxDifference << "\n";
+                }
+
+                if (verifySIMD)
+                {
+                    auto difference = compareWithScalar(*preset, engine, storage, channels, sampleRate, blockSize, input);
+                    bool matches = difference <= simdTolerance;
+                    std::cout << "  simd vs scalar: max difference " << difference << (matches ? " ok\n" : " MISMATCH\n");
+                    simdMismatch = simdMismatch || ! matches;
+                }
+
+                if (checkRealtime)
+                    realtimeViolation = reportRealtimeViolations() || realtimeViolation;
+
+                if (renderOutput != nullptr)
+                {
+                    renderFile.deleteFile();
+                    juce::WavAudioFormat wav;
+                    auto stream = std::make_unique<juce::FileOutputStream>(renderFile);
+                    std::unique_ptr<juce::AudioFormatWriter> writer (wav.createWriterFor(stream.get(), sampleRate, (unsigned int) numChannels, 24, {}, 0));
+                    if (writer != nullptr)
+                    {
+                        stream.release();
+                        writer->writeFromAudioSampleBuffer(*renderOutput, 0, renderOutput->getNumSamples());
+                    }
+                    rendered = true;
+                }
+            }
+        }
+    }
+
+    if (args.containsOption("--json"))
+    {
+        juce::DynamicObject::Ptr root = new juce::DynamicObject();
+        root->setProperty("schemaVersion", 1);
+        root->setProperty("label",     args.containsOption("--label") ? args.getValueForOption("--label") : juce::String());
+        root->setProperty("timestamp", juce::Time::getCurrentTime().toISO8601(true));
+        root->setProperty("cpu",       juce::SystemStats::getCpuModel());
+        root->setProperty("signal",    inputFile != juce::File() ? inputFile.getFileName() : signal);
+        root->setProperty("seconds",   seconds);
+       #if JUCE_DEBUG
+        root->setProperty("build",     "debug");
+       #else
+        root->setProperty("build",     "release");
+       #endif
+        root->setProperty("results",   results);
+
+        auto jsonFile = args.getFileForOption("--json");
+        if (! jsonFile.replaceWithText(juce::JSON::toString(juce::var(root.get()))))
+        {
+            std::cerr << "Could not write " << jsonFile.getFullPathName() << "\n";
+            return 1;
+        }
+    }
+
+    if (realtimeViolation)
+        return 3;
+    return simdMismatch ? 2 : 0;
+}
@@ -0,0 +1,276 @@
+// Interposes the calls the audio callback must not make and reports them to
+// RealtimeSafety. Only built into the benchmark, with LLMEFFECTS_REALTIME_CHECKS=1;
+// never into the plugin, which shouldn't replace the host's allocator.
+//
+// On glibc the malloc family, pthread mutexes, file and socket calls and sleeps are
+// hooked by defining them here, ahead of libc in symbol lookup. Elsewhere only
+// operator new/delete can be replaced portably, so only C++ allocations are caught.
+
+// glibc's fortified inline wrappers for open() and read() would clash with the hooks
+#ifdef _FORTIFY_SOURCE
+ #undef _FORTIFY_SOURCE
+#endif
+
+#include <JuceHeader.h>
+#include "RealtimeSafety.h"
+
+#if LLMEFFECTS_REALTIME_CHECKS
+
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <new>
+
+#if defined (__GLIBC__)
+
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+extern "C"
+{
+    void* __libc_malloc (size_t);
+    void* __libc_calloc (size_t, size_t);
+    void* __libc_realloc (void*, size_t);
+    void* __libc_memalign (size_t, size_t);
+    void  __libc_free (void*);
+}
+
+namespace
+{
+    using Kind = RealtimeSafety::Kind;
+
+    // The real function, looked up on first use. Plain atomics rather than function
+    // statics, whose guard could take the very mutex being hooked.
+    template <typename Function>
+    Function next (std::atomic<void*>& slot, const char* name) noexcept
+    {
+        auto* function = slot.load(std::memory_order_acquire);
+        if (function == nullptr)
+        {
+            function = dlsym(RTLD_NEXT, name);
+            slot.store(function, std::memory_order_release);
+        }
+        return reinterpret_cast<Function>(function);
+    }
+
+    #define LLMEFFECTS_NEXT(name) next<decltype (&name)>(name##Slot, #name)
+
+    std::atomic<void*> pthread_mutex_lockSlot { nullptr }, pthread_mutex_trylockSlot { nullptr },
+                       openSlot { nullptr }, openatSlot { nullptr }, fopenSlot { nullptr },
+                       readSlot { nullptr }, writeSlot { nullptr },
+                       connectSlot { nullptr }, sendSlot { nullptr }, sendtoSlot { nullptr },
+                       recvSlot { nullptr }, recvfromSlot { nullptr },
+                       nanosleepSlot { nullptr }, usleepSlot { nullptr };
+}
+
+extern "C"
+{
+    void* malloc (size_t size)
+    {
+        RealtimeSafety::check(Kind::allocation, "malloc");
+        return __libc_malloc(size);
+    }
+
+    void* calloc (size_t count, size_t size)
+    {
+        RealtimeSafety::check(Kind::allocation, "calloc");
+        return __libc_calloc(count, size);
+    }
+
+    void* realloc (void* pointer, size_t size)
+    {
+        RealtimeSafety::check(Kind::allocation, "realloc");
+        return __libc_realloc(pointer, size);
+    }
+
+    void* memalign (size_t alignment, size_t size)
+    {
+        RealtimeSafety::check(Kind::allocation, "memalign");
+        return __libc_memalign(alignment, size);
+    }
+
+    void* aligned_alloc (size_t alignment, size_t size)
+    {
+        RealtimeSafety::check(Kind::allocation, "aligned_alloc");
+        return __libc_memalign(alignment, size);
+    }
+
+    int posix_memalign (void** result, size_t alignment, size_t size)
+    {
+        RealtimeSafety::check(Kind::allocation, "posix_memalign");
+        *result = __libc_memalign(alignment, size);
+        return *result != nullptr || size == 0 ? 0 : ENOMEM;
+    }
+
+    void free (void* pointer)
+    {
+        if (pointer != nullptr)
+            RealtimeSafety::check(Kind::deallocation, "free");
+        __libc_free(pointer);
+    }
+
+    int pthread_mutex_lock (pthread_mutex_t* mutex)
+    {
+        RealtimeSafety::check(Kind::lock, "pthread_mutex_lock");
+        return LLMEFFECTS_NEXT(pthread_mutex_lock)(mutex);
+    }
+
+    int pthread_mutex_trylock (pthread_mutex_t* mutex)
+    {
+        RealtimeSafety::check(Kind::lock, "pthread_mutex_trylock");
+        return LLMEFFECTS_NEXT(pthread_mutex_trylock)(mutex);
+    }
+
+    int open (const char* path, int flags, ...)
+    {
+        RealtimeSafety::check(Kind::fileAccess, "open");
+        mode_t mode = 0;
+        if ((flags & O_CREAT) != 0)
+        {
+            va_list args;
+            va_start(args, flags);
+            mode = (mode_t) va_arg(args, int);
+            va_end(args);
+        }
+        return LLMEFFECTS_NEXT(open)(path, flags, mode);
+    }
+
+    int openat (int directory, const char* path, int flags, ...)
+    {
+        RealtimeSafety::check(Kind::fileAccess, "openat");
+        mode_t mode = 0;
+        if ((flags & O_CREAT) != 0)
+        {
+            va_list args;
+            va_start(args, flags);
+            mode = (mode_t) va_arg(args, int);
+            va_end(args);
+        }
+        return LLMEFFECTS_NEXT(openat)(directory, path, flags, mode);
+    }
+
+    FILE* fopen (const char* path, const char* mode)
+    {
+        RealtimeSafety::check(Kind::fileAccess, "fopen");
+        return LLMEFFECTS_NEXT(fopen)(path, mode);
+    }
+
+    ssize_t read (int fd, void* buffer, size_t size)
+    {
+        RealtimeSafety::check(Kind::fileAccess, "read");
+        return LLMEFFECTS_NEXT(read)(fd, buffer, size);
+    }
+
+    ssize_t write (int fd, const void* buffer, size_t size)
+    {
+        RealtimeSafety::check(Kind::fileAccess, "write");
+        return LLMEFFECTS_NEXT(write)(fd, buffer, size);
+    }
+
+    int connect (int socket, const struct sockaddr* address, socklen_t length)
+    {
+        RealtimeSafety::check(Kind::network, "connect");
+        return LLMEFFECTS_NEXT(connect)(socket, address, length);
+    }
+
+    ssize_t send (int socket, const void* buffer, size_t size, int flags)
+    {
+        RealtimeSafety::check(Kind::network, "send");
+        return LLMEFFECTS_NEXT(send)(socket, buffer, size, flags);
+    }
+
+    ssize_t sendto (int socket, const void* buffer, size_t size, int flags, const struct sockaddr* address, socklen_t length)
+    {
+        RealtimeSafety::check(Kind::network, "sendto");
+        return LLMEFFECTS_NEXT(sendto)(socket, buffer, size, flags, address, length);
+    }
+
+    ssize_t recv (int socket, void* buffer, size_t size, int flags)
+    {
+        RealtimeSafety::check(Kind::network, "recv");
+        return LLMEFFECTS_NEXT(recv)(socket, buffer, size, flags);
+    }
+
+    ssize_t recvfrom (int socket, void* buffer, size_t size, int flags, struct sockaddr* address, socklen_t* length)
+    {
+        RealtimeSafety::check(Kind::network, "recvfrom");
+        return LLMEFFECTS_NEXT(recvfrom)(socket, buffer, size, flags, address, length);
+    }
+
+    int nanosleep (const struct timespec* duration, struct timespec* remaining)
+    {
+        RealtimeSafety::check(Kind::sleep, "nanosleep");
+        return LLMEFFECTS_NEXT(nanosleep)(duration, remaining);
+    }
+
+    int usleep (useconds_t microseconds)
+    {
+        RealtimeSafety::check(Kind::sleep, "usleep");
+        return LLMEFFECTS_NEXT(usleep)(microseconds);
+    }
+}
+
+#else
+
+// operator new/delete are the only portable hooks. The rest of the replaceable set
+// (nothrow, array and sized forms) forwards to these in the standard library.
+namespace
+{
+    void* allocate (std::size_t size, std::size_t alignment, const char* function)
+    {
+        RealtimeSafety::check(RealtimeSafety::Kind::allocation, function);
+        size = size == 0 ? 1 : size;
+       #if JUCE_WINDOWS
+        void* pointer = alignment > 0 ? _aligned_malloc(size, alignment) : std::malloc(size);
+       #else
+        void* pointer = nullptr;
+        if (alignment > 0)
+        {
+            if (posix_memalign(&pointer, juce::jmax(alignment, sizeof (void*)), size) != 0)
+                pointer = nullptr;
+        }
+        else
+        {
+            pointer = std::malloc(size);
+        }
+       #endif
+        if (pointer == nullptr)
+            throw std::bad_alloc();
+        return pointer;
+    }
+
+    void deallocate (void* pointer, bool aligned, const char* function) noexcept
+    {
+        if (pointer == nullptr)
+            return;
+        RealtimeSafety::check(RealtimeSafety::Kind::deallocation, function);
+       #if JUCE_WINDOWS
+        if (aligned)
+        {
+            _aligned_free(pointer);
+            return;
+        }
+       #endif
+        juce::ignoreUnused(aligned);
+        std::free(pointer);
+    }
+}
+
+void* operator new (std::size_t size)                              { return allocate(size, 0, "operator new"); }
+void* operator new[] (std::size_t size)                            { return allocate(size, 0, "operator new[]"); }
+void* operator new (std::size_t size, std::align_val_t alignment)   { return allocate(size, (std::size_t) alignment, "operator new"); }
+void* operator new[] (std::size_t size, std::align_val_t alignment) { return allocate(size, (std::size_t) alignment, "operator new[]"); }
+
+void operator delete (void* pointer) noexcept                              { deallocate(pointer, false, "operator delete"); }
+void operator delete[] (void* pointer) noexcept                            { deallocate(pointer, false, "operator delete[]"); }
+void operator delete (void* pointer, std::align_val_t) noexcept            { deallocate(pointer, true, "operator delete"); }
+void operator delete[] (void* pointer, std::align_val_t) noexcept          { deallocate(pointer, true, "operator delete[]"); }
+
+#endif
+#endif
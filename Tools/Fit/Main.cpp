@@ -0,0 +1,421 @@
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <vector>
+
+// Fits LLMEffectsAudioProcessor's parameters to a reference impulse response. Each
+// generation renders a population of candidates in parallel (one processor per worker
+// thread), first as short probes that only cover the start of the IR, then in full for
+// the few whose probes came closest. The survivors seed the next generation. The best
+// set is written as the { "parameters", "explanation" } object the LLM answers with.
+
+namespace
+{
+    // indexed by LLMEffectsAudioProcessor::Engine
+    const juce::StringArray engineNames { "legacy", "fdn", "convolution" };
+
+    const int blockSize = 512;
+    const double frameSeconds = 0.01;
+    // envelope frames and decay points this far below the reference's peak don't count
+    const float floorDb = -80.0f;
+    const float decayRangeDb = -60.0f;
+    const float bandCentres[] = { 63.0f, 125.0f, 250.0f, 500.0f, 1000.0f, 2000.0f, 4000.0f, 8000.0f, 16000.0f };
+
+    float toDb (double energy)
+    {
+        return (float) (10.0 * std::log10(juce::jmax(1.0e-20, energy)));
+    }
+
+    // Level-independent features of the first numSamples of an impulse response: its
+    // energy envelope in 10 ms frames and its octave-band spectrum, both relative to
+    // their own peak, and optionally its Schroeder decay curve.
+    struct Analysis
+    {
+        std::vector<float> envelope;
+        std::vector<float> bands;
+        std::vector<float> decay;
+    };
+
+    Analysis analyse (const juce::AudioBuffer<float>& ir, int numSamples, double sampleRate, bool withDecay)
+    {
+        Analysis analysis;
+        int numChannels = ir.getNumChannels();
+        int frameLength = juce::jmax(1, (int) (frameSeconds * sampleRate));
+
+        std::vector<double> energy ((size_t) numSamples, 0.0);
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            auto* data = ir.getReadPointer(ch);
+            for (int i = 0; i < numSamples; ++i)
+                energy[(size_t) i] += (double) data[i] * data[i];
+        }
+
+        for (int start = 0; start + frameLength <= numSamples; start += frameLength)
+        {
+            double sum = 0.0;
+            for (int i = start; i < start + frameLength; ++i)
+                sum += energy[(size_t) i];
+            analysis.envelope.push_back(toDb(sum));
+        }
+
+        int order = juce::jlimit(8, 20, (int) std::ceil(std::log2((double) juce::jmax(2, numSamples))));
+        juce::dsp::FFT fft (order);
+        std::vector<float> spectrum ((size_t) (2 << order), 0.0f);
+        std::vector<double> bandEnergy (std::size(bandCentres), 0.0);
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            std::fill(spectrum.begin(), spectrum.end(), 0.0f);
+            std::copy(ir.getReadPointer(ch), ir.getReadPointer(ch) + juce::jmin(numSamples, fft.getSize()), spectrum.begin());
+            fft.performFrequencyOnlyForwardTransform(spectrum.data(), true);
+
+            for (int bin = 1; bin < fft.getSize() / 2; ++bin)
+            {
+                double hz = bin * sampleRate / fft.getSize();
+                for (size_t b = 0; b < std::size(bandCentres); ++b)
+                    if (hz >= bandCentres[b] / std::sqrt(2.0) && hz < bandCentres[b] * std::sqrt(2.0))
+                        bandEnergy[b] += (double) spectrum[(size_t) bin] * spectrum[(size_t) bin];
+            }
+        }
+        for (size_t b = 0; b < std::size(bandCentres); ++b)
+            if (bandCentres[b] * std::sqrt(2.0) < sampleRate / 2.0)
+                analysis.bands.push_back(toDb(bandEnergy[b]));
+
+        auto normalise = [] (std::vector<float>& values)
+        {
+            if (values.empty())
+                return;
+            float peak = *std::max_element(values.begin(), values.end());
+            for (auto& v : values)
+                v -= peak;
+        };
+        normalise(analysis.envelope);
+        normalise(analysis.bands);
+
+        // backward-integrated energy, sampled once a frame, 0 dB at the start
+        if (withDecay)
+        {
+            double remaining = 0.0;
+            std::vector<double> curve ((size_t) numSamples);
+            for (int i = numSamples - 1; i >= 0; --i)
+                curve[(size_t) i] = (remaining += energy[(size_t) i]);
+            for (int i = 0; i < numSamples; i += frameLength)
+                analysis.decay.push_back(toDb(curve[(size_t) i]) - toDb(curve[0]));
+        }
+        return analysis;
+    }
+
+    // Mean absolute difference in dB over everything the reference has above its floor.
+    float distance (const Analysis& reference, const Analysis& candidate)
+    {
+        auto compare = [] (const std::vector<float>& ref, const std::vector<float>& other, float floor)
+        {
+            double sum = 0.0;
+            int count = 0;
+            for (size_t i = 0; i < juce::jmin(ref.size(), other.size()); ++i)
+            {
+                if (ref[i] < floor)
+                    continue;
+                sum += std::abs(ref[i] - juce::jmax(floor, other[i]));
+                ++count;
+            }
+            return count > 0 ? (float) (sum / count) : 0.0f;
+        };
+
+        return compare(reference.envelope, candidate.envelope, floorDb)
+             + compare(reference.bands, candidate.bands, floorDb)
+             + compare(reference.decay, candidate.decay, decayRangeDb);
+    }
+
+    // A point in the search space: every parameter mapped onto [0, 1] by its range.
+    struct Candidate
+    {
+        std::array<float, ReverbParameters::numParameters> position {};
+        float probeDistance { 0.0f };
+        float distance { std::numeric_limits<float>::max() };
+
+        ReverbParameters getParameters() const
+        {
+            ReverbParameters p;
+            for (int i = 0; i < ReverbParameters::numParameters; ++i)
+            {
+                auto& info = ReverbParameters::getInfo(i);
+                p[i] = info.minValue + position[(size_t) i] * (info.maxValue - info.minValue);
+            }
+            return p.clamped();
+        }
+
+        static Candidate from (const ReverbParameters& p)
+        {
+            Candidate c;
+            for (int i = 0; i < ReverbParameters::numParameters; ++i)
+            {
+                auto& info = ReverbParameters::getInfo(i);
+                c.position[(size_t) i] = (p[i] - info.minValue) / (info.maxValue - info.minValue);
+            }
+            return c;
+        }
+    };
+
+    // One round of renders: candidates [0, numCandidates) for numSamples each.
+    struct Job
+    {
+        std::vector<Candidate>* candidates { nullptr };
+        int numCandidates { 0 };
+        int numSamples { 0 };
+        const Analysis* reference { nullptr };
+        bool probe { true };
+        std::atomic<int> nextCandidate { 0 };
+    };
+
+    // Owns a processor and renders candidates from the current job until there are none
+    // left. Started again for every job.
+    class FitWorker  : public juce::Thread
+    {
+    public:
+        FitWorker (const juce::AudioChannelSet& layout, double rate, int engineIndex, int maxSamples)
+            : juce::Thread ("LLMEffects fit"), sampleRate (rate), engine (engineIndex),
+              output (layout.size(), maxSamples)
+        {
+            juce::AudioProcessor::BusesLayout buses;
+            buses.inputBuses.add(layout);
+            buses.outputBuses.add(layout);
+            processor.setBusesLayout(buses);
+            processor.setNonRealtime(true);
+            processor.setRateAndBufferSizeDetails(sampleRate, blockSize);
+        }
+
+        ~FitWorker() override { stopThread(-1); }
+
+        void start (Job& newJob)
+        {
+            job = &newJob;
+            startThread();
+        }
+
+        void run() override
+        {
+            for (int index = job->nextCandidate++; index < job->numCandidates && ! threadShouldExit(); index = job->nextCandidate++)
+            {
+                auto& candidate = (*job->candidates)[(size_t) index];
+                render(candidate.getParameters(), job->numSamples);
+                float d = distance(*job->reference, analyse(output, job->numSamples, sampleRate, ! job->probe));
+                (job->probe ? candidate.probeDistance : candidate.distance) = d;
+            }
+        }
+
+    private:
+        // Impulse in on every channel; the parameters go in before prepareToPlay so the
+        // delay memory is sized for them and the engine starts from silence.
+        void render (const ReverbParameters& parameters, int numSamples)
+        {
+            processor.setEngine(engine);
+            processor.applyParameters(parameters);
+            processor.prepareToPlay(sampleRate, blockSize);
+            for (int waited = 0; ! processor.isEngineReady() && waited < 10000; waited += 10)
+                juce::Thread::sleep(10);
+
+            output.clear();
+            for (int ch = 0; ch < output.getNumChannels(); ++ch)
+                output.setSample(ch, 0, 1.0f);
+
+            juce::MidiBuffer midi;
+            float* channels[2] = {};
+            for (int position = 0; position < numSamples; position += blockSize)
+            {
+                int n = juce::jmin(blockSize, numSamples - position);
+                for (int ch = 0; ch < output.getNumChannels(); ++ch)
+                    channels[ch] = output.getWritePointer(ch, position);
+                juce::AudioBuffer<float> block (channels, output.getNumChannels(), n);
+                processor.processBlock(block, midi);
+            }
+            processor.releaseResources();
+        }
+
+        const double sampleRate;
+        const int engine;
+        Job* job { nullptr };
+
+        // made here, on the main thread, like a host would
+        LLMEffectsAudioProcessor processor;
+        juce::AudioBuffer<float> output;
+    };
+
+    // Runs the job on every worker and waits for it to finish.
+    void runJob (std::vector<std::unique_ptr<FitWorker>>& workers, Job& job)
+    {
+        for (auto& worker : workers)
+            worker->start(job);
+        for (auto& worker : workers)
+            worker->waitForThreadToExit(-1);
+    }
+
+    float nextGaussian (juce::Random& random)
+    {
+        double u = juce::jmax(1.0e-12, random.nextDouble());
+        return (float) (std::sqrt(-2.0 * std::log(u)) * std::cos(juce::MathConstants<double>::twoPi * random.nextDouble()));
+    }
+
+    void printUsage()
+    {
+        std::cout << "LLMEffectsFit --reference=ir.wav [options]\n"
+                     "  --reference=FILE         impulse response to match (WAV/AIFF, mono or stereo)\n"
+                     "  --engine=NAME            legacy, fdn or convolution (default fdn)\n"
+                     "  --generations=N          search rounds (default 12)\n"
+                     "  --population=N          candidates probed per round (default 64)\n"
+                     "  --keep=N                 candidates per round rendered in full (default 8)\n"
+                     "  --probe=SECONDS          length of the probe renders (default 0.3)\n"
+                     "  --max-seconds=SECONDS    longest stretch of the reference compared (default 5)\n"
+                     "  --threads=N              worker threads (default: one per core)\n"
+                     "  --seed=N                 random seed, for repeatable runs (default 307)\n"
+                     "  --output=FILE.json       write the result there as well as printing it\n";
+    }
+}
+
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInit;
+    juce::ArgumentList args (argc, argv);
+
+    if (args.containsOption("--help|-h") || ! args.containsOption("--reference"))
+    {
+        printUsage();
+        return args.containsOption("--help|-h") ? 0 : 1;
+    }
+
+    auto referenceFile = args.getFileForOption("--reference");
+    juce::AudioFormatManager formats;
+    formats.registerBasicFormats();
+    std::unique_ptr<juce::AudioFormatReader> reader (formats.createReaderFor(referenceFile));
+    if (reader == nullptr || reader->lengthInSamples <= 0)
+    {
+        std::cerr << "Could not read " << referenceFile.getFullPathName() << "\n";
+        return 1;
+    }
+
+    juce::String engineName = args.containsOption("--engine") ? args.getValueForOption("--engine") : juce::String("fdn");
+    int engine = engineNames.indexOf(engineName);
+    if (engine < 0)
+    {
+        std::cerr << "Unknown engine: " << engineName << "\n";
+        return 1;
+    }
+
+    int generations = args.containsOption("--generations") ? args.getValueForOption("--generations").getIntValue() : 12;
+    int population  = args.containsOption("--population") ? args.getValueForOption("--population").getIntValue() : 64;
+    int keep        = args.containsOption("--keep") ? args.getValueForOption("--keep").getIntValue() : 8;
+    double probeSeconds = args.containsOption("--probe") ? args.getValueForOption("--probe").getDoubleValue() : 0.3;
+    double maxSeconds   = args.containsOption("--max-seconds") ? args.getValueForOption("--max-seconds").getDoubleValue() : 5.0;
+    if (generations <= 0 || population <= 0 || keep <= 0 || probeSeconds <= 0.0 || maxSeconds <= 0.0)
+    {
+        printUsage();
+        return 1;
+    }
+    keep = juce::jmin(keep, population);
+
+    // a mono reference is matched by a mono render, anything wider by the first two channels
+    double sampleRate = reader->sampleRate;
+    auto layout = reader->numChannels == 1 ? juce::AudioChannelSet::mono() : juce::AudioChannelSet::stereo();
+    int fullLength = (int) juce::jmin<juce::int64>(reader->lengthInSamples, (juce::int64) (maxSeconds * sampleRate));
+    int probeLength = juce::jlimit(1, fullLength, (int) (probeSeconds * sampleRate));
+
+    juce::AudioBuffer<float> reference (layout.size(), fullLength);
+    reader->read(&reference, 0, fullLength, 0, true, true);
+    auto referenceFull = analyse(reference, fullLength, sampleRate, true);
+    auto referenceProbe = analyse(reference, probeLength, sampleRate, false);
+
+    int numThreads = args.containsOption("--threads") ? args.getValueForOption("--threads").getIntValue()
+                                                      : juce::SystemStats::getNumCpus();
+    numThreads = juce::jlimit(1, population, numThreads);
+    std::vector<std::unique_ptr<FitWorker>> workers;
+    for (int i = 0; i < numThreads; ++i)
+        workers.push_back(std::make_unique<FitWorker>(layout, sampleRate, engine, fullLength));
+
+    std::cout << "fitting " << referenceFile.getFileName() << " (" << juce::String(fullLength / sampleRate, 2) << " s, "
+              << layout.size() << " channels) with the " << engineName << " engine on " << numThreads << " threads\n";
+
+    juce::Random random (args.containsOption("--seed") ? args.getValueForOption("--seed").getLargeIntValue() : 307);
+    std::vector<Candidate> best;   // fully rendered, closest first
+    float spread = 0.3f;
+    auto start = juce::Time::getMillisecondCounterHiRes();
+
+    for (int generation = 0; generation < generations; ++generation)
+    {
+        // the first round scatters candidates over the whole space (plus the defaults);
+        // later ones search around the best so far, more narrowly each time
+        std::vector<Candidate> candidates ((size_t) population);
+        for (int i = 0; i < population; ++i)
+        {
+            auto& c = candidates[(size_t) i];
+            if (best.empty())
+            {
+                if (i == 0)
+                    c = Candidate::from(ReverbParameters());
+                else
+                    for (auto& x : c.position)
+                        x = random.nextFloat();
+            }
+            else
+            {
+                c = best[(size_t) random.nextInt((int) best.size())];
+                for (auto& x : c.position)
+                    x = juce::jlimit(0.0f, 1.0f, x + spread * nextGaussian(random));
+                c.distance = std::numeric_limits<float>::max();
+            }
+        }
+
+        // cheap probes of the first few hundred milliseconds weed out most candidates;
+        // only the closest are rendered for the whole length of the reference
+        Job probes;
+        probes.candidates = &candidates;
+        probes.numCandidates = population;
+        probes.numSamples = probeLength;
+        probes.reference = &referenceProbe;
+        probes.probe = true;
+        runJob(workers, probes);
+
+        std::sort(candidates.begin(), candidates.end(), [] (const Candidate& a, const Candidate& b) { return a.probeDistance < b.probeDistance; });
+
+        Job full;
+        full.candidates = &candidates;
+        full.numCandidates = keep;
+        full.numSamples = fullLength;
+        full.reference = &referenceFull;
+        full.probe = false;
+        runJob(workers, full);
+
+        best.insert(best.end(), candidates.begin(), candidates.begin() + keep);
+        std::sort(best.begin(), best.end(), [] (const Candidate& a, const Candidate& b) { return a.distance < b.distance; });
+        best.resize(juce::jmin(best.size(), (size_t) keep));
+        spread *= 0.75f;
+
+        std::cout << "round " << juce::String(generation + 1).paddedLeft(' ', 3) << "   best " << juce::String(best.front().distance, 2) << " dB   "
+                  << juce::String((juce::Time::getMillisecondCounterHiRes() - start) / 1000.0, 1) << " s\n";
+    }
+
+    auto fitted = best.front().getParameters();
+    juce::DynamicObject::Ptr answer = new juce::DynamicObject();
+    answer->setProperty("parameters", fitted.toVar());
+    answer->setProperty("explanation", "Matched to " + referenceFile.getFileName() + " with the " + engineName + " engine ("
+                                          + juce::String(best.front().distance, 1) + " dB from it on average).");
+    auto json = juce::JSON::toString(juce::var(answer.get()));
+    std::cout << json << "\n";
+
+    if (args.containsOption("--output"))
+    {
+        auto outputFile = args.getFileForOption("--output");
+        if (! outputFile.replaceWithText(json))
+        {
+            std::cerr << "Could not write " << outputFile.getFullPathName() << "\n";
+            return 1;
+        }
+    }
+    return 0;
+}
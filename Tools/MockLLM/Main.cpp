@@ -0,0 +1,337 @@
+#include <JuceHeader.h>
+
+#include <atomic>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+// A stand-in for the chat-completions endpoint, for trying the plugin's LLM client
+// without a key or a network. It answers every request with a canned set of candidates
+// built from the prompt, streamed as server-sent events when the request asks for
+// "stream": true. Latency, streaming speed and rate-limit errors can be dialled in, and
+// every request is logged with its connection, so queueing, coalescing, retries and
+// connection reuse can be watched from the plugin's side. With --replay it plays back a
+// recorded event stream instead, as-is, so the streaming parser can be run offline against
+// exactly what a real endpoint sent. Point the plugin at it with
+// LLMEFFECTS_API_URL=http://127.0.0.1:<port>/v1/chat/completions.
+
+namespace
+{
+    struct Settings
+    {
+        int port { 8808 };
+        int latencyMs { 800 };
+        int chunkDelayMs { 20 };
+        int failEvery { 0 };      // answer every nth request with failStatus
+        int failStatus { 429 };
+        int numCandidates { 3 };
+        juce::StringArray replayEvents;   // a recorded stream, one event each, played back as-is
+    };
+
+    struct Stats
+    {
+        std::atomic<int> connections { 0 };
+        std::atomic<int> requests { 0 };
+        std::atomic<int> reused { 0 };    // requests after the first on a connection
+        std::atomic<int> active { 0 };
+    };
+
+    juce::CriticalSection logLock;
+
+    void log (const juce::String& line)
+    {
+        const juce::ScopedLock sl (logLock);
+        std::cout << juce::Time::getCurrentTime().toString(false, true, true, true) << "  " << line << std::endl;
+    }
+
+    // the user's prompt, out of the JSON payload the plugin sends as the last user
+    // message; any before it are earlier turns of the conversation
+    juce::String findPrompt (const juce::String& body)
+    {
+        auto messages = juce::JSON::parse(body).getProperty("messages", juce::var());
+        if (! messages.isArray())
+            return {};
+        for (int i = messages.size(); --i >= 0;)
+            if (messages[i].getProperty("role", juce::var()).toString() == "user")
+                return juce::JSON::parse(messages[i].getProperty("content", juce::var()).toString())
+                           .getProperty("userPrompt", juce::var()).toString();
+        return {};
+    }
+
+    // a few takes that differ enough to hear, in the format the plugin asks for
+    juce::String makeAnswer (const juce::String& prompt, int numCandidates)
+    {
+        const float decays[] = { 1.5f, 3.0f, 6.0f, 0.8f };
+        const float dampings[] = { 0.4f, 0.6f, 0.2f, 0.8f };
+
+        juce::Array<juce::var> candidates;
+        for (int i = 0; i < juce::jlimit(1, 4, numCandidates); ++i)
+        {
+            juce::DynamicObject::Ptr parameters = new juce::DynamicObject();
+            parameters->setProperty("decayTime", decays[i]);
+            parameters->setProperty("damping", dampings[i]);
+            parameters->setProperty("wetDryMix", 0.3f + 0.1f * (float) i);
+
+            juce::DynamicObject::Ptr candidate = new juce::DynamicObject();
+            candidate->setProperty("parameters", juce::var(parameters.get()));
+            candidate->setProperty("explanation", "Mock take " + juce::String::charToString((juce::juce_wchar) ('A' + i))
+                                                      + " on \"" + prompt + "\": decay " + juce::String(decays[i]) + " s.");
+            candidates.add(juce::var(candidate.get()));
+        }
+
+        juce::DynamicObject::Ptr answer = new juce::DynamicObject();
+        answer->setProperty("candidates", candidates);
+        return juce::JSON::toString(juce::var(answer.get()), true);
+    }
+
+    juce::String makeCompletion (const juce::String& content)
+    {
+        juce::DynamicObject::Ptr message = new juce::DynamicObject();
+        message->setProperty("role", "assistant");
+        message->setProperty("content", content);
+        juce::DynamicObject::Ptr choice = new juce::DynamicObject();
+        choice->setProperty("message", juce::var(message.get()));
+        juce::DynamicObject::Ptr completion = new juce::DynamicObject();
+        completion->setProperty("choices", juce::Array<juce::var> { juce::var(choice.get()) });
+        return juce::JSON::toString(juce::var(completion.get()), true);
+    }
+
+    juce::String makeDeltaEvent (const juce::String& text)
+    {
+        return "data: {\"choices\":[{\"delta\":{\"content\":" + juce::JSON::toString(text) + "}}]}\n\n";
+    }
+
+    // One client connection, served until it closes or asks to, so a client that keeps
+    // its connection alive shows up as several requests on the same connection.
+    class Connection  : public juce::Thread
+    {
+    public:
+        Connection (std::unique_ptr<juce::StreamingSocket> s, int connectionId, const Settings& st, Stats& sts)
+            : juce::Thread ("mock connection"), socket (std::move(s)), id (connectionId), settings (st), stats (sts) {}
+
+        ~Connection() override
+        {
+            socket->close();
+            stopThread(2000);
+        }
+
+        void run() override
+        {
+            for (int onConnection = 1; ! threadShouldExit(); ++onConnection)
+            {
+                juce::String head, body;
+                if (! readRequest(head, body))
+                    break;
+
+                int number = ++stats.requests;
+                if (onConnection > 1)
+                    ++stats.reused;
+                ++stats.active;
+                bool keepOpen = respond(head, body, number, onConnection);
+                --stats.active;
+                if (! keepOpen)
+                    break;
+            }
+            socket->close();
+        }
+
+    private:
+        bool readRequest (juce::String& head, juce::String& body)
+        {
+            juce::MemoryBlock received;
+            char buffer[4096];
+            int headerEnd = -1;
+
+            while (headerEnd < 0)
+            {
+                if (socket->waitUntilReady(true, 30000) != 1)
+                    return false;
+                int n = socket->read(buffer, sizeof(buffer), false);
+                if (n <= 0)
+                    return false;
+                received.append(buffer, (size_t) n);
+                headerEnd = received.toString().indexOf("\r\n\r\n");
+            }
+
+            auto text = received.toString();
+            head = text.substring(0, headerEnd);
+            int contentLength = 0;
+            for (auto& line : juce::StringArray::fromLines(head))
+                if (line.startsWithIgnoreCase("Content-Length:"))
+                    contentLength = line.fromFirstOccurrenceOf(":", false, false).trim().getIntValue();
+
+            // the body is UTF-8 bytes after the header, some of which may already be in
+            auto bytesBefore = (int) head.getNumBytesAsUTF8() + 4;
+            juce::MemoryBlock content (static_cast<const char*>(received.getData()) + bytesBefore, received.getSize() - (size_t) bytesBefore);
+            while ((int) content.getSize() < contentLength)
+            {
+                if (socket->waitUntilReady(true, 30000) != 1)
+                    return false;
+                int n = socket->read(buffer, juce::jmin((int) sizeof(buffer), contentLength - (int) content.getSize()), false);
+                if (n <= 0)
+                    return false;
+                content.append(buffer, (size_t) n);
+            }
+
+            body = content.toString();
+            return true;
+        }
+
+        bool write (const juce::String& text)
+        {
+            auto utf8 = text.toUTF8();
+            auto size = (int) text.getNumBytesAsUTF8();
+            return socket->write(utf8.getAddress(), size) == size;
+        }
+
+        // Returns whether the connection stays open for another request.
+        bool respond (const juce::String& head, const juce::String& body, int number, int onConnection)
+        {
+            bool clientKeepsAlive = ! head.containsIgnoreCase("Connection: close");
+            auto prefix = "request " + juce::String(number) + " on connection " + juce::String(id)
+                        + " (#" + juce::String(onConnection) + " on it, " + juce::String(stats.active.load()) + " active): ";
+
+            if (settings.failEvery > 0 && number % settings.failEvery == 0)
+            {
+                auto status = juce::String(settings.failStatus);
+                log(prefix + status);
+                return write("HTTP/1.1 " + status + " Mock Failure\r\nContent-Length: 0\r\n\r\n") && clientKeepsAlive;
+            }
+
+            juce::Thread::sleep(settings.latencyMs);
+            if (! settings.replayEvents.isEmpty())
+                return replay(prefix);
+
+            auto answer = makeAnswer(findPrompt(body), settings.numCandidates);
+            bool streamed = juce::JSON::parse(body).getProperty("stream", false);
+
+            if (! streamed)
+            {
+                auto completion = makeCompletion(answer);
+                log(prefix + "200, " + juce::String(completion.getNumBytesAsUTF8()) + " bytes");
+                return write("HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: "
+                             + juce::String(completion.getNumBytesAsUTF8()) + "\r\n\r\n" + completion)
+                       && clientKeepsAlive;
+            }
+
+            // an event stream has no length up front, so it ends with the connection
+            log(prefix + "200, streaming " + juce::String(answer.length()) + " characters");
+            if (! write("HTTP/1.1 200 OK\r\nContent-Type: text/event-stream\r\nConnection: close\r\n\r\n"))
+                return false;
+
+            for (int start = 0; start < answer.length() && ! threadShouldExit(); start += 8)
+            {
+                if (! write(makeDeltaEvent(answer.substring(start, start + 8))))
+                    return false;
+                juce::Thread::sleep(settings.chunkDelayMs);
+            }
+            write("data: [DONE]\n\n");
+            return false;
+        }
+
+        // the recorded stream goes out event by event whatever was asked for, [DONE] and
+        // all if the recording has it, since that is what a real endpoint would have sent
+        bool replay (const juce::String& prefix)
+        {
+            log(prefix + "200, replaying " + juce::String(settings.replayEvents.size()) + " events");
+            if (! write("HTTP/1.1 200 OK\r\nContent-Type: text/event-stream\r\nConnection: close\r\n\r\n"))
+                return false;
+
+            for (auto& event : settings.replayEvents)
+            {
+                if (threadShouldExit() || ! write(event + "\n\n"))
+                    return false;
+                juce::Thread::sleep(settings.chunkDelayMs);
+            }
+            return false;
+        }
+
+        std::unique_ptr<juce::StreamingSocket> socket;
+        const int id;
+        const Settings& settings;
+        Stats& stats;
+    };
+
+    void printUsage()
+    {
+        std::cout << "LLMEffectsMockLLM [options]\n"
+                     "  --port=N            port to listen on, on 127.0.0.1 (default 8808)\n"
+                     "  --latency=MS        delay before each answer starts (default 800)\n"
+                     "  --chunk-delay=MS    delay between streamed chunks (default 20)\n"
+                     "  --fail-every=N      answer every Nth request with an error (default never)\n"
+                     "  --fail-status=N     the HTTP status of those errors (default 429)\n"
+                     "  --candidates=N      takes per answer, 1 to 4 (default 3)\n"
+                     "  --replay=FILE       stream a recorded server-sent event capture instead\n";
+    }
+}
+
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInit;
+    juce::ArgumentList args (argc, argv);
+
+    if (args.containsOption("--help|-h"))
+    {
+        printUsage();
+        return 0;
+    }
+
+    Settings settings;
+    auto intOption = [&args](const char* option, int fallback)
+    {
+        return args.containsOption(option) ? args.getValueForOption(option).getIntValue() : fallback;
+    };
+    settings.port = intOption("--port", settings.port);
+    settings.latencyMs = juce::jmax(0, intOption("--latency", settings.latencyMs));
+    settings.chunkDelayMs = juce::jmax(0, intOption("--chunk-delay", settings.chunkDelayMs));
+    settings.failEvery = juce::jmax(0, intOption("--fail-every", settings.failEvery));
+    settings.failStatus = juce::jlimit(400, 599, intOption("--fail-status", settings.failStatus));
+    settings.numCandidates = juce::jlimit(1, 4, intOption("--candidates", settings.numCandidates));
+
+    if (args.containsOption("--replay"))
+    {
+        auto file = juce::File::getCurrentWorkingDirectory().getChildFile(args.getValueForOption("--replay"));
+        // events are separated by a blank line; captures saved on Windows come with CRLFs
+        auto recording = file.loadFileAsString().replace("\r\n", "\n");
+        while (recording.isNotEmpty())
+        {
+            auto event = recording.upToFirstOccurrenceOf("\n\n", false, false).trim();
+            recording = recording.fromFirstOccurrenceOf("\n\n", false, false);
+            if (event.isNotEmpty())
+                settings.replayEvents.add(event);
+        }
+        if (settings.replayEvents.isEmpty())
+        {
+            std::cerr << "No events in " << file.getFullPathName() << "\n";
+            return 1;
+        }
+    }
+
+    juce::StreamingSocket listener;
+    if (! listener.createListener(settings.port, "127.0.0.1"))
+    {
+        std::cerr << "Could not listen on port " << settings.port << "\n";
+        return 1;
+    }
+
+    std::cout << "Listening on http://127.0.0.1:" << settings.port << "/v1/chat/completions\n"
+              << "Set LLMEFFECTS_API_URL to that and LLMEFFECTS_API_KEY to anything.\n";
+
+    Stats stats;
+    std::vector<std::unique_ptr<Connection>> connections;
+
+    while (auto* socket = listener.waitForNextConnection())
+    {
+        connections.erase(std::remove_if(connections.begin(), connections.end(),
+                                         [](const std::unique_ptr<Connection>& c) { return ! c->isThreadRunning(); }),
+                          connections.end());
+
+        int id = ++stats.connections;
+        connections.push_back(std::make_unique<Connection>(std::unique_ptr<juce::StreamingSocket>(socket), id, settings, stats));
+        connections.back()->startThread();
+        log("connection " + juce::String(id) + " opened; " + juce::String(stats.requests.load()) + " requests so far, "
+            + juce::String(stats.reused.load()) + " of them on a reused connection");
+    }
+
+    return 0;
+}